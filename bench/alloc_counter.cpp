@@ -0,0 +1,92 @@
+/**
+ * Process-wide allocation counters for the host-native benchmark
+ *
+ * Also feeds the firmware's per-site counters (heap_telemetry.h), which
+ * the device gets from its --wrap'ed allocator.
+ */
+
+#include "alloc_counter.h"
+#include "heap_telemetry.h"
+#include <atomic>
+#include <new>
+#include <stdlib.h>
+
+static std::atomic<uint64_t> allocationCount(0);
+static std::atomic<uint64_t> freeCount(0);
+static std::atomic<uint64_t> allocatedBytes(0);
+
+static inline void countAlloc(size_t size) {
+  allocationCount.fetch_add(1, std::memory_order_relaxed);
+  allocatedBytes.fetch_add(size, std::memory_order_relaxed);
+  allocTrackerAlloc(size);
+}
+
+static inline void countFree(void* ptr) {
+  if (ptr) {
+    freeCount.fetch_add(1, std::memory_order_relaxed);
+    allocTrackerFree();
+  }
+}
+
+AllocCounts allocSnapshot() {
+  AllocCounts counts;
+  counts.allocations = allocationCount.load(std::memory_order_relaxed);
+  counts.frees = freeCount.load(std::memory_order_relaxed);
+  counts.bytes = allocatedBytes.load(std::memory_order_relaxed);
+  return counts;
+}
+
+#if defined(__GLIBC__)
+
+// Interpose the C allocator; libstdc++'s operator new goes through malloc
+extern "C" {
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t count, size_t size);
+void* __libc_realloc(void* ptr, size_t size);
+void __libc_free(void* ptr);
+
+void* malloc(size_t size) {
+  countAlloc(size);
+  return __libc_malloc(size);
+}
+
+void* calloc(size_t count, size_t size) {
+  countAlloc(count * size);
+  return __libc_calloc(count, size);
+}
+
+void* realloc(void* ptr, size_t size) {
+  // Growing a buffer is still heap churn, count it as an allocation
+  countAlloc(size);
+  return __libc_realloc(ptr, size);
+}
+
+void free(void* ptr) {
+  countFree(ptr);
+  __libc_free(ptr);
+}
+}
+
+#else
+
+void* operator new(size_t size) {
+  countAlloc(size);
+  void* ptr = malloc(size ? size : 1);
+  if (!ptr) throw std::bad_alloc();
+  return ptr;
+}
+
+void* operator new[](size_t size) {
+  return operator new(size);
+}
+
+void operator delete(void* ptr) noexcept {
+  countFree(ptr);
+  free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept {
+  operator delete(ptr);
+}
+
+#endif
@@ -0,0 +1,23 @@
+/**
+ * Heap allocation counting for the host-native benchmark
+ *
+ * On glibc the benchmark interposes malloc/calloc/realloc/free, which
+ * also covers operator new and Arduino String. Elsewhere only C++
+ * operator new/delete are counted.
+ */
+
+#ifndef ALLOC_COUNTER_H
+#define ALLOC_COUNTER_H
+
+#include <stdint.h>
+
+struct AllocCounts {
+  uint64_t allocations;   // malloc/calloc/realloc(NULL)/new calls
+  uint64_t frees;         // free/delete calls with a non-null pointer
+  uint64_t bytes;         // Bytes requested
+};
+
+// Snapshot of the process-wide counters
+AllocCounts allocSnapshot();
+
+#endif // ALLOC_COUNTER_H
@@ -0,0 +1,196 @@
+/**
+ * Stored animations: round trip, file size and playback cost
+ *
+ * Procedural patterns are recorded into animation files in memory, then
+ * played back through the streaming player and compared frame by frame.
+ * Decoding a frame must stay within ANIMATION_DECODE_BUDGET_NS; the
+ * procedural render cost is printed next to it for scale.
+ */
+
+#include "bench.h"
+#include "animation.h"
+#include "patterns.h"
+#include "pixel_layout.h"
+#include <string.h>
+
+// Host p50 for one played frame: 1/10000 of an ANIMATION_TICK, so the
+// device has two orders of magnitude of headroom before decoding takes
+// 1% of a frame interval
+#define ANIMATION_DECODE_BUDGET_NS  1000
+
+static volatile uint32_t sink;
+
+// In-memory file, counting reads like a flash file would see them
+class MemoryAnimationSource : public AnimationSource {
+public:
+  std::vector<uint8_t> bytes;
+  size_t position = 0;
+
+  bool seek(uint32_t to) override {
+    position = to;
+    return to <= bytes.size();
+  }
+
+  size_t read(uint8_t* buffer, size_t size) override {
+    size_t count = bytes.size() - position < size ? bytes.size() - position : size;
+    memcpy(buffer, bytes.data() + position, count);
+    position += count;
+    return count;
+  }
+};
+
+// Record `frames` frames of a pattern; reference gets them in strip order
+static void recordPattern(uint8_t index, uint32_t frames, uint16_t keyframeInterval,
+                          MemoryAnimationSource& file, std::vector<Frame>* reference) {
+  Pattern& pattern = getPattern(index);
+  Frame frame = {};
+  pattern.reset();
+
+  AnimationHeader header = { ANIMATION_LOOP, pattern.frameInterval, keyframeInterval, frames };
+  file.bytes.assign(ANIMATION_HEADER_SIZE, 0);
+  writeAnimationHeader(header, file.bytes.data());
+
+  uint32_t previous[NUM_PIXELS] = {};
+  uint32_t cells[NUM_PIXELS];
+  uint8_t record[ANIMATION_MAX_RECORD];
+  for (uint32_t f = 0; f < frames; f++) {
+    pattern.render(frame);
+    for (uint8_t row = 0; row < GRID_HEIGHT; row++) {
+      for (uint8_t col = 0; col < GRID_WIDTH; col++) {
+        cells[row * GRID_WIDTH + col] = color8(frame.pixel[pixelLayout().pixelAt[col][row]]);
+      }
+    }
+    bool keyframe = f == 0 || (keyframeInterval != 0 && f % keyframeInterval == 0);
+    size_t length = encodeAnimationFrame(previous, cells, keyframe, record);
+    file.bytes.insert(file.bytes.end(), record, record + length);
+    memcpy(previous, cells, sizeof(cells));
+    if (reference != nullptr) {
+      // What playback can give back: the frame rounded to 8 bits
+      Frame recorded = frame;
+      for (uint16_t i = 0; i < NUM_PIXELS; i++) {
+        recorded.pixel[i] = color16(color8(frame.pixel[i]));
+      }
+      reference->push_back(recorded);
+    }
+  }
+}
+
+static int verifyAnimation() {
+  int failures = 0;
+  const uint8_t patterns[] = { PATTERN_RAINBOW, PATTERN_WAVE, PATTERN_FIRE, PATTERN_MATRIX, PATTERN_PULSE };
+
+  // Every frame decodes to what the pattern rendered, and a looping
+  // animation starts over at its first frame
+  for (uint8_t index : patterns) {
+    MemoryAnimationSource file;
+    std::vector<Frame> reference;
+    recordPattern(index, 300, index == PATTERN_WAVE ? 50 : 0, file, &reference);
+
+    AnimationPlayer player;
+    Frame frame = {};
+    uint32_t mismatches = 0;
+    if (!player.open(&file)) {
+      printf("%s animation did not open\n", getPatternName(index));
+      failures++;
+      continue;
+    }
+    for (uint32_t f = 0; f < reference.size() + 1; f++) {
+      if (!player.nextFrame(frame) ||
+          memcmp(&frame, &reference[f % reference.size()], sizeof(frame)) != 0) {
+        mismatches++;
+      }
+    }
+    if (mismatches != 0 || player.bytesRead > 2 * file.bytes.size()) {
+      printf("%s animation: %u of %u frames wrong, %u bytes read for a %u byte file\n",
+             getPatternName(index), mismatches, (unsigned)reference.size() + 1,
+             player.bytesRead, (unsigned)file.bytes.size());
+      failures++;
+    }
+  }
+
+  // Damaged files are rejected instead of drawing garbage
+  MemoryAnimationSource file;
+  recordPattern(PATTERN_WAVE, 10, 0, file, nullptr);
+  AnimationPlayer player;
+  Frame frame = {};
+  file.bytes[5] = GRID_WIDTH + 1;
+  bool wrongGrid = player.open(&file);
+  file.bytes[5] = GRID_WIDTH;
+  file.bytes.resize(file.bytes.size() - 5);
+  bool truncatedPlays = player.open(&file);
+  uint32_t played = 0;
+  while (played < 20 && player.nextFrame(frame)) {
+    played++;
+  }
+  if (wrongGrid || !truncatedPlays || played != 9 || player.isOpen()) {
+    printf("damaged animation files were not rejected\n");
+    failures++;
+  }
+
+  // One minute of each pattern, and how much of it fits in 1 MB of flash
+  printf("one minute recorded (bytes, bytes/frame, minutes per MB):\n");
+  for (uint8_t index : patterns) {
+    MemoryAnimationSource minute;
+    uint32_t frames = 60000 / getPattern(index).frameInterval;
+    recordPattern(index, frames, 0, minute, nullptr);
+    printf("  %-10s %7u %6.1f %7.1f\n", getPatternName(index), (unsigned)minute.bytes.size(),
+           (double)(minute.bytes.size() - ANIMATION_HEADER_SIZE) / frames,
+           1048576.0 / minute.bytes.size());
+  }
+  printf("  (raw RGB: %u bytes/frame; player buffer %u bytes)\n", NUM_PIXELS * 3,
+         (unsigned)sizeof(AnimationPlayer));
+
+  printf("stored animations: %s\n", failures == 0 ? "ok" : "FAILED");
+  return failures;
+}
+
+int runAnimationBench(const BenchOptions& options) {
+  printf("\n");
+  int failures = verifyAnimation();
+
+  benchPrintHeader("stored animation vs procedural (ns/frame)");
+  static const struct {
+    uint8_t pattern;
+    const char* procedural;
+    const char* played;
+  } cases[] = {
+    { PATTERN_RAINBOW, "Rainbow procedural", "Rainbow played" },
+    { PATTERN_WAVE, "Wave procedural", "Wave played" },
+    { PATTERN_FIRE, "Fire procedural", "Fire played" },
+    { PATTERN_PULSE, "Pulse procedural", "Pulse played" },
+  };
+  // Playing a recording has to fit the decode budget
+  for (const auto& c : cases) {
+    static Frame frame;
+    Pattern& pattern = getPattern(c.pattern);
+    BenchResult procedural = {}, played = {};
+    if (benchSelected(options, c.procedural)) {
+      frame.clear();
+      pattern.reset();
+      procedural = benchRun(c.procedural, options, [&pattern]() {
+        pattern.render(frame);
+        sink = frame.pixel[0].r;
+      });
+      benchPrintResult(procedural);
+    }
+    if (benchSelected(options, c.played)) {
+      static MemoryAnimationSource file;
+      static AnimationPlayer player;
+      recordPattern(c.pattern, 1000, 0, file, nullptr);
+      player.open(&file);
+      frame.clear();
+      played = benchRun(c.played, options, []() {
+        player.nextFrame(frame);
+        sink = frame.pixel[0].r;
+      });
+      benchPrintResult(played);
+    }
+    if (played.iterations > 0 && played.p50Ns > ANIMATION_DECODE_BUDGET_NS) {
+      printf("%s: p50 %u ns, over the %u ns budget\n", c.played, (unsigned)played.p50Ns,
+             (unsigned)ANIMATION_DECODE_BUDGET_NS);
+      failures++;
+    }
+  }
+
+  return failures;
+}
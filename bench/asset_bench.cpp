@@ -0,0 +1,87 @@
+/**
+ * Static assets: ETag derivation and If-None-Match matching
+ */
+
+#include "bench.h"
+#include "static_assets.h"
+#include <string.h>
+#include <string>
+
+static volatile uint32_t sink;
+
+static int verifyAssets() {
+  int failures = 0;
+  static const uint8_t page[] = "<html>lithophane</html>";
+  char etag[ASSET_ETAG_SIZE];
+  char chunked[ASSET_ETAG_SIZE];
+
+  // Whole-buffer and chunked hashing agree, and the tag is quoted
+  makeAssetETag(page, sizeof(page), etag);
+  uint32_t hash = assetHashUpdate(ASSET_HASH_INIT, page, 10);
+  hash = assetHashUpdate(hash, page + 10, sizeof(page) - 10);
+  formatAssetETag(hash, sizeof(page), chunked);
+  if (strcmp(etag, chunked) != 0 || etag[0] != '"' || etag[strlen(etag) - 1] != '"') {
+    printf("ETag %s vs chunked %s\n", etag, chunked);
+    failures++;
+  }
+
+  // One changed byte gives a different tag
+  uint8_t edited[sizeof(page)];
+  memcpy(edited, page, sizeof(page));
+  edited[6] ^= 1;
+  char editedTag[ASSET_ETAG_SIZE];
+  makeAssetETag(edited, sizeof(edited), editedTag);
+  if (strcmp(etag, editedTag) == 0) {
+    printf("edited asset kept its ETag\n");
+    failures++;
+  }
+
+  std::string weak = "W/" + std::string(etag);
+  std::string list = "\"other\", " + std::string(etag) + " ";
+  const struct {
+    const char* header;
+    bool match;
+  } cases[] = {
+    { etag, true }, { weak.c_str(), true }, { list.c_str(), true }, { "*", true },
+    { editedTag, false }, { "", false }, { "\"other\"", false },
+  };
+  for (const auto& c : cases) {
+    if (etagMatches(c.header, etag) != c.match) {
+      printf("If-None-Match \"%s\" should %smatch\n", c.header, c.match ? "" : "not ");
+      failures++;
+    }
+  }
+
+  if (findStaticAsset("/") == nullptr || findStaticAsset("/missing") != nullptr) {
+    printf("asset lookup failed\n");
+    failures++;
+  }
+
+  printf("static assets: %s\n", failures == 0 ? "ok" : "FAILED");
+  return failures;
+}
+
+int runAssetBench(const BenchOptions& options) {
+  printf("\n");
+  int failures = verifyAssets();
+
+  static char etag[ASSET_ETAG_SIZE];
+  static uint8_t page[5000]; // About the size of the gzipped index.html
+  makeAssetETag(page, sizeof(page), etag);
+
+  benchPrintHeader("static assets (ns/request)");
+  if (benchSelected(options, "If-None-Match check")) {
+    benchPrintResult(benchRun("If-None-Match check", options, []() {
+      sink = etagMatches(etag, etag);
+    }));
+  }
+  if (benchSelected(options, "ETag of 5 KB asset")) {
+    benchPrintResult(benchRun("ETag of 5 KB asset", options, []() {
+      char tag[ASSET_ETAG_SIZE];
+      makeAssetETag(page, sizeof(page), tag);
+      sink = tag[1];
+    }));
+  }
+
+  return failures;
+}
@@ -0,0 +1,98 @@
+/**
+ * Host-native benchmark harness
+ *
+ * Each suite times a callable per iteration and reports ns/iteration
+ * (mean, min, p50, p99, max) plus heap allocations per iteration.
+ */
+
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <chrono>
+#include <vector>
+#include "alloc_counter.h"
+
+struct BenchOptions {
+  uint32_t iterations = 5000;   // Timed iterations per case
+  uint32_t warmup = 200;        // Untimed iterations before measuring
+  const char* filter = nullptr; // Only run cases whose name contains this
+  uint32_t clients = 8;         // Concurrent HTTP clients in the load test
+};
+
+struct BenchResult {
+  const char* name;
+  uint32_t iterations;
+  double meanNs;
+  uint64_t minNs;
+  uint64_t p50Ns;
+  uint64_t p99Ns;
+  uint64_t maxNs;
+  double allocsPerIteration;
+  double bytesPerIteration;
+};
+
+// Returns true when a case should run under the current --filter
+bool benchSelected(const BenchOptions& options, const char* name);
+
+// Print the table header / one result row
+void benchPrintHeader(const char* suite);
+void benchPrintResult(const BenchResult& result);
+
+// Fill in the timing fields of a result from raw per-iteration samples
+BenchResult benchSummarize(const char* name, std::vector<uint64_t>& samples);
+
+// Time fn() once per iteration; allocations are counted only inside fn()
+template <typename Fn>
+BenchResult benchRun(const char* name, const BenchOptions& options, Fn fn) {
+  for (uint32_t i = 0; i < options.warmup; i++) {
+    fn();
+  }
+
+  std::vector<uint64_t> samples;
+  samples.reserve(options.iterations);
+  uint64_t allocations = 0;
+  uint64_t bytes = 0;
+
+  for (uint32_t i = 0; i < options.iterations; i++) {
+    AllocCounts before = allocSnapshot();
+    auto start = std::chrono::steady_clock::now();
+    fn();
+    auto end = std::chrono::steady_clock::now();
+    AllocCounts after = allocSnapshot();
+
+    samples.push_back((uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count());
+    allocations += after.allocations - before.allocations;
+    bytes += after.bytes - before.bytes;
+  }
+
+  BenchResult result = benchSummarize(name, samples);
+  result.allocsPerIteration = options.iterations ? (double)allocations / options.iterations : 0;
+  result.bytesPerIteration = options.iterations ? (double)bytes / options.iterations : 0;
+  return result;
+}
+
+// Suites
+int runPatternBench(const BenchOptions& options);
+int runColorBench(const BenchOptions& options);
+int runLayoutBench(const BenchOptions& options);
+int runCommandBench(const BenchOptions& options);
+int runProtocolBench(const BenchOptions& options);
+int runStatusBench(const BenchOptions& options);
+int runPreferenceBench(const BenchOptions& options);
+int runAssetBench(const BenchOptions& options);
+int runPreviewBench(const BenchOptions& options);
+int runDdpBench(const BenchOptions& options);
+int runAnimationBench(const BenchOptions& options);
+int runLogBench(const BenchOptions& options);
+int runMetricsBench(const BenchOptions& options);
+int runHeapBench(const BenchOptions& options);
+int runLoopBench(const BenchOptions& options);
+int runTransitionBench(const BenchOptions& options);
+int runPackedPixelBench(const BenchOptions& options);
+int runDitherBench(const BenchOptions& options);
+int runRandomBench(const BenchOptions& options);
+int runLoadBench(const BenchOptions& options);
+
+#endif // BENCH_H
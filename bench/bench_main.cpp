@@ -0,0 +1,100 @@
+/**
+ * Host-native benchmark entry point
+ *
+ * Build and run with: pio run -e native -t exec
+ * Or pass options:    .pio/build/native/program --iterations 10000 --filter Wave
+ *                     .pio/build/native/program --filter async --clients 16
+ */
+
+#include "bench.h"
+#include <algorithm>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+bool benchSelected(const BenchOptions& options, const char* name) {
+  return options.filter == nullptr || strstr(name, options.filter) != nullptr;
+}
+
+BenchResult benchSummarize(const char* name, std::vector<uint64_t>& samples) {
+  BenchResult result = {};
+  result.name = name;
+  result.iterations = samples.size();
+  if (samples.empty()) {
+    return result;
+  }
+
+  std::sort(samples.begin(), samples.end());
+  uint64_t total = 0;
+  for (uint64_t sample : samples) {
+    total += sample;
+  }
+
+  result.meanNs = (double)total / samples.size();
+  result.minNs = samples.front();
+  result.p50Ns = samples[(samples.size() - 1) / 2];
+  result.p99Ns = samples[((samples.size() - 1) * 99) / 100];
+  result.maxNs = samples.back();
+  return result;
+}
+
+void benchPrintHeader(const char* suite) {
+  printf("\n== %s ==\n", suite);
+  printf("%-24s %8s %10s %9s %9s %9s %9s %8s %9s\n",
+         "case", "iters", "mean ns", "min ns", "p50 ns", "p99 ns", "max ns", "allocs", "bytes");
+}
+
+void benchPrintResult(const BenchResult& result) {
+  printf("%-24s %8u %10.1f %9llu %9llu %9llu %9llu %8.2f %9.1f\n",
+         result.name, result.iterations, result.meanNs,
+         (unsigned long long)result.minNs, (unsigned long long)result.p50Ns,
+         (unsigned long long)result.p99Ns, (unsigned long long)result.maxNs,
+         result.allocsPerIteration, result.bytesPerIteration);
+}
+
+static void printUsage(const char* program) {
+  printf("Usage: %s [--iterations N] [--warmup N] [--filter NAME] [--clients N]\n", program);
+}
+
+int main(int argc, char** argv) {
+  BenchOptions options;
+
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--iterations") == 0 && i + 1 < argc) {
+      options.iterations = strtoul(argv[++i], NULL, 10);
+    } else if (strcmp(argv[i], "--warmup") == 0 && i + 1 < argc) {
+      options.warmup = strtoul(argv[++i], NULL, 10);
+    } else if (strcmp(argv[i], "--filter") == 0 && i + 1 < argc) {
+      options.filter = argv[++i];
+    } else if (strcmp(argv[i], "--clients") == 0 && i + 1 < argc) {
+      options.clients = strtoul(argv[++i], NULL, 10);
+    } else {
+      printUsage(argv[0]);
+      return 2;
+    }
+  }
+
+  int failures = 0;
+  failures += runPatternBench(options);
+  failures += runColorBench(options);
+  failures += runLayoutBench(options);
+  failures += runCommandBench(options);
+  failures += runProtocolBench(options);
+  failures += runStatusBench(options);
+  failures += runPreferenceBench(options);
+  failures += runAssetBench(options);
+  failures += runPreviewBench(options);
+  failures += runDdpBench(options);
+  failures += runAnimationBench(options);
+  failures += runLogBench(options);
+  failures += runMetricsBench(options);
+  failures += runHeapBench(options);
+  failures += runLoopBench(options);
+  failures += runTransitionBench(options);
+  failures += runPackedPixelBench(options);
+  failures += runDitherBench(options);
+  failures += runRandomBench(options);
+  failures += runLoadBench(options);
+
+  return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,127 @@
+/**
+ * Color engine accuracy and throughput
+ *
+ * Checks the integer color engine against the Adafruit_NeoPixel math and
+ * the original floating-point wave formula, then compares per-frame cost
+ * of the library path with the table-driven one.
+ */
+
+#include "bench.h"
+#include "patterns.h"
+#include "color_engine.h"
+#include "reference_patterns.h"
+#include <math.h>
+
+static volatile uint32_t sink;
+
+static int verifyColorHSV() {
+  static const uint8_t saturations[] = {0, 100, 200, 230, 255};
+  uint32_t checked = 0;
+  uint32_t mismatches = 0;
+
+  for (uint8_t sat : saturations) {
+    for (uint32_t hue = 0; hue < 65536; hue += 7) {
+      for (uint32_t val = 0; val < 256; val++) {
+        uint32_t expected = Adafruit_NeoPixel::ColorHSV(hue, sat, val);
+        if (colorHSV(hue, sat, val) != expected ||
+            colorHSVGamma(hue, sat, val) != Adafruit_NeoPixel::gamma32(expected)) {
+          mismatches++;
+        }
+        checked++;
+      }
+    }
+  }
+
+  printf("colorHSV/colorHSVGamma vs library: %u checked, %u mismatches\n", checked, mismatches);
+  return mismatches == 0 ? 0 : 1;
+}
+
+static int verifySine() {
+  double maxError = 0;
+  for (uint32_t angle = 0; angle < 65536; angle++) {
+    double expected = sin(angle * TWO_PI / 65536.0);
+    double error = fabs(isin16(angle) / (double)SIN_ONE - expected);
+    if (error > maxError) {
+      maxError = error;
+    }
+  }
+
+  printf("isin16 vs sin(): max error %.6f\n", maxError);
+  return maxError < 0.0005 ? 0 : 1;
+}
+
+static int verifyWave() {
+  Adafruit_NeoPixel reference(NUM_PIXELS, 10, NEO_GRB + NEO_KHZ800);
+  uint32_t maxDelta = 0;
+  uint32_t differingPixels = 0;
+  uint32_t frames = 3600; // One full period of the row sine
+
+  Pattern& wave = getPattern(PATTERN_WAVE);
+  Frame output = {};
+
+  wave.reset();
+  for (uint32_t frame = 0; frame < frames; frame++) {
+    referenceWaveFrame(reference, frame);
+    wave.render(output);
+
+    for (uint16_t i = 0; i < NUM_PIXELS; i++) {
+      uint32_t a = reference.getPixelColor(i);
+      uint32_t b = color8(output.pixel[i]);
+      if (a != b) {
+        differingPixels++;
+      }
+      for (int shift = 0; shift <= 16; shift += 8) {
+        uint32_t delta = abs((int)((a >> shift) & 0xFF) - (int)((b >> shift) & 0xFF));
+        maxDelta = max(maxDelta, delta);
+      }
+    }
+  }
+
+  printf("Wave vs float reference: %u frames, %u pixels differ, max channel delta %u\n",
+         frames, differingPixels, maxDelta);
+  // One step of the 8-bit value is at most 3 steps after gamma 2.6
+  return maxDelta <= 3 ? 0 : 1;
+}
+
+int runColorBench(const BenchOptions& options) {
+  printf("\n");
+  int failures = verifyColorHSV() + verifySine() + verifyWave();
+
+  benchPrintHeader("color engine (ns per 60-pixel frame)");
+
+  uint16_t hue = 0;
+  if (benchSelected(options, "ColorHSV+gamma32")) {
+    benchPrintResult(benchRun("ColorHSV+gamma32", options, [&]() {
+      for (int i = 0; i < NUM_PIXELS; i++) {
+        sink = Adafruit_NeoPixel::gamma32(Adafruit_NeoPixel::ColorHSV(hue += 997, 255, 200));
+      }
+    }));
+  }
+  if (benchSelected(options, "colorHSVGamma")) {
+    benchPrintResult(benchRun("colorHSVGamma", options, [&]() {
+      for (int i = 0; i < NUM_PIXELS; i++) {
+        sink = colorHSVGamma(hue += 997, 255, 200);
+      }
+    }));
+  }
+
+  uint16_t step = 0;
+  if (benchSelected(options, "sin() float")) {
+    benchPrintResult(benchRun("sin() float", options, [&]() {
+      for (int i = 0; i < NUM_PIXELS; i++) {
+        float wave = sin((i * 0.5 + step++ * 0.1) * PI / 180.0);
+        sink = (uint8_t)(200 + wave * 55);
+      }
+    }));
+  }
+  if (benchSelected(options, "isin16")) {
+    benchPrintResult(benchRun("isin16", options, [&]() {
+      for (int i = 0; i < NUM_PIXELS; i++) {
+        int32_t wave = isin16(decidegreesToAngle(i * 5 + step++));
+        sink = (200 * SIN_ONE + wave * 55) / SIN_ONE;
+      }
+    }));
+  }
+
+  return failures;
+}
@@ -0,0 +1,140 @@
+/**
+ * Render command queue: ordering, frame-boundary semantics and cost
+ */
+
+#include "bench.h"
+#include "patterns.h"
+#include "pixel_layout.h"
+#include "render_commands.h"
+#include <thread>
+
+static volatile uint32_t sink;
+
+// Commands only take effect when the render side drains the queue
+static int verifyFrameBoundary() {
+  int failures = 0;
+
+  patternEngine.select(PATTERN_WAVE);
+  processRenderCommands();
+  uint32_t applied = renderCommandsApplied.load();
+
+  renderCommands.push({RENDER_SET_COLOR, 0x123456});
+  renderCommands.push({RENDER_SET_BRIGHTNESS, 99});
+  renderCommands.push({RENDER_SET_LAYOUT, LAYOUT_ROW_MAJOR});
+  if (patternEngine.currentIndex() != PATTERN_WAVE || staticColor == 0x123456 ||
+      frameOutput.getBrightness() == 99 || pixelLayout().type == LAYOUT_ROW_MAJOR) {
+    printf("commands took effect before the frame boundary\n");
+    failures++;
+  }
+
+  if (processRenderCommands() != 3 || renderCommandsApplied.load() - applied != 3 ||
+      patternEngine.currentIndex() != PATTERN_STATIC || staticColor != 0x123456 ||
+      frameOutput.getBrightness() != 99 || pixelLayout().type != LAYOUT_ROW_MAJOR) {
+    printf("queued commands were not applied\n");
+    failures++;
+  }
+
+  // Color keeps Spiral running, next wraps around the registry
+  renderCommands.push({RENDER_SELECT_PATTERN, PATTERN_SPIRAL});
+  renderCommands.push({RENDER_SET_COLOR, 0x00FF00});
+  processRenderCommands();
+  if (patternEngine.currentIndex() != PATTERN_SPIRAL) {
+    printf("color command left Spiral\n");
+    failures++;
+  }
+  renderCommands.push({RENDER_SELECT_PATTERN, PATTERN_COUNT - 1});
+  renderCommands.push({RENDER_NEXT_PATTERN, 0});
+  processRenderCommands();
+  if (patternEngine.currentIndex() != 0) {
+    printf("next did not wrap to the first pattern\n");
+    failures++;
+  }
+
+  // A full queue rejects commands instead of blocking the producer
+  uint32_t accepted = 0;
+  for (uint32_t i = 0; i < RENDER_QUEUE_SIZE + 4; i++) {
+    accepted += renderCommands.push({RENDER_SET_BRIGHTNESS, 64}) ? 1 : 0;
+  }
+  processRenderCommands();
+  if (accepted != RENDER_QUEUE_SIZE || !renderCommands.empty()) {
+    printf("full queue accepted %u of %u commands\n", accepted, RENDER_QUEUE_SIZE + 4);
+    failures++;
+  }
+
+  selectPixelLayout(LAYOUT_COLUMN_SERPENTINE);
+  staticColor = 0xFF0000;
+  frameOutput.setBrightness(64);
+  return failures;
+}
+
+// One producer and one consumer thread, every value must arrive in order
+static int verifyConcurrentQueue() {
+  static SpscQueue<uint32_t, 64> queue;
+  const uint32_t count = 2000000;
+  uint32_t outOfOrder = 0;
+
+  std::thread producer([&]() {
+    for (uint32_t i = 0; i < count; i++) {
+      while (!queue.push(i)) {
+        std::this_thread::yield();
+      }
+    }
+  });
+
+  uint32_t expected = 0;
+  while (expected < count) {
+    uint32_t value;
+    if (queue.pop(value)) {
+      if (value != expected) {
+        outOfOrder++;
+      }
+      expected++;
+    } else {
+      std::this_thread::yield();
+    }
+  }
+  producer.join();
+
+  printf("SPSC queue across threads: %u values, %u out of order\n", count, outOfOrder);
+  return outOfOrder == 0 ? 0 : 1;
+}
+
+// space() is how many pushes will succeed (the /color route queues two
+// commands or none)
+static int verifyQueueSpace() {
+  SpscQueue<uint32_t, 4> queue;
+  uint32_t value;
+  bool ok = queue.space() == 4;
+  for (uint32_t i = 0; i < 4; i++) {
+    ok = ok && queue.push(i);
+  }
+  ok = ok && queue.space() == 0 && !queue.push(4) && queue.pop(value) && queue.space() == 1;
+  if (!ok) {
+    printf("SPSC queue space() does not match push()\n");
+  }
+  return ok ? 0 : 1;
+}
+
+int runCommandBench(const BenchOptions& options) {
+  printf("\n");
+  int failures = verifyFrameBoundary() + verifyConcurrentQueue() + verifyQueueSpace();
+  printf("render commands: %s\n", failures == 0 ? "ok" : "FAILED");
+
+  benchPrintHeader("render commands (ns/op)");
+  if (benchSelected(options, "push+pop")) {
+    benchPrintResult(benchRun("push+pop", options, []() {
+      RenderCommand command = {RENDER_SET_BRIGHTNESS, 64};
+      renderCommands.push(command);
+      renderCommands.pop(command);
+      sink = command.value;
+    }));
+  }
+  if (benchSelected(options, "apply brightness")) {
+    benchPrintResult(benchRun("apply brightness", options, []() {
+      renderCommands.push({RENDER_SET_BRIGHTNESS, 64});
+      sink = processRenderCommands();
+    }));
+  }
+
+  return failures;
+}
@@ -0,0 +1,229 @@
+/**
+ * DDP receiver: a localhost sender drives the socket and jitter buffer
+ */
+
+#include "bench.h"
+#include "ddp_receiver.h"
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <string.h>
+
+static volatile uint32_t sink;
+
+// UDP socket sending DDP packets to the receiver on 127.0.0.1
+struct DdpSender {
+  int fd = -1;
+  struct sockaddr_in target = {};
+
+  bool open(uint16_t port) {
+    fd = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    target.sin_family = AF_INET;
+    target.sin_port = htons(port);
+    target.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    return fd >= 0;
+  }
+
+  void close() {
+    ::close(fd);
+  }
+
+  void send(const void* data, size_t length) {
+    sendto(fd, data, length, 0, (struct sockaddr*)&target, sizeof(target));
+  }
+
+  // One packet of a frame whose pixel i is color(seed, i)
+  void sendPixels(uint8_t sequence, uint32_t seed, uint16_t offset, uint16_t length, bool push) {
+    uint8_t packet[DDP_HEADER_SIZE + DDP_FRAME_BYTES];
+    DdpHeader header = { (uint8_t)(DDP_FLAG_VERSION_1 | (push ? DDP_FLAG_PUSH : 0)), sequence, offset, length };
+    writeDdpHeader(header, packet);
+    for (uint16_t i = 0; i < length; i++) {
+      uint16_t byte = offset + i;
+      packet[DDP_HEADER_SIZE + i] = (uint8_t)(seed * 7 + byte);
+    }
+    send(packet, DDP_HEADER_SIZE + length);
+  }
+
+  void sendFrame(uint8_t sequence, uint32_t seed) {
+    sendPixels(sequence, seed, 0, DDP_FRAME_BYTES, true);
+  }
+};
+
+// Pixel i as sent by sendPixels()
+static uint32_t sentColor(uint32_t seed, uint16_t pixel) {
+  uint8_t r = seed * 7 + pixel * 3;
+  uint8_t g = seed * 7 + pixel * 3 + 1;
+  uint8_t b = seed * 7 + pixel * 3 + 2;
+  return ((uint32_t)r << 16) | ((uint32_t)g << 8) | b;
+}
+
+static bool frameIs(const Frame& frame, uint32_t seed, uint16_t first = 0, uint16_t last = NUM_PIXELS) {
+  for (uint16_t i = first; i < last; i++) {
+    if (color8(frame.pixel[i]) != sentColor(seed, i)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static int verifyReceiver() {
+  int failures = 0;
+  DdpReceiver receiver;
+  DdpSender sender;
+  if (!receiver.begin(0) || !sender.open(receiver.localPort())) {
+    printf("could not open localhost UDP sockets\n");
+    return 1;
+  }
+  Frame frame = {};
+
+  // Held for the jitter delay, then shown
+  sender.sendFrame(1, 1);
+  receiver.poll(0);
+  bool early = receiver.play(DDP_JITTER_DELAY_MS - 1, frame);
+  if (early || !receiver.play(DDP_JITTER_DELAY_MS, frame) || !frameIs(frame, 1)) {
+    printf("first frame not held for %u ms and shown\n", DDP_JITTER_DELAY_MS);
+    failures++;
+  }
+
+  // Reordered frames come out in sequence; repeats and stale ones are dropped
+  sender.sendFrame(3, 3);
+  sender.sendFrame(2, 2);
+  sender.sendFrame(3, 3);
+  receiver.poll(100);
+  bool second = receiver.play(200, frame) && frameIs(frame, 2);
+  bool third = receiver.play(200, frame) && frameIs(frame, 3);
+  sender.sendFrame(2, 2);
+  sender.sendFrame(3, 3);
+  receiver.poll(210);
+  if (!second || !third || receiver.play(300, frame) || receiver.stats.duplicates != 2 ||
+      receiver.stats.late != 1 || receiver.stats.lost != 0) {
+    printf("reordering failed: duplicates %u, late %u, lost %u\n", receiver.stats.duplicates,
+           receiver.stats.late, receiver.stats.lost);
+    failures++;
+  }
+
+  // A skipped sequence number counts as lost; numbers wrap from 15 to 1
+  sender.sendFrame(5, 5);
+  receiver.poll(300);
+  receiver.play(400, frame);
+  for (uint8_t sequence = 6; sequence <= 15; sequence++) {
+    sender.sendFrame(sequence, sequence);
+    receiver.poll(400 + sequence * 30);
+    receiver.play(400 + sequence * 30 + DDP_JITTER_DELAY_MS, frame);
+  }
+  sender.sendFrame(1, 16);
+  receiver.poll(1000);
+  if (!receiver.play(1000 + DDP_JITTER_DELAY_MS, frame) || !frameIs(frame, 16) ||
+      receiver.stats.lost != 1 || receiver.stats.late != 1) {
+    printf("sequence gap or wrap failed: lost %u, late %u\n", receiver.stats.lost, receiver.stats.late);
+    failures++;
+  }
+
+  // A frame in two packets; then one that only updates pixels 10-11
+  sender.sendPixels(2, 20, 0, DDP_FRAME_BYTES / 2, false);
+  sender.sendPixels(2, 20, DDP_FRAME_BYTES / 2, DDP_FRAME_BYTES / 2, true);
+  sender.sendPixels(3, 21, 30, 6, true);
+  receiver.poll(1100);
+  bool whole = receiver.play(1200, frame) && frameIs(frame, 20);
+  bool partial = receiver.play(1200, frame) && frameIs(frame, 21, 10, 12) &&
+                 frameIs(frame, 20, 0, 10) && frameIs(frame, 20, 12, NUM_PIXELS);
+  if (!whole || !partial) {
+    printf("multi-packet or partial frame failed\n");
+    failures++;
+  }
+
+  // Not DDP, or writing past the frame
+  sender.send("hello", 5);
+  sender.sendPixels(4, 4, DDP_FRAME_BYTES - 3, 6, true);
+  receiver.poll(1300);
+  if (receiver.stats.invalid != 2) {
+    printf("invalid packets: %u, expected 2\n", receiver.stats.invalid);
+    failures++;
+  }
+
+  // A burst bigger than the buffer drops the oldest and plays the rest
+  // without waiting for the delay
+  for (uint8_t sequence = 4; sequence < 4 + DDP_JITTER_SLOTS + 2; sequence++) {
+    sender.sendFrame(sequence, sequence);
+  }
+  receiver.poll(1400);
+  uint32_t burst = 0;
+  while (receiver.play(1400, frame)) {
+    burst++;
+  }
+  if (receiver.stats.overflows != 2 || burst != 2 || !frameIs(frame, 7)) {
+    printf("burst: %u overflows, %u frames played at once\n", receiver.stats.overflows, burst);
+    failures++;
+  }
+
+  // The PUSH of frame 10 is lost: its slot is freed once frame 11 plays,
+  // not kept until the sequence number comes round again
+  receiver.play(1500, frame);
+  receiver.play(1500, frame);
+  sender.sendPixels(10, 10, 0, DDP_FRAME_BYTES / 2, false);
+  sender.sendFrame(11, 11);
+  sender.sendFrame(12, 12);
+  receiver.poll(1600);
+  bool skipped = receiver.play(1700, frame) && frameIs(frame, 11);
+  skipped = skipped && receiver.play(1700, frame) && frameIs(frame, 12);
+  if (!skipped || receiver.stats.incomplete != 1) {
+    printf("lost PUSH: %u incomplete frames dropped\n", receiver.stats.incomplete);
+    failures++;
+  }
+
+  // With the buffer full, a frame still waiting for its PUSH is dropped
+  // before any complete one
+  sender.sendPixels(13, 13, 0, DDP_FRAME_BYTES / 2, false);
+  for (uint8_t sequence = 14; sequence < 14 + DDP_JITTER_SLOTS; sequence++) {
+    sender.sendFrame(sequence > 15 ? sequence - 15 : sequence, sequence);
+  }
+  receiver.poll(1800);
+  burst = 0;
+  while (receiver.play(1800, frame)) {
+    burst++;
+  }
+  if (receiver.stats.overflows != 3 || burst != 2 || !frameIs(frame, 15)) {
+    printf("full buffer with a lost PUSH: %u overflows, %u frames played at once\n",
+           receiver.stats.overflows, burst);
+    failures++;
+  }
+
+  const DdpStats& stats = receiver.stats;
+  printf("DDP over localhost: %u packets, %u frames, %u played, %u late, %u duplicates, "
+         "%u overflows, %u lost, %u incomplete, %u invalid\n", stats.packets, stats.frames,
+         stats.played, stats.late, stats.duplicates, stats.overflows, stats.lost, stats.incomplete,
+         stats.invalid);
+
+  sender.close();
+  receiver.end();
+  return failures;
+}
+
+int runDdpBench(const BenchOptions& options) {
+  printf("\n");
+  int failures = verifyReceiver();
+  printf("DDP receiver: %s\n", failures == 0 ? "ok" : "FAILED");
+
+  benchPrintHeader("DDP receiver (ns/frame)");
+  if (benchSelected(options, "send+poll+play")) {
+    static DdpReceiver receiver;
+    static DdpSender sender;
+    static Frame frame;
+    static uint32_t now = 0;
+    static uint8_t sequence = 0;
+    if (receiver.begin(0) && sender.open(receiver.localPort())) {
+      benchPrintResult(benchRun("send+poll+play", options, []() {
+        sequence = sequence % 15 + 1;
+        sender.sendFrame(sequence, sequence);
+        receiver.poll(now);
+        now += DDP_JITTER_DELAY_MS;
+        sink = receiver.play(now, frame);
+      }));
+      sender.close();
+      receiver.end();
+    }
+  }
+
+  return failures;
+}
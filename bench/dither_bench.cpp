@@ -0,0 +1,128 @@
+/**
+ * Dithered output: what the LEDs average over time against the 16-bit
+ * frame, banding at low brightness, and the cost of the output pass
+ * against the Pulse frame budget
+ */
+
+#include "bench.h"
+#include "patterns.h"
+#include <math.h>
+#include <stdio.h>
+
+#define DITHER_FRAMES     256   // Frames averaged per check
+#define DITHER_BRIGHTNESS 64    // The firmware default
+
+static Adafruit_NeoPixel ditherStrip(NUM_PIXELS, 10, NEO_GRB + NEO_KHZ800);
+
+// Present the same frame `frames` times; sums of each LED channel
+static void presentFrames(FrameOutput& output, const Frame& frame, uint32_t frames,
+                          uint32_t (&sums)[NUM_PIXELS][3]) {
+  memset(sums, 0, sizeof(sums));
+  for (uint32_t f = 0; f < frames; f++) {
+    output.invalidate();
+    output.present(frame);
+    for (uint16_t i = 0; i < NUM_PIXELS; i++) {
+      uint32_t color = ditherStrip.getPixelColor(i);
+      sums[i][0] += (color >> 16) & 0xFF;
+      sums[i][1] += (color >> 8) & 0xFF;
+      sums[i][2] += color & 0xFF;
+    }
+  }
+}
+
+static int verifyDither() {
+  int failures = 0;
+  static uint32_t sums[NUM_PIXELS][3];
+  FrameOutput output(ditherStrip);
+
+  // 8-bit colors at full brightness come out exactly, every frame
+  Frame frame;
+  for (uint16_t i = 0; i < NUM_PIXELS; i++) {
+    frame.pixel[i] = color16(0x010203 * i + 0x7F0080);
+  }
+  output.setBrightness(255);
+  presentFrames(output, frame, DITHER_FRAMES, sums);
+  for (uint16_t i = 0; i < NUM_PIXELS; i++) {
+    uint32_t color = color8(frame.pixel[i]);
+    if (sums[i][0] != ((color >> 16) & 0xFF) * DITHER_FRAMES ||
+        sums[i][1] != ((color >> 8) & 0xFF) * DITHER_FRAMES ||
+        sums[i][2] != (color & 0xFF) * DITHER_FRAMES) {
+      printf("8-bit color 0x%06X dithered at full brightness\n", color);
+      failures++;
+      break;
+    }
+  }
+
+  // A dim ramp at the default brightness: the average over time matches
+  // the exact scaled level, where truncating to 8 bits first loses it
+  for (uint16_t i = 0; i < NUM_PIXELS; i++) {
+    uint16_t value = i * (COLOR16_ONE / 4) / (NUM_PIXELS - 1);
+    frame.pixel[i] = { value, (uint16_t)(value / 3), (uint16_t)(value / 7) };
+  }
+  output.setBrightness(DITHER_BRIGHTNESS);
+  presentFrames(output, frame, DITHER_FRAMES, sums);
+  double maxError = 0;
+  uint16_t dithered = 0, truncated = 0;
+  uint32_t lastSum = UINT32_MAX, lastTruncated = UINT32_MAX;
+  for (uint16_t i = 0; i < NUM_PIXELS; i++) {
+    for (uint8_t c = 0; c < 3; c++) {
+      uint16_t value = c == 0 ? frame.pixel[i].r : c == 1 ? frame.pixel[i].g : frame.pixel[i].b;
+      double exact = value / 257.0 * (DITHER_BRIGHTNESS + 1) / 256;
+      double error = fabs((double)sums[i][c] / DITHER_FRAMES - exact);
+      maxError = error > maxError ? error : maxError;
+    }
+    // Distinct steps of the red ramp, dithered and as the 8-bit path
+    // ((value >> 8) scaled by brightness + 1) would show them
+    uint32_t level = (channel8(frame.pixel[i].r) * (DITHER_BRIGHTNESS + 1)) >> 8;
+    dithered += sums[i][0] != lastSum;
+    truncated += level != lastTruncated;
+    lastSum = sums[i][0];
+    lastTruncated = level;
+  }
+  printf("dim ramp at brightness %u: %u distinct levels dithered, %u in 8 bits, "
+         "max average error %.4f of an LED step\n",
+         DITHER_BRIGHTNESS, dithered, truncated, maxError);
+  if (maxError > 1.0 / 64 || dithered <= truncated) {
+    failures++;
+  }
+
+  // An unchanged frame is not pushed again
+  uint32_t pushed = output.framesPushed;
+  output.present(frame);
+  if (output.framesPushed != pushed) {
+    printf("an unchanged frame was dithered again\n");
+    failures++;
+  }
+
+  printf("dithered output: %s\n", failures == 0 ? "ok" : "FAILED");
+  return failures;
+}
+
+int runDitherBench(const BenchOptions& options) {
+  printf("\n");
+  ditherStrip.begin();
+  int failures = verifyDither();
+
+  benchPrintHeader("dithered output (ns/frame)");
+  if (benchSelected(options, "output pass")) {
+    // A Wave frame at the default brightness, pushed every time
+    static FrameOutput output(ditherStrip);
+    static Frame frame;
+    output.setBrightness(DITHER_BRIGHTNESS);
+    getPattern(PATTERN_WAVE).reset();
+    getPattern(PATTERN_WAVE).render(frame);
+    BenchResult result = benchRun("output pass", options, []() {
+      output.invalidate();
+      output.present(frame);
+    });
+    benchPrintResult(result);
+    double share = result.p99Ns / (getPattern(PATTERN_PULSE).frameInterval * 1e6);
+    printf("output pass p99: %.4f%% of the %u ms Pulse frame budget\n", share * 100,
+           getPattern(PATTERN_PULSE).frameInterval);
+    if (share >= 1) {
+      failures++;
+    }
+  }
+
+  return failures;
+}
@@ -0,0 +1,141 @@
+/**
+ * Heap telemetry: per-site attribution, heap history, and a render loop
+ * that must not allocate
+ */
+
+#include "bench.h"
+#include "heap_telemetry.h"
+#include "patterns.h"
+#include <stdlib.h>
+#include <atomic>
+#include <thread>
+
+static volatile uint32_t sink;
+
+// Through a volatile pointer so the compiler cannot drop malloc/free pairs
+static void* (*volatile allocate)(size_t) = malloc;
+static void (*volatile release)(void*) = free;
+
+static AllocSite outerSite("bench outer");
+static AllocSite innerSite("bench inner");
+
+static int verifyAttribution() {
+  int failures = 0;
+  std::atomic<int> step{0};
+  std::thread other([&step]() {
+    while (step.load() == 0) {
+    }
+    release(allocate(64));
+    step = 2;
+  });
+  uint32_t otherBefore = unattributedAllocs.allocations;
+
+  {
+    AllocScope outer(outerSite);
+    release(allocate(100));
+    {
+      AllocScope inner(innerSite);
+      release(allocate(20));
+      release(allocate(30));
+    }
+    release(allocate(5));
+
+    // Another task's allocations are not counted against this scope
+    step = 1;
+    while (step.load() != 2) {
+    }
+  }
+  release(allocate(1));
+  other.join();
+
+  if (outerSite.allocations != 2 || outerSite.bytes != 105 || outerSite.frees != 2 ||
+      innerSite.allocations != 2 || innerSite.bytes != 50 || innerSite.entries != 1 ||
+      unattributedAllocs.allocations - otherBefore < 2) {
+    printf("allocation sites: outer %u allocs %u bytes, inner %u allocs %u bytes\n",
+           outerSite.allocations, outerSite.bytes, innerSite.allocations, innerSite.bytes);
+    failures++;
+  }
+
+  bool listed = false;
+  for (AllocSite* site = firstAllocSite(); site != nullptr; site = site->nextSite) {
+    listed = listed || site == &outerSite;
+  }
+  if (!listed) {
+    printf("allocation site not registered\n");
+    failures++;
+  }
+  return failures;
+}
+
+static int verifyHistory() {
+  HeapHistory history;
+  uint32_t now = 0;
+  for (uint32_t i = 0; i < HEAP_HISTORY_SAMPLES + 5; i++) {
+    if (history.due(now)) {
+      // Free heap shrinks and splits: 20% fragmented at sample 10
+      uint32_t freeBytes = 200000 - i * 1000;
+      history.add({ now, freeBytes, i == 10 ? freeBytes * 4 / 5 : freeBytes - 100 });
+    }
+    now += HEAP_SAMPLE_INTERVAL;
+  }
+  bool wrong = history.size() != HEAP_HISTORY_SAMPLES || history.at(0).millis != 5 * HEAP_SAMPLE_INTERVAL ||
+               history.maxFragmentation != 20 || history.minFreeBytes != 200000 - 64 * 1000 ||
+               history.due(now - HEAP_SAMPLE_INTERVAL + 1) || !history.due(now);
+  if (wrong) {
+    printf("heap history: %u samples, oldest at %u ms, max fragmentation %u%%\n", history.size(),
+           history.at(0).millis, history.maxFragmentation);
+    return 1;
+  }
+  return 0;
+}
+
+// Once a pattern is running, rendering and presenting must not touch
+// the heap (every allocation is a fragmentation risk on the device)
+static int verifyRenderAllocations() {
+  int failures = 0;
+  uint32_t total = 0;
+  for (uint8_t i = 0; i < PATTERN_COUNT; i++) {
+    patternEngine.select(i);
+    uint32_t now = 0;
+    for (uint32_t frame = 0; frame < 50; frame++) {
+      patternEngine.requestFrame();
+      patternEngine.update(now += 10);
+    }
+    uint32_t before = renderAllocs.allocations;
+    for (uint32_t frame = 0; frame < 500; frame++) {
+      patternEngine.requestFrame();
+      patternEngine.update(now += 10);
+    }
+    uint32_t allocations = renderAllocs.allocations - before;
+    total += allocations;
+    if (allocations != 0) {
+      printf("%s allocated %u times in 500 steady-state frames\n", getPatternName(i), allocations);
+      failures++;
+    }
+  }
+  patternEngine.select(PATTERN_WAVE);
+  printf("steady-state rendering: %u patterns x 500 frames, %u allocations\n", PATTERN_COUNT, total);
+  return failures;
+}
+
+int runHeapBench(const BenchOptions& options) {
+  printf("\n");
+  int failures = verifyAttribution() + verifyHistory() + verifyRenderAllocations();
+  printf("heap telemetry: %s\n", failures == 0 ? "ok" : "FAILED");
+
+  benchPrintHeader("heap telemetry (ns/op)");
+  if (benchSelected(options, "AllocScope")) {
+    benchPrintResult(benchRun("AllocScope", options, []() {
+      AllocScope scope(outerSite);
+      sink = outerSite.entries;
+    }));
+  }
+  if (benchSelected(options, "malloc+free in scope")) {
+    benchPrintResult(benchRun("malloc+free in scope", options, []() {
+      AllocScope scope(innerSite);
+      release(allocate(32));
+    }));
+  }
+
+  return failures;
+}
@@ -0,0 +1,135 @@
+/**
+ * Pixel layout tables: consistency checks and lookup cost
+ */
+
+#include "bench.h"
+#include "pixel_layout.h"
+#include <string.h>
+#include <string>
+
+static volatile uint32_t sink;
+
+// Serpentine mapping as previously computed per call in patterns.cpp
+static uint16_t legacyPixelIndex(uint8_t col, uint8_t row) {
+  if (col >= GRID_WIDTH || row >= GRID_HEIGHT) return 0;
+  if (col % 2 == 0) {
+    return col * GRID_HEIGHT + row;
+  } else {
+    return col * GRID_HEIGHT + (GRID_HEIGHT - 1 - row);
+  }
+}
+
+// Both tables must agree and cover every strip index once
+static bool layoutConsistent(const PixelLayout& layout) {
+  bool seen[NUM_PIXELS] = {};
+  for (uint8_t col = 0; col < GRID_WIDTH; col++) {
+    for (uint8_t row = 0; row < GRID_HEIGHT; row++) {
+      uint16_t pixel = layout.pixelAt[col][row];
+      if (pixel >= NUM_PIXELS || seen[pixel] || layout.cellPixel[row * GRID_WIDTH + col] != pixel) {
+        return false;
+      }
+      seen[pixel] = true;
+    }
+  }
+  return true;
+}
+
+static int verifyLayouts() {
+  int failures = 0;
+
+  selectPixelLayout(LAYOUT_COLUMN_SERPENTINE);
+  for (uint8_t col = 0; col < GRID_WIDTH; col++) {
+    for (uint8_t row = 0; row < GRID_HEIGHT; row++) {
+      if (pixelLayout().pixelAt[col][row] != legacyPixelIndex(col, row)) {
+        failures++;
+      }
+    }
+  }
+
+  for (uint8_t type = 0; type < LAYOUT_CUSTOM; type++) {
+    selectPixelLayout((PixelLayoutType)type);
+    if (!layoutConsistent(pixelLayout())) {
+      printf("layout %s is inconsistent\n", getLayoutName(type));
+      failures++;
+    }
+  }
+
+  // A custom map written out from row-major must load back identically
+  selectPixelLayout(LAYOUT_ROW_MAJOR);
+  PixelLayout rowMajor = pixelLayout();
+  std::string text = "# row-major test map\n";
+  for (uint8_t row = 0; row < GRID_HEIGHT; row++) {
+    for (uint8_t col = 0; col < GRID_WIDTH; col++) {
+      text += std::to_string(rowMajor.pixelAt[col][row]) + (col + 1 < GRID_WIDTH ? ", " : "\n");
+    }
+  }
+  selectPixelLayout(LAYOUT_COLUMN_SERPENTINE);
+  if (!parsePixelLayout(text.data(), text.size()) || pixelLayout().type != LAYOUT_COLUMN_SERPENTINE ||
+      !selectPixelLayout(LAYOUT_CUSTOM) || pixelLayout().type != LAYOUT_CUSTOM ||
+      memcmp(pixelLayout().pixelAt, rowMajor.pixelAt, sizeof(rowMajor.pixelAt)) != 0 ||
+      !layoutConsistent(pixelLayout())) {
+    printf("custom layout round trip failed\n");
+    failures++;
+  }
+
+  // Loading another map while a custom one is active leaves the active
+  // table alone until it is selected
+  std::string reversed = "# reversed test map\n";
+  for (uint16_t cell = 0; cell < NUM_PIXELS; cell++) {
+    reversed += std::to_string(NUM_PIXELS - 1 - cell) + " ";
+  }
+  const PixelLayout* active = &pixelLayout();
+  if (!parsePixelLayout(reversed.data(), reversed.size()) || &pixelLayout() != active ||
+      memcmp(pixelLayout().pixelAt, rowMajor.pixelAt, sizeof(rowMajor.pixelAt)) != 0 ||
+      !selectPixelLayout(LAYOUT_CUSTOM) || pixelLayout().cellPixel[0] != NUM_PIXELS - 1 ||
+      !parsePixelLayout(text.data(), text.size())) {
+    printf("loading a custom map changed the active one\n");
+    failures++;
+  }
+
+  // Duplicates, missing cells and junk are rejected without touching the loaded map
+  static const char* const badMaps[] = {"0 0", "0 1 2", "x", "60"};
+  for (const char* bad : badMaps) {
+    selectPixelLayout(LAYOUT_COLUMN_SERPENTINE);
+    if (parsePixelLayout(bad, strlen(bad)) || !selectPixelLayout(LAYOUT_CUSTOM) ||
+        memcmp(pixelLayout().pixelAt, rowMajor.pixelAt, sizeof(rowMajor.pixelAt)) != 0) {
+      printf("bad layout map \"%s\" was accepted\n", bad);
+      failures++;
+    }
+  }
+
+  selectPixelLayout(LAYOUT_COLUMN_SERPENTINE);
+  printf("pixel layouts: %s\n", failures == 0 ? "ok" : "FAILED");
+  return failures;
+}
+
+int runLayoutBench(const BenchOptions& options) {
+  printf("\n");
+  int failures = verifyLayouts();
+
+  benchPrintHeader("pixel layout (ns per 60-cell pass)");
+  if (benchSelected(options, "legacy getPixelIndex")) {
+    benchPrintResult(benchRun("legacy getPixelIndex", options, []() {
+      uint32_t sum = 0;
+      for (uint8_t col = 0; col < GRID_WIDTH; col++) {
+        for (uint8_t row = 0; row < GRID_HEIGHT; row++) {
+          sum += legacyPixelIndex(col, row);
+        }
+      }
+      sink = sum;
+    }));
+  }
+  if (benchSelected(options, "pixelAt table")) {
+    benchPrintResult(benchRun("pixelAt table", options, []() {
+      uint32_t sum = 0;
+      for (uint8_t col = 0; col < GRID_WIDTH; col++) {
+        for (uint8_t row = 0; row < GRID_HEIGHT; row++) {
+          sum += pixelLayout().pixelAt[col][row];
+        }
+      }
+      sink = sum;
+    }));
+  }
+
+  return failures;
+}
@@ -0,0 +1,319 @@
+/**
+ * HTTP load: request latency and frame jitter with N concurrent clients
+ *
+ * Replays the firmware's threading on the host: a render thread runs the
+ * real pattern engine, a loop thread moves HTTP commands to the render
+ * queue, and a server thread answers N clients. Each client asks for a
+ * page, the status or a setting, waits for the response and thinks for a
+ * while. A response goes out in TCP segments; each costs some CPU and
+ * then waits a WiFi round trip for the client's ACK.
+ *
+ * The blocking server (WebServer) serves one request at a time and waits
+ * for every ACK. The async server (ESPAsyncWebServer) sends the next
+ * segment when the ACK arrives and serves the other clients meanwhile.
+ * On Linux everything is pinned to one CPU like the single-core C3.
+ */
+
+#include "bench.h"
+#include "patterns.h"
+#include "render_commands.h"
+#include "spsc_queue.h"
+#include "ws_protocol.h"
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <stdio.h>
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+#define LOAD_DURATION_MS      1000  // Per server model
+#define LOAD_THINK_US         20000 // Client pause between requests
+#define LOAD_RTT_US           3000  // SoftAP round trip per segment
+#define LOAD_SEGMENT_CPU_US   60    // Copying one segment into the stack
+#define LOAD_LOOP_PERIOD_MS   10    // Loop task delay()
+
+typedef std::chrono::steady_clock Clock;
+
+struct LoadRequest {
+  const char* uri;
+  uint8_t segments;     // 1460-byte TCP segments in the response
+  uint8_t opcode;       // Command forwarded to the loop, or WS_OP_INVALID
+  uint32_t value;
+};
+
+// Each client walks this list; "/" is the gzipped page from RAM
+static const LoadRequest loadRequests[] = {
+  { "/", 4, WS_OP_INVALID, 0 },
+  { "/status", 1, WS_OP_INVALID, 0 },
+  { "/brightness", 1, WS_OP_BRIGHTNESS, 80 },
+  { "/wave", 1, WS_OP_SELECT_PATTERN, PATTERN_WAVE },
+  { "/color", 1, WS_OP_COLOR, 0x00FF00 },
+};
+static const uint8_t loadRequestCount = sizeof(loadRequests) / sizeof(loadRequests[0]);
+
+struct LoadClient {
+  uint64_t requestAt;   // When the current request arrived (us)
+  uint64_t nextEventAt; // Next request or ACK (us)
+  uint8_t request;      // Index into loadRequests
+  uint8_t segmentsLeft; // 0 while thinking
+};
+
+struct LoadStats {
+  std::vector<uint64_t> latencyNs;
+  std::vector<uint64_t> jitterNs;
+  uint32_t commandsIssued = 0;
+  uint32_t httpDropped = 0;
+  uint32_t renderPosted = 0;
+  uint32_t renderDropped = 0;
+  uint32_t renderApplied = 0;
+};
+
+static SpscQueue<WsCommand, 16> httpQueue;
+static Clock::time_point loadStart;
+
+// Stand-in for the render task notification (xTaskNotifyGive)
+static std::mutex renderMutex;
+static std::condition_variable renderWake;
+static uint64_t renderNotifiedAt = 0;   // First post since the last wake (us), 0 = none
+
+static uint64_t loadMicros() {
+  return (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - loadStart).count();
+}
+
+static void sleepUntilMicros(uint64_t at) {
+  std::this_thread::sleep_until(loadStart + std::chrono::microseconds(at));
+}
+
+static void spinMicros(uint32_t us) {
+  uint64_t end = loadMicros() + us;
+  while (loadMicros() < end) {
+  }
+}
+
+// Request parsed: forward its command like the route handlers do
+static void startRequest(LoadClient& client, LoadStats& stats) {
+  const LoadRequest& request = loadRequests[client.request];
+  client.segmentsLeft = request.segments;
+  if (request.opcode != WS_OP_INVALID) {
+    stats.commandsIssued++;
+    if (!httpQueue.push({request.opcode, request.value})) {
+      stats.httpDropped++;
+    }
+  }
+}
+
+static void finishRequest(LoadClient& client, LoadStats& stats, uint64_t now) {
+  stats.latencyNs.push_back((now - client.requestAt) * 1000);
+  client.request = (client.request + 1) % loadRequestCount;
+  client.segmentsLeft = 0;
+  client.requestAt = now + LOAD_THINK_US;
+  client.nextEventAt = client.requestAt;
+}
+
+// WebServer: one request at a time, every write waits for its ACK
+static void serveBlocking(std::vector<LoadClient>& clients, LoadStats& stats, uint64_t end) {
+  while (loadMicros() < end) {
+    LoadClient* next = &clients[0];
+    for (LoadClient& client : clients) {
+      if (client.requestAt < next->requestAt) {
+        next = &client;
+      }
+    }
+    sleepUntilMicros(next->requestAt);
+
+    startRequest(*next, stats);
+    while (next->segmentsLeft > 0) {
+      spinMicros(LOAD_SEGMENT_CPU_US);
+      sleepUntilMicros(loadMicros() + LOAD_RTT_US);
+      next->segmentsLeft--;
+    }
+    finishRequest(*next, stats, loadMicros());
+  }
+}
+
+// ESPAsyncWebServer: react to whichever request or ACK comes next
+static void serveAsync(std::vector<LoadClient>& clients, LoadStats& stats, uint64_t end) {
+  while (loadMicros() < end) {
+    LoadClient* next = &clients[0];
+    for (LoadClient& client : clients) {
+      if (client.nextEventAt < next->nextEventAt) {
+        next = &client;
+      }
+    }
+    sleepUntilMicros(next->nextEventAt);
+
+    if (next->segmentsLeft == 0) {
+      startRequest(*next, stats);
+    } else if (--next->segmentsLeft == 0) {
+      finishRequest(*next, stats, loadMicros());
+      continue;
+    }
+    spinMicros(LOAD_SEGMENT_CPU_US);
+    next->nextEventAt = loadMicros() + LOAD_RTT_US;
+  }
+}
+
+// The loop task's share: HTTP commands to the render queue
+static bool postLoadCommand(const WsCommand& command, LoadStats& stats) {
+  RenderCommand render = { RENDER_SELECT_PATTERN, command.value };
+  if (command.opcode == WS_OP_COLOR) {
+    render.type = RENDER_SET_COLOR;
+  } else if (command.opcode == WS_OP_BRIGHTNESS) {
+    render.type = RENDER_SET_BRIGHTNESS;
+  }
+  if (!renderCommands.push(render)) {
+    stats.renderDropped++;
+    return false;
+  }
+  stats.renderPosted++;
+  std::lock_guard<std::mutex> lock(renderMutex);
+  if (renderNotifiedAt == 0) {
+    renderNotifiedAt = loadMicros();
+  }
+  renderWake.notify_one();
+  return true;
+}
+
+static void runLoadModel(bool async, uint32_t clientCount, LoadStats& stats) {
+  std::atomic<bool> running{true};
+  patternEngine.select(PATTERN_WAVE);
+  processRenderCommands();
+  uint32_t appliedBefore = renderCommandsApplied.load();
+  loadStart = Clock::now();
+
+  // Render task: how late each frame starts after it became due, either
+  // at the pattern's interval or when a command woke the task
+  std::thread render([&]() {
+    uint64_t due = 0;
+    while (running.load()) {
+      processRenderCommands();
+      uint64_t start = loadMicros();
+      if (patternEngine.update(millis())) {
+        stats.jitterNs.push_back((start > due ? start - due : 0) * 1000);
+      }
+
+      uint32_t wait = patternEngine.millisUntilNextFrame(millis());
+      due = loadMicros() + wait * 1000ull;
+      std::unique_lock<std::mutex> lock(renderMutex);
+      renderWake.wait_until(lock, loadStart + std::chrono::microseconds(due), [&]() {
+        return renderNotifiedAt != 0 || !running.load();
+      });
+      if (renderNotifiedAt != 0) {
+        due = renderNotifiedAt < due ? renderNotifiedAt : due;
+        renderNotifiedAt = 0;
+      }
+    }
+  });
+
+  std::thread loop([&]() {
+    while (running.load()) {
+      WsCommand command;
+      while (httpQueue.pop(command)) {
+        postLoadCommand(command, stats);
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(LOAD_LOOP_PERIOD_MS));
+    }
+  });
+
+  std::vector<LoadClient> clients(clientCount);
+  for (uint32_t i = 0; i < clientCount; i++) {
+    clients[i].requestAt = (uint64_t)LOAD_THINK_US * i / clientCount;
+    clients[i].nextEventAt = clients[i].requestAt;
+    clients[i].request = i % loadRequestCount;
+    clients[i].segmentsLeft = 0;
+  }
+  uint64_t end = LOAD_DURATION_MS * 1000ull;
+  if (async) {
+    serveAsync(clients, stats, end);
+  } else {
+    serveBlocking(clients, stats, end);
+  }
+
+  running.store(false);
+  {
+    std::lock_guard<std::mutex> lock(renderMutex);
+    renderWake.notify_one();
+  }
+  loop.join();
+  render.join();
+
+  // Whatever is still queued is applied at the next frame
+  WsCommand command;
+  while (httpQueue.pop(command)) {
+    postLoadCommand(command, stats);
+  }
+  processRenderCommands();
+  stats.renderApplied = renderCommandsApplied.load() - appliedBefore;
+}
+
+// Every command a request issued was applied or reported as dropped
+static int verifyNoLostCommands(const char* model, const LoadStats& stats) {
+  uint32_t accounted = stats.renderApplied + stats.renderDropped + stats.httpDropped;
+  printf("%-8s %5u requests, %u commands: %u applied, %u dropped (http %u, render %u)\n",
+         model, (unsigned)stats.latencyNs.size(), stats.commandsIssued, stats.renderApplied,
+         stats.httpDropped + stats.renderDropped, stats.httpDropped, stats.renderDropped);
+  if (accounted != stats.commandsIssued || stats.renderApplied != stats.renderPosted) {
+    printf("%s server lost %d commands\n", model, (int)(stats.commandsIssued - accounted));
+    return 1;
+  }
+  return 0;
+}
+
+int runLoadBench(const BenchOptions& options) {
+  bool blocking = benchSelected(options, "blocking");
+  bool async = benchSelected(options, "async");
+  if (!blocking && !async) {
+    return 0;
+  }
+
+#ifdef __linux__
+  cpu_set_t savedCpus;
+  cpu_set_t oneCpu;
+  sched_getaffinity(0, sizeof(savedCpus), &savedCpus);
+  CPU_ZERO(&oneCpu);
+  for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+    if (CPU_ISSET(cpu, &savedCpus)) {
+      CPU_SET(cpu, &oneCpu);
+      break;
+    }
+  }
+  bool pinned = sched_setaffinity(0, sizeof(oneCpu), &oneCpu) == 0;
+#else
+  bool pinned = false;
+#endif
+
+  printf("\nHTTP load: %u clients, %u ms per model, %s\n", options.clients, LOAD_DURATION_MS,
+         pinned ? "one CPU" : "all CPUs");
+  LoadStats blockingStats;
+  LoadStats asyncStats;
+  int failures = 0;
+  if (blocking) {
+    runLoadModel(false, options.clients, blockingStats);
+    failures += verifyNoLostCommands("blocking", blockingStats);
+  }
+  if (async) {
+    runLoadModel(true, options.clients, asyncStats);
+    failures += verifyNoLostCommands("async", asyncStats);
+  }
+
+#ifdef __linux__
+  sched_setaffinity(0, sizeof(savedCpus), &savedCpus);
+#endif
+
+  benchPrintHeader("HTTP load (ns/request, ns/frame)");
+  if (blocking) {
+    benchPrintResult(benchSummarize("blocking latency", blockingStats.latencyNs));
+    benchPrintResult(benchSummarize("blocking frame jitter", blockingStats.jitterNs));
+  }
+  if (async) {
+    benchPrintResult(benchSummarize("async latency", asyncStats.latencyNs));
+    benchPrintResult(benchSummarize("async frame jitter", asyncStats.jitterNs));
+  }
+
+  patternEngine.select(PATTERN_WAVE);
+  staticColor = 0xFF0000;
+  frameOutput.setBrightness(64);
+  return failures;
+}
@@ -0,0 +1,172 @@
+/**
+ * Log buffer: level stripping, wrap-around and concurrent writers
+ */
+
+#include "bench.h"
+#include "log_buffer.h"
+#include <stdio.h>
+#include <string.h>
+#include <thread>
+
+static volatile uint32_t sink;
+
+static void put(LogBuffer& buffer, uint8_t level, const char* format, ...) __attribute__((format(printf, 3, 4)));
+static void put(LogBuffer& buffer, uint8_t level, const char* format, ...) {
+  va_list args;
+  va_start(args, format);
+  buffer.write(level, 1234, format, args);
+  va_end(args);
+}
+
+static uint32_t check(uint32_t writer, uint32_t n) {
+  return (writer * 2654435761u) ^ (n * 40503u);
+}
+
+static int verifyLevels() {
+  int failures = 0;
+
+  // Below the build's level: no line, and the arguments are not evaluated
+  uint32_t before = logBuffer.written();
+  int evaluated = 0;
+  LOG_D("debug %d", ++evaluated);
+  LOG_I("info %d", ++evaluated);
+  LogCursor cursor = logBuffer.oldest();
+  LogEntry entry = {};
+  while (logBuffer.read(cursor, entry)) {
+  }
+  if (evaluated != 1 || logBuffer.written() != before + 1 || entry.level != LOG_LEVEL_INFO ||
+      strcmp(entry.text, "info 1") != 0) {
+    printf("LOG_D not stripped or LOG_I not logged (%d evaluated)\n", evaluated);
+    failures++;
+  }
+
+  char line[LOG_LINE_SIZE];
+  entry.millis = 12345;
+  size_t length = formatLogLine(entry, line, sizeof(line));
+  if (strcmp(line, "[    12.345] I info 1\n") != 0 || length != strlen(line)) {
+    printf("formatted log line is wrong: %s", line);
+    failures++;
+  }
+  return failures;
+}
+
+static int verifyWrap() {
+  int failures = 0;
+  static LogBuffer buffer;
+
+  // A reader that falls behind loses the oldest lines, and knows how many
+  LogCursor cursor;
+  for (uint32_t n = 0; n < LOG_SLOTS + 10; n++) {
+    put(buffer, LOG_LEVEL_INFO, "line %u", n);
+  }
+  LogEntry entry;
+  uint32_t count = 0;
+  uint32_t wrong = 0;
+  while (buffer.read(cursor, entry)) {
+    char expected[16];
+    snprintf(expected, sizeof(expected), "line %u", count + 10);
+    wrong += entry.sequence != count + 10 || strcmp(entry.text, expected) != 0;
+    count++;
+  }
+  if (count != LOG_SLOTS || cursor.dropped != 10 || wrong != 0) {
+    printf("log wrap: %u lines read, %u dropped, %u wrong\n", count, cursor.dropped, wrong);
+    failures++;
+  }
+
+  // Long lines are cut to the slot
+  char longText[200];
+  memset(longText, 'x', sizeof(longText) - 1);
+  longText[sizeof(longText) - 1] = '\0';
+  put(buffer, LOG_LEVEL_WARN, "%s", longText);
+  if (!buffer.read(cursor, entry) || strlen(entry.text) != LOG_TEXT_SIZE - 1) {
+    printf("long log line not truncated\n");
+    failures++;
+  }
+  return failures;
+}
+
+// Writers on several threads while a reader drains: every line read is
+// whole, and read + dropped accounts for every line written
+static int verifyConcurrent() {
+  static LogBuffer buffer;
+  const uint32_t writers = 3;
+  const uint32_t perWriter = 50000;
+  std::atomic<uint32_t> running{writers};
+  LogCursor cursor;
+  uint32_t read = 0;
+  uint32_t torn = 0;
+
+  auto drain = [&]() {
+    LogEntry entry;
+    while (buffer.read(cursor, entry)) {
+      unsigned writer, n, sum;
+      if (sscanf(entry.text, "writer %u line %u check %x", &writer, &n, &sum) != 3 ||
+          sum != check(writer, n)) {
+        torn++;
+      }
+      read++;
+    }
+  };
+
+  std::vector<std::thread> threads;
+  for (uint32_t w = 0; w < writers; w++) {
+    threads.emplace_back([&running, w, perWriter]() {
+      for (uint32_t n = 0; n < perWriter; n++) {
+        put(buffer, LOG_LEVEL_INFO, "writer %u line %u check %x", w, n, check(w, n));
+        if (n % 256 == 0) {
+          std::this_thread::yield();
+        }
+      }
+      running--;
+    });
+  }
+  while (running > 0) {
+    drain();
+    std::this_thread::yield();
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+  drain();
+
+  printf("log from %u threads: %u lines, %u read, %u dropped, %u torn\n", writers,
+         writers * perWriter, read, cursor.dropped, torn);
+  if (torn != 0 || read + cursor.dropped != writers * perWriter) {
+    return 1;
+  }
+  return 0;
+}
+
+int runLogBench(const BenchOptions& options) {
+  printf("\n");
+  int failures = verifyLevels() + verifyWrap() + verifyConcurrent();
+  printf("log buffer: %s\n", failures == 0 ? "ok" : "FAILED");
+
+  benchPrintHeader("log buffer (ns/line)");
+  if (benchSelected(options, "LOG_I")) {
+    static uint32_t n = 0;
+    benchPrintResult(benchRun("LOG_I", options, []() {
+      LOG_I("Preferences saved to flash (%u commits, %u avoided)", n++, 7u);
+    }));
+  }
+  if (benchSelected(options, "LOG_D (stripped)")) {
+    static uint32_t n = 0;
+    benchPrintResult(benchRun("LOG_D (stripped)", options, []() {
+      LOG_D("Wave: offset %u, step %u", n++, 7u);
+      sink = n;
+    }));
+  }
+  if (benchSelected(options, "write+read+format")) {
+    static LogCursor cursor;
+    static char line[LOG_LINE_SIZE];
+    benchPrintResult(benchRun("write+read+format", options, []() {
+      LogEntry entry;
+      LOG_I("Brightness changed to: %d%%", 50);
+      if (logBuffer.read(cursor, entry)) {
+        sink = formatLogLine(entry, line, sizeof(line));
+      }
+    }));
+  }
+
+  return failures;
+}
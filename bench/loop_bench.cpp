@@ -0,0 +1,181 @@
+/**
+ * Main loop scheduling: a simulated minute of loop passes with the old
+ * fixed delay(10) and with the deadline scheduler, in virtual time
+ */
+
+#include "bench.h"
+#include "loop_scheduler.h"
+#include "heap_telemetry.h"
+#include <stdio.h>
+
+#define SIM_SECONDS         60
+#define SIM_FRAME_INTERVAL  20      // ms between frames of an animated pattern
+#define SIM_AUTO_CYCLE      6000    // ms
+#define SIM_START           0xFFFF0000u   // millis() wraps 65 s in
+
+static volatile uint32_t sink;
+
+struct SimScenario {
+  const char* name;
+  bool animated;          // Frames change (Wave) or not (Static)
+  bool autoCycle;
+  uint8_t stations;       // Associated with the access point
+  uint8_t clients;        // WebSocket clients
+};
+
+struct SimResult {
+  uint32_t wakeups;
+  uint32_t notifiedWakeups;
+  uint32_t longestSleep;      // ms
+  uint32_t autoCycles;
+  uint32_t autoCycleLateness; // Worst, ms
+  uint32_t buttonLatency;     // Worst, ms from edge to the pass that saw it
+  uint32_t powerSaveMillis;
+};
+
+// Button edges (pressed, released) in ms from the start
+static const uint32_t buttonEdges[] = { 2503, 2611, 31007, 31019 };
+#define BUTTON_EDGES (sizeof(buttonEdges) / sizeof(buttonEdges[0]))
+
+// Run the loop's deadline logic (the same steps as loop() in main.cpp)
+// for SIM_SECONDS. fixedDelay = 0 sleeps until the next deadline.
+static SimResult simulateLoop(const SimScenario& scenario, uint32_t fixedDelay) {
+  SimResult result = {};
+  LoopScheduler scheduler;
+  HeapHistory history;
+  uint32_t now = SIM_START;
+  uint32_t end = SIM_START + SIM_SECONDS * 1000;
+  uint32_t lastAutoCycle = now;
+  uint8_t nextEdge = 0;
+  bool buttonHeld = false;
+
+  while ((int32_t)(end - now) > 0) {
+    scheduler.begin(now);
+    scheduler.pollNetwork(scenario.clients, scenario.stations);
+
+    if (history.due(now)) {
+      history.add({ now, 100000, 90000 });
+    }
+    scheduler.wakeAt(history.nextSampleMillis());
+
+    if (scenario.autoCycle && now - lastAutoCycle >= SIM_AUTO_CYCLE) {
+      uint32_t late = now - lastAutoCycle - SIM_AUTO_CYCLE;
+      if (late > result.autoCycleLateness) {
+        result.autoCycleLateness = late;
+      }
+      lastAutoCycle = now;
+      result.autoCycles++;
+    }
+    if (scenario.autoCycle) {
+      scheduler.wakeAt(lastAutoCycle + SIM_AUTO_CYCLE);
+    }
+
+    while (nextEdge < BUTTON_EDGES && (int32_t)(now - (SIM_START + buttonEdges[nextEdge])) >= 0) {
+      uint32_t latency = now - (SIM_START + buttonEdges[nextEdge]);
+      if (latency > result.buttonLatency) {
+        result.buttonLatency = latency;
+      }
+      buttonHeld = !buttonHeld;
+      nextEdge++;
+    }
+    if (buttonHeld) {
+      scheduler.wakeIn(LOOP_BUTTON_POLL);
+    }
+
+    uint32_t framesPushed = scenario.animated ? (now - SIM_START) / SIM_FRAME_INTERVAL : 0;
+    scheduler.framesPushed(framesPushed, now);
+    bool powerSave = scheduler.powerSaveAllowed(now, scenario.stations);
+
+    // Sleep; a button edge before the deadline wakes the loop early
+    uint32_t sleep = fixedDelay != 0 ? fixedDelay : scheduler.sleepMillis();
+    bool notified = false;
+    if (fixedDelay == 0 && nextEdge < BUTTON_EDGES) {
+      uint32_t untilEdge = SIM_START + buttonEdges[nextEdge] - now;
+      if (untilEdge < sleep) {
+        sleep = untilEdge;
+        notified = true;
+      }
+    }
+    if (sleep == 0) {
+      sleep = 1;   // The firmware blocks at least one tick
+    }
+    if (sleep > result.longestSleep) {
+      result.longestSleep = sleep;
+    }
+    if (powerSave) {
+      result.powerSaveMillis += sleep;
+    }
+    now += sleep;
+    scheduler.woke(notified);
+  }
+  result.wakeups = scheduler.wakeups;
+  result.notifiedWakeups = scheduler.notifiedWakeups;
+  return result;
+}
+
+static const SimScenario scenarios[] = {
+  { "static, nobody connected", false, false, 0, 0 },
+  { "static, station idle", false, false, 1, 0 },
+  { "wave, auto-cycle", true, true, 0, 0 },
+  { "wave, 1 WebSocket client", true, false, 1, 1 },
+};
+
+static int verifyScheduler() {
+  int failures = 0;
+  printf("%-26s %14s %14s %10s %11s\n", "loop wakeups/s", "delay(10)", "deadlines", "notified", "power save");
+  for (const SimScenario& scenario : scenarios) {
+    SimResult fixed = simulateLoop(scenario, 10);
+    SimResult deadline = simulateLoop(scenario, 0);
+    printf("%-26s %14.1f %14.1f %10u %10u%%\n", scenario.name, (double)fixed.wakeups / SIM_SECONDS,
+           (double)deadline.wakeups / SIM_SECONDS, deadline.notifiedWakeups,
+           deadline.powerSaveMillis / (SIM_SECONDS * 10));
+
+    // Deadlines are met exactly, the loop never sleeps past LOOP_MAX_SLEEP
+    // and button edges are seen when they happen
+    if (deadline.longestSleep > LOOP_MAX_SLEEP || deadline.autoCycleLateness != 0 ||
+        deadline.buttonLatency != 0 || deadline.autoCycles != fixed.autoCycles) {
+      printf("%s: slept up to %u ms, auto-cycle up to %u ms late (%u of %u), button seen %u ms late\n",
+             scenario.name, deadline.longestSleep, deadline.autoCycleLateness, deadline.autoCycles,
+             fixed.autoCycles, deadline.buttonLatency);
+      failures++;
+    }
+    // Polling stays as often as before while clients are connected
+    uint32_t expected = scenario.clients > 0 ? 1000 / LOOP_NETWORK_POLL
+                      : scenario.stations > 0 ? 1000 / LOOP_ACCEPT_POLL : 1000 / LOOP_MAX_SLEEP;
+    uint32_t extra = BUTTON_EDGES + 120 / LOOP_BUTTON_POLL;   // Edges, and polls while held
+    if (deadline.wakeups > expected * SIM_SECONDS + SIM_SECONDS / 10 + extra + deadline.autoCycles + 1) {
+      printf("%s: %u wakeups, expected about %u\n", scenario.name, deadline.wakeups, expected * SIM_SECONDS);
+      failures++;
+    }
+    // Power save only with static output and no station
+    bool saves = deadline.powerSaveMillis > 0;
+    if (saves != (!scenario.animated && scenario.stations == 0)) {
+      printf("%s: power save %s\n", scenario.name, saves ? "on" : "off");
+      failures++;
+    }
+  }
+  return failures;
+}
+
+int runLoopBench(const BenchOptions& options) {
+  printf("\n");
+  int failures = verifyScheduler();
+  printf("loop scheduler: %s\n", failures == 0 ? "ok" : "FAILED");
+
+  benchPrintHeader("loop scheduler (ns/pass)");
+  if (benchSelected(options, "plan loop pass")) {
+    static LoopScheduler scheduler;
+    static uint32_t now = 0;
+    benchPrintResult(benchRun("plan loop pass", options, []() {
+      now += 7;
+      scheduler.begin(now);
+      scheduler.pollNetwork(0, 1);
+      scheduler.wakeAt(now + 6000);
+      scheduler.wakeIn(LOOP_BUTTON_POLL);
+      scheduler.framesPushed(now / 20, now);
+      sink = scheduler.sleepMillis() + scheduler.powerSaveAllowed(now, 0);
+    }));
+  }
+
+  return failures;
+}
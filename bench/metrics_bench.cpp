@@ -0,0 +1,139 @@
+/**
+ * Frame metrics: histogram buckets, Prometheus text and recording cost
+ */
+
+#include "bench.h"
+#include "frame_metrics.h"
+#include <stdio.h>
+#include <string.h>
+
+static volatile uint32_t sink;
+
+static int verifyHistogram() {
+  int failures = 0;
+  TimingHistogram histogram;
+  const uint32_t samples[] = { 0, 1023, 1024, 2047, 2048, 100000, 0xFFFFFFFF };
+  for (uint32_t nanos : samples) {
+    histogram.record(nanos);
+  }
+  // 100000 ns is in [2^16, 2^17): bucket 7
+  const uint32_t expected[METRICS_BUCKETS] = { 2, 2, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 0, 1 };
+  if (memcmp(histogram.buckets, expected, sizeof(expected)) != 0 ||
+      histogram.sumNanos != 0xFFFFFFFFull + 1023 + 1024 + 2047 + 2048 + 100000) {
+    printf("histogram buckets are wrong\n");
+    failures++;
+  }
+
+  // Cumulative buckets in seconds; the first bound is 2^10 ns
+  char text[METRICS_HISTOGRAM_TEXT];
+  size_t length = formatHistogram(text, sizeof(text), "led_show_seconds", "pattern=\"wave\"",
+                                  histogram);
+  if (length == 0 || length != strlen(text) ||
+      strstr(text, "led_show_seconds_bucket{pattern=\"wave\",le=\"1.02e-06\"} 2\n") == nullptr ||
+      strstr(text, "led_show_seconds_bucket{pattern=\"wave\",le=\"4.1e-06\"} 5\n") == nullptr ||
+      strstr(text, "led_show_seconds_bucket{pattern=\"wave\",le=\"+Inf\"} 7\n") == nullptr ||
+      strstr(text, "led_show_seconds_count{pattern=\"wave\"} 7\n") == nullptr) {
+    printf("histogram text is wrong:\n%s", text);
+    failures++;
+  }
+  length = formatHistogram(text, sizeof(text), "led_show_seconds", "", histogram);
+  if (strstr(text, "led_show_seconds_bucket{le=\"+Inf\"} 7\n") == nullptr ||
+      strstr(text, "led_show_seconds_sum 4.29") == nullptr) {
+    printf("unlabeled histogram text is wrong:\n%s", text);
+    failures++;
+  }
+  if (formatHistogram(text, 200, "led_show_seconds", "", histogram) != 0) {
+    printf("histogram text overflowed its buffer\n");
+    failures++;
+  }
+
+  // The loop period histogram keeps a one second sleep out of +Inf
+  TimingHistogram loop(METRICS_LOOP_BUCKET);
+  loop.record(1000000000);
+  formatHistogram(text, sizeof(text), "led_loop_period_seconds", "", loop);
+  if (loop.buckets[METRICS_BUCKETS - 2] != 1 ||
+      strstr(text, "led_loop_period_seconds_bucket{le=\"1.07\"} 1\n") == nullptr) {
+    printf("loop period histogram is wrong:\n%s", text);
+    failures++;
+  }
+  return failures;
+}
+
+static int verifyFrameMetrics() {
+  int failures = 0;
+  FrameMetrics metrics;
+
+  // 20 ms frames: on time, 3 ms late, and one that missed a slot
+  metrics.frameScheduled(20000, 20);
+  metrics.frameScheduled(23000, 20);
+  metrics.frameScheduled(45000, 20);
+  uint32_t late = 0;
+  for (uint8_t i = 1; i < METRICS_BUCKETS; i++) {
+    late += metrics.lateness.buckets[i];
+  }
+  if (metrics.lateness.buckets[0] != 1 || late != 2 || metrics.deadlinesMissed != 1) {
+    printf("frame lateness: %u on time, %u late, %u missed\n", metrics.lateness.buckets[0], late,
+           metrics.deadlinesMissed);
+    failures++;
+  }
+
+  // Loop iterations across a wrapping micros()
+  metrics.loopStarted(0xFFFFFF00);
+  metrics.loopStarted(0x100);
+  if (metrics.loopPeriod.sumNanos != 0x200 * 1000) {
+    printf("loop period: %u ns, expected %u\n", (unsigned)metrics.loopPeriod.sumNanos, 0x200 * 1000);
+    failures++;
+  }
+
+  // 50 frames in the first second, then 25 in the next 2 s
+  for (uint32_t now = 0; now <= 1000; now += 20) {
+    metrics.frameStarted(now);
+  }
+  uint32_t first = metrics.framesPerSecondMilli;
+  for (uint32_t now = 1080; now <= 3000; now += 80) {
+    metrics.frameStarted(now);
+  }
+  if (first != 51000 || metrics.framesPerSecondMilli != 12500) {
+    printf("frame rate: %u then %u mFPS, expected 51000 then 12500\n", first, metrics.framesPerSecondMilli);
+    failures++;
+  }
+  return failures;
+}
+
+int runMetricsBench(const BenchOptions& options) {
+  printf("\n");
+  int failures = verifyHistogram() + verifyFrameMetrics();
+  printf("frame metrics: %s\n", failures == 0 ? "ok" : "FAILED");
+
+  benchPrintHeader("frame metrics (ns/100 samples)");
+  if (benchSelected(options, "metricsCycles x100")) {
+    benchPrintResult(benchRun("metricsCycles x100", options, []() {
+      uint32_t total = 0;
+      for (uint8_t i = 0; i < 100; i++) {
+        total += metricsCycles();
+      }
+      sink = total;
+    }));
+  }
+  if (benchSelected(options, "record x100")) {
+    static TimingHistogram histogram;
+    static uint32_t cycles = 12345;
+    benchPrintResult(benchRun("record x100", options, []() {
+      for (uint8_t i = 0; i < 100; i++) {
+        cycles = cycles * 1664525 + 1013904223;
+        histogram.record(cycles >> 12);
+      }
+      sink = histogram.buckets[3];
+    }));
+  }
+  if (benchSelected(options, "format histogram")) {
+    static TimingHistogram histogram;
+    static char text[METRICS_HISTOGRAM_TEXT];
+    histogram.record(5000);
+    benchPrintResult(benchRun("format histogram", options, []() {
+      sink = formatHistogram(text, sizeof(text), "led_render_seconds", "pattern=\"wave\"", histogram);
+    }));
+  }
+
+  return failures;
+}
@@ -0,0 +1,217 @@
+/**
+ * Packed-pixel math: every kernel against per-channel scalar code, for
+ * results and for throughput over a frame
+ */
+
+#include "bench.h"
+#include "packed_pixel.h"
+#include "frame_output.h"
+#include <stdio.h>
+#include <string.h>
+
+static volatile uint32_t sink;
+
+// The per-channel code the kernels replace
+static Color16 scalarScale(const Color16& color, uint16_t scale) {
+  return { (uint16_t)(color.r * scale >> 8), (uint16_t)(color.g * scale >> 8), (uint16_t)(color.b * scale >> 8) };
+}
+
+static uint16_t addChannel(uint16_t a, uint16_t b) {
+  uint32_t sum = (uint32_t)a + b;
+  return sum > COLOR16_ONE ? COLOR16_ONE : sum;
+}
+
+static Color16 scalarAdd(const Color16& a, const Color16& b) {
+  return { addChannel(a.r, b.r), addChannel(a.g, b.g), addChannel(a.b, b.b) };
+}
+
+static uint8_t scalarCool(uint8_t value, uint8_t amount, uint16_t scale) {
+  uint8_t cooling = (amount * scale) >> 8;
+  return value > cooling ? value - cooling : 0;
+}
+
+static uint32_t nextRandom(uint32_t& state) {
+  state ^= state << 13;
+  state ^= state >> 17;
+  state ^= state << 5;
+  return state;
+}
+
+static Color16 nextColor(uint32_t& state) {
+  uint32_t high = nextRandom(state);
+  return { (uint16_t)(high >> 16), (uint16_t)high, (uint16_t)nextRandom(state) };
+}
+
+static int verifyKernels() {
+  int failures = 0;
+  // Channel (and heat byte) values where carries and borrows change
+  static const uint16_t edges[] = { 0x0000, 0x0001, 0x7FFF, 0x8000, 0x8001, 0xFFFE, 0xFFFF };
+  static const uint8_t edgeBytes[] = { 0x00, 0x01, 0x7F, 0x80, 0x81, 0xFE, 0xFF };
+  const uint8_t edgeCount = sizeof(edgeBytes);
+  Color16 colors[edgeCount * edgeCount];
+  uint8_t count = 0;
+  for (uint8_t r = 0; r < edgeCount; r++) {
+    for (uint8_t g = 0; g < edgeCount; g++) {
+      colors[count++] = { edges[r], edges[g], edges[(r + g) % edgeCount] };
+    }
+  }
+  uint32_t state = 0x2545F491;
+  uint32_t mismatches = 0;
+  for (uint32_t i = 0; i < 200000; i++) {
+    // Every pair of edge colors first, then random ones
+    Color16 a[2] = { i < 2401 ? colors[i % count] : nextColor(state), nextColor(state) };
+    Color16 b[2] = { i < 2401 ? colors[i / count] : nextColor(state), nextColor(state) };
+    uint16_t scale = i % (PIXEL_SCALE_ONE + 1);
+    Color16 out[2];
+
+    // Two pixels are one whole word and one partly filled word
+    lerpPixels(a, b, out, 2, scale);
+    mismatches += out[0] != color16Lerp(a[0], b[0], scale) || out[1] != color16Lerp(a[1], b[1], scale);
+    memcpy(out, a, sizeof(out));
+    scalePixels(out, 2, scale);
+    mismatches += out[0] != scalarScale(a[0], scale) || out[1] != scalarScale(a[1], scale);
+    memcpy(out, a, sizeof(out));
+    addPixels(out, b, 2);
+    mismatches += out[0] != scalarAdd(a[0], b[0]) || out[1] != scalarAdd(a[1], b[1]);
+
+    // Eleven heat cells: a whole word and a partly filled one
+    uint8_t values[11], amounts[11];
+    for (uint8_t k = 0; k < sizeof(values); k++) {
+      uint32_t bits = nextRandom(state);
+      values[k] = i < 2401 ? edgeBytes[(i + k) % edgeCount] : bits;
+      amounts[k] = i < 2401 ? edgeBytes[(i / edgeCount + k) % edgeCount] : bits >> 8;
+    }
+    uint8_t cooled[sizeof(values)];
+    memcpy(cooled, values, sizeof(cooled));
+    fadeBytes(cooled, amounts, sizeof(cooled), scale);
+    for (uint8_t k = 0; k < sizeof(values); k++) {
+      mismatches += cooled[k] != scalarCool(values[k], amounts[k], scale);
+    }
+  }
+  if (mismatches != 0) {
+    printf("packed kernels: %u results differ from the scalar code\n", mismatches);
+    failures++;
+  }
+
+  // Buffer helpers, in place
+  Color16 pixels[3] = { { 0xFFFF, 0x8000, 0x0000 }, { 0x1000, 0x2000, 0x3000 }, { 0xFFFF, 0xFFFF, 0xFFFF } };
+  const Color16 add[3] = { { 0x0001, 0x8000, 0xFFFF }, {}, { 0x0001, 0x0001, 0x0001 } };
+  addPixels(pixels, add, 3);
+  fadePixels(pixels, 3, 128);
+  if (pixels[0] != Color16{ 0x7FFF, 0x7FFF, 0x7FFF } || pixels[1] != Color16{ 0x0800, 0x1000, 0x1800 } ||
+      pixels[2] != Color16{ 0x7FFF, 0x7FFF, 0x7FFF }) {
+    printf("addPixels/fadePixels: %04X %04X %04X\n", pixels[0].r, pixels[1].g, pixels[2].b);
+    failures++;
+  }
+  return failures;
+}
+
+// Frame-sized buffers for the throughput cases
+static Frame frameA;
+static Frame frameB;
+static Frame frameOut;
+static uint8_t heat[GRID_WIDTH][GRID_HEIGHT];
+static uint8_t heatOut[GRID_WIDTH][GRID_HEIGHT];
+static uint8_t noise[GRID_WIDTH][GRID_HEIGHT];
+
+int runPackedPixelBench(const BenchOptions& options) {
+  printf("\n");
+  int failures = verifyKernels();
+  printf("packed pixels: %s\n", failures == 0 ? "ok" : "FAILED");
+
+  uint32_t state = 12345;
+  for (uint16_t i = 0; i < NUM_PIXELS; i++) {
+    frameA.pixel[i] = nextColor(state);
+    frameB.pixel[i] = nextColor(state);
+    heat[i / GRID_HEIGHT][i % GRID_HEIGHT] = nextRandom(state);
+    noise[i / GRID_HEIGHT][i % GRID_HEIGHT] = nextRandom(state);
+  }
+
+  // Each pair runs over the same frame with only the kernel swapped: the
+  // scalar side is the per-channel loop the frame code used before. Work
+  // done in place starts again from the same colors every pass.
+  benchPrintHeader("packed pixels (ns/frame)");
+  if (benchSelected(options, "scale scalar")) {
+    benchPrintResult(benchRun("scale scalar", options, []() {
+      frameOut = frameA;
+      for (uint16_t i = 0; i < NUM_PIXELS; i++) {
+        frameOut.pixel[i] = scalarScale(frameOut.pixel[i], 65);
+      }
+      sink = frameOut.pixel[7].r;
+    }));
+  }
+  if (benchSelected(options, "scale packed")) {
+    benchPrintResult(benchRun("scale packed", options, []() {
+      frameOut = frameA;
+      scalePixels(frameOut.pixel, NUM_PIXELS, 65);
+      sink = frameOut.pixel[7].r;
+    }));
+  }
+  if (benchSelected(options, "add scalar")) {
+    benchPrintResult(benchRun("add scalar", options, []() {
+      frameOut = frameA;
+      for (uint16_t i = 0; i < NUM_PIXELS; i++) {
+        frameOut.pixel[i] = scalarAdd(frameOut.pixel[i], frameB.pixel[i]);
+      }
+      sink = frameOut.pixel[7].r;
+    }));
+  }
+  if (benchSelected(options, "add packed")) {
+    benchPrintResult(benchRun("add packed", options, []() {
+      frameOut = frameA;
+      addPixels(frameOut.pixel, frameB.pixel, NUM_PIXELS);
+      sink = frameOut.pixel[7].r;
+    }));
+  }
+  if (benchSelected(options, "lerp scalar")) {
+    benchPrintResult(benchRun("lerp scalar", options, []() {
+      for (uint16_t i = 0; i < NUM_PIXELS; i++) {
+        frameOut.pixel[i] = color16Lerp(frameA.pixel[i], frameB.pixel[i], 77);
+      }
+      sink = frameOut.pixel[7].r;
+    }));
+  }
+  if (benchSelected(options, "lerp packed")) {
+    benchPrintResult(benchRun("lerp packed", options, []() {
+      lerpPixels(frameA.pixel, frameB.pixel, frameOut.pixel, NUM_PIXELS, 77);
+      sink = frameOut.pixel[7].r;
+    }));
+  }
+  if (benchSelected(options, "fade scalar")) {
+    benchPrintResult(benchRun("fade scalar", options, []() {
+      frameOut = frameA;
+      for (uint16_t i = 0; i < NUM_PIXELS; i++) {
+        frameOut.pixel[i] = scalarScale(frameOut.pixel[i], PIXEL_SCALE_ONE - 20);
+      }
+      sink = frameOut.pixel[7].r;
+    }));
+  }
+  if (benchSelected(options, "fade packed")) {
+    benchPrintResult(benchRun("fade packed", options, []() {
+      frameOut = frameA;
+      fadePixels(frameOut.pixel, NUM_PIXELS, 20);
+      sink = frameOut.pixel[7].r;
+    }));
+  }
+  // Fire's cooling over every heat cell
+  if (benchSelected(options, "cool scalar")) {
+    benchPrintResult(benchRun("cool scalar", options, []() {
+      memcpy(heatOut, heat, sizeof(heatOut));
+      for (uint8_t col = 0; col < GRID_WIDTH; col++) {
+        for (uint8_t h = 0; h < GRID_HEIGHT; h++) {
+          heatOut[col][h] = scalarCool(heatOut[col][h], noise[col][h], 58);
+        }
+      }
+      sink = heatOut[1][7];
+    }));
+  }
+  if (benchSelected(options, "cool packed")) {
+    benchPrintResult(benchRun("cool packed", options, []() {
+      memcpy(heatOut, heat, sizeof(heatOut));
+      fadeBytes(&heatOut[0][0], &noise[0][0], NUM_PIXELS, 58);
+      sink = heatOut[1][7];
+    }));
+  }
+
+  return failures;
+}
@@ -0,0 +1,237 @@
+/**
+ * Per-pattern render cost
+ *
+ * Drives each registered pattern from src/patterns.cpp into a Frame and
+ * through the change-detecting frame output, one frame per iteration.
+ */
+
+#include "bench.h"
+#include "patterns.h"
+#include "reference_patterns.h"
+#include "pixel_layout.h"
+
+// Strip behind the frame output (the firmware defines its own)
+Adafruit_NeoPixel pixels(NUM_PIXELS, 10, NEO_GRB + NEO_KHZ800);
+
+// Compare Pulse frames with the float ring test over a full hue cycle
+static int verifyPulse() {
+  Adafruit_NeoPixel reference(NUM_PIXELS, 10, NEO_GRB + NEO_KHZ800);
+  uint32_t frames = 65536 / 300 + 1;
+  uint32_t mismatchedFrames = 0;
+  Pattern& pulse = getPattern(PATTERN_PULSE);
+  Frame output = {};
+
+  pulse.reset();
+  for (uint32_t frame = 0; frame < frames; frame++) {
+    referencePulseFrame(reference, (uint16_t)(frame * 300));
+    pulse.render(output);
+    for (uint16_t i = 0; i < NUM_PIXELS; i++) {
+      if (color8(output.pixel[i]) != reference.getPixelColor(i)) {
+        mismatchedFrames++;
+        break;
+      }
+    }
+  }
+
+  printf("Pulse vs float reference: %u frames, %u mismatched\n", frames, mismatchedFrames);
+  return mismatchedFrames == 0 ? 0 : 1;
+}
+
+// Matrix frames only depend on the drop state: a frame full of garbage
+// renders the same as a blank one, and drops reach the bottom row
+static int verifyMatrix() {
+  Pattern& matrix = getPattern(PATTERN_MATRIX);
+  Frame blank = {};
+  Frame garbage;
+  uint32_t bottomLit = 0;
+
+  for (uint8_t pass = 0; pass < 2; pass++) {
+    Frame& frame = pass == 0 ? blank : garbage;
+    seedPatterns(7);
+    matrix.reset();
+    for (uint32_t f = 0; f < 200; f++) {
+      if (pass == 1) {
+        frame.fill(color16(0x123456 + f));
+      }
+      matrix.render(frame);
+      if (pass == 0) {
+        bottomLit += !isBlack(frame.pixel[pixelLayout().pixelAt[0][GRID_HEIGHT - 1]]);
+      }
+    }
+  }
+  bool differing = memcmp(&blank, &garbage, sizeof(blank)) != 0;
+
+  printf("Matrix: %u of 200 frames with the bottom of column 0 lit, %s from a dirty frame\n",
+         bottomLit, differing ? "different" : "same");
+  return differing == 0 && bottomLit > 0 ? 0 : 1;
+}
+
+// Fire is hotter at the bottom than at the top and does not repeat the
+// way the modulo version did every 256 frames
+static int verifyFire() {
+  Pattern& fire = getPattern(PATTERN_FIRE);
+  Frame frame = {};
+  static Frame history[600];
+  uint64_t bottom = 0, top = 0;
+  uint32_t repeats = 0;
+
+  fire.reset();
+  for (uint32_t f = 0; f < 600; f++) {
+    fire.render(frame);
+    history[f] = frame;
+    for (uint8_t col = 0; col < GRID_WIDTH; col++) {
+      bottom += frame.pixel[pixelLayout().pixelAt[col][GRID_HEIGHT - 1]].r;
+      top += frame.pixel[pixelLayout().pixelAt[col][0]].r;
+    }
+    if (f >= 256 && memcmp(&history[f], &history[f - 256], sizeof(frame)) == 0) {
+      repeats++;
+    }
+  }
+
+  printf("Fire: bottom row %.0f%% red on average, top row %.0f%%, %u frames repeat after 256\n",
+         bottom * 100.0 / (600 * GRID_WIDTH * COLOR16_ONE), top * 100.0 / (600 * GRID_WIDTH * COLOR16_ONE),
+         repeats);
+  return bottom > top && repeats == 0 ? 0 : 1;
+}
+
+// Each pattern must get exactly 1000 / frameInterval frames per second
+static int verifyScheduler() {
+  Pattern* registry[PATTERN_COUNT];
+  for (uint8_t i = 0; i < PATTERN_COUNT; i++) {
+    registry[i] = &getPattern(i);
+  }
+  PatternEngine engine(registry, PATTERN_COUNT, PATTERN_WAVE);
+  int failures = 0;
+
+  for (uint8_t i = 0; i < PATTERN_COUNT; i++) {
+    engine.select(i);
+    engine.update(0); // Switching renders right away
+    uint32_t frames = 0;
+    for (uint32_t now = 1; now <= 1000; now++) {
+      frames += engine.update(now) ? 1 : 0;
+    }
+    if (frames != 1000u / registry[i]->frameInterval) {
+      printf("%s rendered %u frames in 1 s, expected %u\n", registry[i]->name, frames,
+             1000u / registry[i]->frameInterval);
+      failures++;
+    }
+  }
+
+  printf("pattern scheduler: %s\n", failures == 0 ? "ok" : "FAILED");
+  return failures;
+}
+
+// Unchanged frames must not reach the strip; report how many frames each
+// pattern actually pushes over 10 s of simulated time
+static int verifyFrameOutput() {
+  Pattern* registry[PATTERN_COUNT];
+  for (uint8_t i = 0; i < PATTERN_COUNT; i++) {
+    registry[i] = &getPattern(i);
+  }
+  PatternEngine engine(registry, PATTERN_COUNT, PATTERN_WAVE);
+  int failures = 0;
+
+  printf("frame output over 10 s (rendered / pushed / shown):\n");
+  for (uint8_t i = 0; i < PATTERN_COUNT; i++) {
+    engine.select(i);
+    uint32_t rendered = frameOutput.framesRendered;
+    uint32_t pushed = frameOutput.framesPushed;
+    uint32_t shown = pixels.showCount;
+    for (uint32_t now = 0; now < 10000; now++) {
+      engine.update(now);
+    }
+    rendered = frameOutput.framesRendered - rendered;
+    pushed = frameOutput.framesPushed - pushed;
+    shown = pixels.showCount - shown;
+    printf("  %-10s %5u %5u %5u\n", registry[i]->name, rendered, pushed, shown);
+    if (shown != pushed) {
+      failures++;
+    }
+  }
+
+  // Static only pushes its first frame, until the brightness changes
+  engine.select(PATTERN_STATIC);
+  uint32_t pushed = frameOutput.framesPushed;
+  for (uint32_t now = 10000; now < 20000; now++) {
+    engine.update(now);
+  }
+  if (frameOutput.framesPushed - pushed != 1) {
+    printf("Static pushed %u frames, expected 1\n", frameOutput.framesPushed - pushed);
+    failures++;
+  }
+  frameOutput.setBrightness(frameOutput.getBrightness() ^ 1);
+  engine.requestFrame();
+  engine.update(20000);
+  if (frameOutput.framesPushed - pushed != 2) {
+    printf("Brightness change did not push a frame\n");
+    failures++;
+  }
+
+  printf("frame output: %s\n", failures == 0 ? "ok" : "FAILED");
+  return failures;
+}
+
+int runPatternBench(const BenchOptions& options) {
+  randomSeed(1);
+  seedPatterns(1);
+  pixels.begin();
+
+  printf("\n");
+  int failures = verifyPulse() + verifyMatrix() + verifyFire() + verifyScheduler() + verifyFrameOutput();
+
+  benchPrintHeader("patterns (ns/frame)");
+  frameOutput.setBrightness(64);
+  Frame frame = {};
+
+  for (uint8_t i = 0; i < PATTERN_COUNT; i++) {
+    Pattern& pattern = getPattern(i);
+    if (!benchSelected(options, pattern.name)) {
+      continue;
+    }
+
+    // Same restart the engine does on a pattern change
+    frame.clear();
+    pattern.reset();
+
+    // One frame as the engine produces it: render, then present
+    benchPrintResult(benchRun(pattern.name, options, [&pattern, &frame]() {
+      pattern.render(frame);
+      frameOutput.present(frame);
+    }));
+  }
+
+  // Rebuilt patterns against the originals, render only
+  benchPrintHeader("pattern rewrites, render only (ns/frame)");
+  if (benchSelected(options, "Matrix readback")) {
+    static Adafruit_NeoPixel strip(NUM_PIXELS, 10, NEO_GRB + NEO_KHZ800);
+    strip.begin();
+    strip.setBrightness(64);
+    benchPrintResult(benchRun("Matrix readback", options, []() {
+      referenceMatrixFrame(strip);
+    }));
+  }
+  if (benchSelected(options, "Matrix drops")) {
+    static Frame matrixFrame;
+    getPattern(PATTERN_MATRIX).reset();
+    benchPrintResult(benchRun("Matrix drops", options, []() {
+      getPattern(PATTERN_MATRIX).render(matrixFrame);
+    }));
+  }
+  if (benchSelected(options, "Fire modulo")) {
+    static Adafruit_NeoPixel strip(NUM_PIXELS, 10, NEO_GRB + NEO_KHZ800);
+    static uint8_t step = 0;
+    strip.begin();
+    benchPrintResult(benchRun("Fire modulo", options, []() {
+      referenceFireFrame(strip, step++);
+    }));
+  }
+  if (benchSelected(options, "Fire heat")) {
+    static Frame fireFrame;
+    getPattern(PATTERN_FIRE).reset();
+    benchPrintResult(benchRun("Fire heat", options, []() {
+      getPattern(PATTERN_FIRE).render(fireFrame);
+    }));
+  }
+
+  return failures;
+}
@@ -0,0 +1,98 @@
+/**
+ * Write-behind preference cache: commit batching and write volume
+ */
+
+#include "bench.h"
+#include "preference_cache.h"
+#include <map>
+#include <string>
+
+// Preferences stand-in that counts flash writes
+struct FakeStore {
+  std::map<std::string, uint32_t> saved;
+  uint32_t puts = 0;
+
+  uint8_t getUChar(const char* key, uint8_t value) { return saved.count(key) ? saved[key] : value; }
+  bool getBool(const char* key, bool value) { return saved.count(key) ? saved[key] != 0 : value; }
+  uint32_t getULong(const char* key, uint32_t value) { return saved.count(key) ? saved[key] : value; }
+  size_t putUChar(const char* key, uint8_t value) { puts++; saved[key] = value; return 1; }
+  size_t putBool(const char* key, bool value) { puts++; saved[key] = value; return 1; }
+  size_t putULong(const char* key, uint32_t value) { puts++; saved[key] = value; return 4; }
+};
+
+static int verifyPreferenceCache() {
+  int failures = 0;
+  FakeStore store;
+  PreferenceCache<FakeStore> cache(store, PREFERENCES_QUIET_PERIOD);
+
+  cache.load();
+  if (cache.get(PREF_BRIGHTNESS) != 64 || cache.get(PREF_AUTO_CYCLE_INTERVAL) != 6000) {
+    printf("preference defaults were not loaded\n");
+    failures++;
+  }
+
+  // A 5 s color-picker drag at 20 Hz plus a brightness change
+  uint32_t now = 0;
+  for (uint32_t i = 0; i < 100; i++, now += 50) {
+    cache.set(PREF_STATIC_COLOR, 0x010203 * (i + 1), now);
+    if (cache.update(now)) {
+      printf("preferences committed during the drag\n");
+      failures++;
+    }
+  }
+  cache.set(PREF_BRIGHTNESS, 128, now);
+  uint32_t lastChange = now;
+
+  // Nothing until the quiet period has passed, then one commit of two fields
+  cache.update(lastChange + PREFERENCES_QUIET_PERIOD - 1);
+  bool committed = cache.update(lastChange + PREFERENCES_QUIET_PERIOD);
+  if (store.puts != 2 || !committed || cache.commits != 1 || cache.bytesWritten != 5 ||
+      store.saved["staticColor"] != 0x010203 * 100 || store.saved["brightness"] != 128) {
+    printf("drag wrote %u keys in %u commits\n", store.puts, cache.commits);
+    failures++;
+  }
+  printf("color drag: %u set() calls, %u commits, %u avoided, %u bytes written\n",
+         cache.requests, cache.commits, cache.commitsAvoided(), cache.bytesWritten);
+
+  // Setting the saved value again is not a change
+  cache.set(PREF_BRIGHTNESS, 128, now);
+  if (cache.dirty()) {
+    printf("unchanged value marked dirty\n");
+    failures++;
+  }
+
+  // flush() writes right away, and a fresh cache reads it back
+  cache.set(PREF_AUTO_CYCLE, true, now);
+  if (cache.flush() != 1 || cache.dirty()) {
+    printf("flush did not write the pending field\n");
+    failures++;
+  }
+  PreferenceCache<FakeStore> reloaded(store, PREFERENCES_QUIET_PERIOD);
+  reloaded.load();
+  if (reloaded.get(PREF_AUTO_CYCLE) != 1 || reloaded.get(PREF_BRIGHTNESS) != 128) {
+    printf("saved preferences did not load back\n");
+    failures++;
+  }
+
+  printf("preference cache: %s\n", failures == 0 ? "ok" : "FAILED");
+  return failures;
+}
+
+int runPreferenceBench(const BenchOptions& options) {
+  printf("\n");
+  int failures = verifyPreferenceCache();
+
+  static FakeStore store;
+  static PreferenceCache<FakeStore> cache(store, PREFERENCES_QUIET_PERIOD);
+  static uint32_t color = 0;
+
+  benchPrintHeader("preference cache (ns/command)");
+  if (benchSelected(options, "set color")) {
+    benchPrintResult(benchRun("set color", options, []() {
+      cache.set(PREF_STATIC_COLOR, ++color, 0);
+      cache.update(1);
+    }));
+  }
+
+  return failures;
+}
@@ -0,0 +1,144 @@
+/**
+ * Frame preview: grid-order encoding, per-client rate limits and backoff
+ */
+
+#include "bench.h"
+#include "frame_preview.h"
+#include "pixel_layout.h"
+#include "ws_protocol.h"
+
+static volatile uint32_t sink;
+
+// Cells come out row by row whatever the wiring
+static int verifyEncoding() {
+  int failures = 0;
+  Frame frame;
+  for (uint16_t i = 0; i < NUM_PIXELS; i++) {
+    frame.pixel[i] = color16(0x010203 * i);
+  }
+
+  selectPixelLayout(LAYOUT_COLUMN_SERPENTINE);
+  uint8_t buffer[PREVIEW_FRAME_SIZE];
+  if (encodePreviewFrame(frame, 0x1234, buffer) != PREVIEW_FRAME_SIZE ||
+      buffer[0] != WS_PROTOCOL_VERSION || buffer[1] != WS_OP_PREVIEW ||
+      buffer[2] != 0x34 || buffer[3] != 0x12) {
+    printf("preview header is wrong\n");
+    failures++;
+  }
+  for (uint8_t row = 0; row < GRID_HEIGHT; row++) {
+    for (uint8_t col = 0; col < GRID_WIDTH; col++) {
+      uint32_t color = color8(frame.pixel[pixelLayout().pixelAt[col][row]]);
+      const uint8_t* cell = buffer + 4 + (row * GRID_WIDTH + col) * 3;
+      if (cell[0] != (uint8_t)(color >> 16) || cell[1] != (uint8_t)(color >> 8) ||
+          cell[2] != (uint8_t)color) {
+        printf("preview cell %u,%u is wrong\n", col, row);
+        return failures + 1;
+      }
+    }
+  }
+  return failures;
+}
+
+// Send to every due client for `millis` ms of 50 fps frames; slow clients'
+// sends take sendMicros, the others 100 us
+static void simulate(PreviewStream& stream, uint32_t millis, uint8_t slowClient, uint32_t sendMicros) {
+  uint32_t sequence = 0;
+  for (uint32_t now = 0; now < millis; now++) {
+    if (now % 20 == 0) {
+      sequence++;
+    }
+    for (uint8_t client = 0; client < PREVIEW_MAX_CLIENTS; client++) {
+      if (stream.due(client, sequence, now)) {
+        stream.sent(client, sequence, now, true, client == slowClient ? sendMicros : 100);
+      }
+    }
+  }
+}
+
+static int verifyRateLimits() {
+  int failures = 0;
+
+  // Each client gets its own FPS, capped, and never more than was rendered
+  PreviewStream stream;
+  stream.subscribe(0, 10, 0);
+  stream.subscribe(1, 25, 0);
+  stream.subscribe(2, 200, 0);
+  simulate(stream, 1000, 0xFF, 0);
+  uint32_t sent0 = stream.client(0).framesSent;
+  uint32_t sent1 = stream.client(1).framesSent;
+  uint32_t sent2 = stream.client(2).framesSent;
+  printf("preview at 10/25/200 fps of 50: %u/%u/%u frames sent, %u/%u/%u skipped\n",
+         sent0, sent1, sent2, stream.client(0).framesSkipped, stream.client(1).framesSkipped,
+         stream.client(2).framesSkipped);
+  if (sent0 < 9 || sent0 > 11 || sent1 < 20 || sent1 > 26 || sent2 > 51 ||
+      stream.client(2).fps != PREVIEW_MAX_FPS || stream.subscribers() != 3) {
+    printf("preview rate limits not applied\n");
+    failures++;
+  }
+
+  // An unchanged frame is not sent again
+  PreviewStream idle;
+  idle.subscribe(0, 30, 0);
+  for (uint32_t now = 0; now < 1000; now++) {
+    if (idle.due(0, 7, now)) {
+      idle.sent(0, 7, now, true, 100);
+    }
+  }
+  if (idle.client(0).framesSent != 1) {
+    printf("unchanged frame sent %u times\n", idle.client(0).framesSent);
+    failures++;
+  }
+
+  // Blocking sends slow only that client down; failures unsubscribe it
+  PreviewStream slow;
+  slow.subscribe(0, 25, 0);
+  slow.subscribe(1, 25, 0);
+  simulate(slow, 1000, 1, PREVIEW_SLOW_SEND_US);
+  printf("preview slow client: %u frames vs %u, backoff %u\n",
+         slow.client(1).framesSent, slow.client(0).framesSent, slow.client(1).backoff);
+  if (slow.client(1).framesSent * 4 > slow.client(0).framesSent ||
+      slow.client(1).backoff != PREVIEW_MAX_BACKOFF) {
+    printf("slow client was not backed off\n");
+    failures++;
+  }
+  for (uint8_t i = 0; i < PREVIEW_MAX_FAILURES; i++) {
+    slow.sent(1, 1000 + i, 2000, false, 0);
+  }
+  if (slow.client(1).fps != 0 || slow.subscribers() != 1 || slow.sendFailures != PREVIEW_MAX_FAILURES) {
+    printf("failing client was not unsubscribed\n");
+    failures++;
+  }
+  return failures;
+}
+
+int runPreviewBench(const BenchOptions& options) {
+  printf("\n");
+  int failures = verifyEncoding() + verifyRateLimits();
+  printf("frame preview: %s\n", failures == 0 ? "ok" : "FAILED");
+
+  static Frame frame;
+  static PreviewStream stream;
+  for (uint8_t client = 0; client < PREVIEW_MAX_CLIENTS; client++) {
+    stream.subscribe(client, 30, 0);
+  }
+
+  benchPrintHeader("frame preview (ns/frame)");
+  if (benchSelected(options, "encode preview")) {
+    benchPrintResult(benchRun("encode preview", options, []() {
+      uint8_t buffer[PREVIEW_FRAME_SIZE];
+      encodePreviewFrame(frame, 1, buffer);
+      sink = buffer[4];
+    }));
+  }
+  if (benchSelected(options, "due check, 8 clients")) {
+    benchPrintResult(benchRun("due check, 8 clients", options, []() {
+      uint32_t due = 0;
+      for (uint8_t client = 0; client < PREVIEW_MAX_CLIENTS; client++) {
+        due += stream.due(client, 1, 0);
+      }
+      sink = due;
+    }));
+  }
+
+  return failures;
+}
@@ -0,0 +1,133 @@
+/**
+ * WebSocket command decoding: binary frames and JSON fallback
+ */
+
+#include "bench.h"
+#include "patterns.h"
+#include "ws_protocol.h"
+#include <string>
+
+static volatile uint32_t sink;
+
+// Original handler: String copy, indexOf per command, substring for values
+static uint32_t legacyParse(const char* payload) {
+  std::string message(payload);
+  char command[32];
+  for (uint8_t i = 0; i < PATTERN_COUNT; i++) {
+    snprintf(command, sizeof(command), "\"command\":\"%s\"", getPattern(i).key);
+    if (message.find(command) != std::string::npos) {
+      return i;
+    }
+  }
+  if (message.find("\"command\":\"next\"") != std::string::npos) {
+    return 100;
+  }
+  if (message.find("\"command\":\"color\"") != std::string::npos) {
+    size_t start = message.find("\"value\":\"") + 9;
+    size_t end = message.find("\"", start);
+    return strtol(message.substr(start, end - start).c_str(), NULL, 16);
+  }
+  if (message.find("\"command\":\"brightness\"") != std::string::npos) {
+    size_t start = message.find("\"value\":") + 8;
+    size_t end = message.find("}", start);
+    return atoi(message.substr(start, end - start).c_str());
+  }
+  return 0;
+}
+
+static int verifyProtocol() {
+  int failures = 0;
+  WsCommand command;
+
+  // Every opcode survives a binary round trip
+  static const WsCommand samples[] = {
+    { WS_OP_SELECT_PATTERN, PATTERN_PULSE }, { WS_OP_NEXT, 0 }, { WS_OP_COLOR, 0x12AB34 },
+    { WS_OP_BRIGHTNESS, 200 }, { WS_OP_STATUS, 0 }, { WS_OP_AUTO_CYCLE, 0 },
+    { WS_OP_AUTO_CYCLE_INTERVAL, 123456 }, { WS_OP_LAYOUT, 2 }, { WS_OP_PREVIEW, 15 },
+    { WS_OP_TRANSITION, 1500 },
+  };
+  for (const WsCommand& sample : samples) {
+    uint8_t frame[8];
+    size_t length = encodeBinaryCommand(sample, frame, sizeof(frame));
+    if (length == 0 || !decodeBinaryCommand(frame, length, command) ||
+        command.opcode != sample.opcode || command.value != sample.value ||
+        decodeBinaryCommand(frame, length + 1, command) ||
+        (length > WS_HEADER_SIZE && decodeBinaryCommand(frame, length - 1, command))) {
+      printf("binary round trip failed for opcode %u\n", sample.opcode);
+      failures++;
+    }
+  }
+  static const uint8_t badFrames[][3] = { { 2, WS_OP_NEXT }, { 1, 0 }, { 1, WS_OP_COUNT } };
+  for (const uint8_t* bad : badFrames) {
+    if (decodeBinaryCommand(bad, WS_HEADER_SIZE, command)) {
+      printf("bad binary frame %u/%u was accepted\n", bad[0], bad[1]);
+      failures++;
+    }
+  }
+
+  // JSON as the web UI sends it, with spacing, key order and escapes varied
+  static const struct {
+    const char* text;
+    uint8_t opcode;
+    uint32_t value;
+  } jsonCases[] = {
+    { "{\"command\":\"fire\"}", WS_OP_SELECT_PATTERN, PATTERN_FIRE },
+    { "{\"command\":\"next\"}", WS_OP_NEXT, 0 },
+    { "{\"command\":\"color\",\"value\":\"ff8800\"}", WS_OP_COLOR, 0xFF8800 },
+    { " { \"value\" : 42 , \"command\" : \"brightness\" } ", WS_OP_BRIGHTNESS, 42 },
+    { "{\"command\":\"autoCycleInterval\",\"value\":9000}", WS_OP_AUTO_CYCLE_INTERVAL, 9000 },
+    { "{\"note\":\"a \\\"quoted\\\" }\",\"command\":\"autoCycle\"}", WS_OP_AUTO_CYCLE, 0 },
+  };
+  for (const auto& c : jsonCases) {
+    if (!parseJsonCommand(c.text, strlen(c.text), command) ||
+        command.opcode != c.opcode || command.value != c.value) {
+      printf("JSON command %s parsed wrong\n", c.text);
+      failures++;
+    }
+  }
+  static const char* const badJson[] = {
+    "", "{", "{\"command\":\"dance\"}", "{\"command\":\"color\",\"value\":\"zz\"}",
+    "{\"command\":\"brightness\"}", "{\"command\" \"next\"}", "{\"command\":\"next\"",
+    "{\"command\":\"rainbowx\"}", "{\"command\":\"brightness\",\"value\":99999999999}",
+  };
+  for (const char* bad : badJson) {
+    if (parseJsonCommand(bad, strlen(bad), command)) {
+      printf("bad JSON command %s was accepted\n", bad);
+      failures++;
+    }
+  }
+
+  printf("WebSocket protocol: %s\n", failures == 0 ? "ok" : "FAILED");
+  return failures;
+}
+
+int runProtocolBench(const BenchOptions& options) {
+  printf("\n");
+  int failures = verifyProtocol();
+
+  // A brightness slider tick in each form
+  static const char* json = "{\"command\":\"brightness\",\"value\":128}";
+  static uint8_t frame[8];
+  static size_t frameLength = encodeBinaryCommand({ WS_OP_BRIGHTNESS, 128 }, frame, sizeof(frame));
+
+  benchPrintHeader("WebSocket commands (ns/message)");
+  if (benchSelected(options, "legacy String/indexOf")) {
+    benchPrintResult(benchRun("legacy String/indexOf", options, []() {
+      sink = legacyParse(json);
+    }));
+  }
+  if (benchSelected(options, "JSON tokenizer")) {
+    benchPrintResult(benchRun("JSON tokenizer", options, []() {
+      WsCommand command;
+      sink = parseJsonCommand(json, strlen(json), command) ? command.value : 0;
+    }));
+  }
+  if (benchSelected(options, "binary frame")) {
+    benchPrintResult(benchRun("binary frame", options, []() {
+      WsCommand command;
+      sink = decodeBinaryCommand(frame, frameLength, command) ? command.value : 0;
+    }));
+  }
+
+  return failures;
+}
@@ -0,0 +1,138 @@
+/**
+ * Pattern random streams: replaying frames from a seed, independent
+ * streams, value ranges, and cost against Arduino's random()
+ */
+
+#include "bench.h"
+#include "patterns.h"
+#include <stdio.h>
+
+#define RANDOM_REPLAY_FRAMES  300
+
+static volatile uint32_t sink;
+
+// FNV-1a over `frames` frames of a pattern, restarted after seeding
+static uint32_t patternHash(uint8_t index, uint32_t seed, uint32_t frames) {
+  Pattern& pattern = getPattern(index);
+  Frame frame = {};
+  seedPatterns(seed);
+  pattern.reset();
+  uint32_t hash = 2166136261u;
+  for (uint32_t f = 0; f < frames; f++) {
+    pattern.render(frame);
+    const uint8_t* bytes = (const uint8_t*)frame.pixel;
+    for (size_t i = 0; i < sizeof(frame.pixel); i++) {
+      hash = (hash ^ bytes[i]) * 16777619u;
+    }
+  }
+  return hash;
+}
+
+static int verifyStreams() {
+  int failures = 0;
+  const uint8_t randomPatterns[] = { PATTERN_FIRE, PATTERN_MATRIX };
+
+  // The same seed replays the same frames, another seed does not
+  for (uint8_t index : randomPatterns) {
+    uint32_t first = patternHash(index, 42, RANDOM_REPLAY_FRAMES);
+    uint32_t replay = patternHash(index, 42, RANDOM_REPLAY_FRAMES);
+    uint32_t other = patternHash(index, 43, RANDOM_REPLAY_FRAMES);
+    if (first != replay || first == other) {
+      printf("%s: seed 42 %s, seed 43 %s\n", getPatternName(index),
+             first == replay ? "replays" : "does not replay", first == other ? "is the same" : "differs");
+      failures++;
+    }
+  }
+
+  // Rendering Fire in between (as in a crossfade) leaves Matrix alone
+  uint32_t alone = patternHash(PATTERN_MATRIX, 42, RANDOM_REPLAY_FRAMES);
+  Frame fireFrame = {}, matrixFrame = {};
+  seedPatterns(42);
+  getPattern(PATTERN_MATRIX).reset();
+  getPattern(PATTERN_FIRE).reset();
+  uint32_t hash = 2166136261u;
+  for (uint32_t f = 0; f < RANDOM_REPLAY_FRAMES; f++) {
+    getPattern(PATTERN_FIRE).render(fireFrame);
+    getPattern(PATTERN_MATRIX).render(matrixFrame);
+    const uint8_t* bytes = (const uint8_t*)matrixFrame.pixel;
+    for (size_t i = 0; i < sizeof(matrixFrame.pixel); i++) {
+      hash = (hash ^ bytes[i]) * 16777619u;
+    }
+  }
+  if (hash != alone) {
+    printf("Fire changed the Matrix sequence\n");
+    failures++;
+  }
+
+  // Ranges and a rough uniformity check
+  RandomStream stream;
+  stream.seed(1);
+  uint32_t buckets[10] = {};
+  bool inRange = true;
+  for (uint32_t i = 0; i < 100000; i++) {
+    buckets[stream.below(10)]++;
+    int32_t value = stream.between(-3, 4);
+    inRange = inRange && value >= -3 && value < 4;
+  }
+  for (uint32_t count : buckets) {
+    inRange = inRange && count > 9500 && count < 10500;
+  }
+  if (!inRange) {
+    printf("below()/between() out of range or uneven\n");
+    failures++;
+  }
+
+  // fill() gives the same bytes as next(), low byte first
+  RandomStream a, b;
+  a.seed(9);
+  b.seed(9);
+  uint8_t bytes[7];
+  a.fill(bytes, sizeof(bytes));
+  uint32_t first = b.next(), second = b.next();
+  if (bytes[0] != (uint8_t)first || bytes[3] != (uint8_t)(first >> 24) ||
+      bytes[4] != (uint8_t)second || bytes[6] != (uint8_t)(second >> 16) || a.next() != b.next()) {
+    printf("fill() does not match next()\n");
+    failures++;
+  }
+
+  seedPatterns(1);
+  printf("random streams: %s\n", failures == 0 ? "ok" : "FAILED");
+  return failures;
+}
+
+int runRandomBench(const BenchOptions& options) {
+  printf("\n");
+  int failures = verifyStreams();
+
+  // One value per pixel, as a frame would draw them
+  benchPrintHeader("random streams (ns per 60 values)");
+  if (benchSelected(options, "Arduino random(100)")) {
+    benchPrintResult(benchRun("Arduino random(100)", options, []() {
+      uint32_t sum = 0;
+      for (uint16_t i = 0; i < NUM_PIXELS; i++) {
+        sum += random(100);
+      }
+      sink = sum;
+    }));
+  }
+  if (benchSelected(options, "stream below(100)")) {
+    static RandomStream stream;
+    benchPrintResult(benchRun("stream below(100)", options, []() {
+      uint32_t sum = 0;
+      for (uint16_t i = 0; i < NUM_PIXELS; i++) {
+        sum += stream.below(100);
+      }
+      sink = sum;
+    }));
+  }
+  if (benchSelected(options, "stream fill 60 bytes")) {
+    static RandomStream stream;
+    benchPrintResult(benchRun("stream fill 60 bytes", options, []() {
+      uint8_t bytes[NUM_PIXELS];
+      stream.fill(bytes, sizeof(bytes));
+      sink = bytes[NUM_PIXELS - 1];
+    }));
+  }
+
+  return failures;
+}
@@ -0,0 +1,87 @@
+/**
+ * Original pattern math
+ */
+
+#include "reference_patterns.h"
+#include "patterns.h"
+#include "pixel_layout.h"
+
+void referenceWaveFrame(Adafruit_NeoPixel& strip, uint16_t offset) {
+  for (int col = 0; col < GRID_WIDTH; col++) {
+    for (int row = 0; row < GRID_HEIGHT; row++) {
+      uint16_t hue = ((offset * 300) - (col * 10922)) % 65536;
+      float wave = sin((row * 0.5 + offset * 0.1) * PI / 180.0);
+      uint8_t value = 200 + (wave * 55);
+      strip.setPixelColor(pixelLayout().pixelAt[col][row], strip.gamma32(strip.ColorHSV(hue, 255, value)));
+    }
+  }
+}
+
+void referencePulseFrame(Adafruit_NeoPixel& strip, uint16_t baseHue) {
+  strip.clear();
+  for (int col = 0; col < GRID_WIDTH; col++) {
+    for (int row = 0; row < GRID_HEIGHT; row++) {
+      float dx = col - (GRID_WIDTH - 1) / 2.0;
+      float dy = row - (GRID_HEIGHT - 1) / 2.0;
+      float distance = sqrt(dx * dx + dy * dy);
+
+      for (int ring = 0; ring < 20; ring++) {
+        float ringRadius = ring * 1.5;
+        if (abs(distance - ringRadius) < 0.2) {
+          uint16_t ringHue = (baseHue + ((19 - ring) * 3277)) % 65536;
+          strip.setPixelColor(pixelLayout().pixelAt[col][row], strip.ColorHSV(ringHue, 255, 255));
+          break;
+        }
+      }
+    }
+  }
+}
+
+void referenceMatrixFrame(Adafruit_NeoPixel& strip) {
+  for (int col = 0; col < GRID_WIDTH; col++) {
+    if (random(100) < 15) {
+      strip.setPixelColor(pixelLayout().pixelAt[col][0], strip.Color(0, 255, 0));
+    }
+    for (int row = GRID_HEIGHT - 1; row > 0; row--) {
+      uint32_t aboveColor = strip.getPixelColor(pixelLayout().pixelAt[col][row - 1]);
+      if (aboveColor != 0) {
+        strip.setPixelColor(pixelLayout().pixelAt[col][row], aboveColor);
+        strip.setPixelColor(pixelLayout().pixelAt[col][row - 1], 0);
+      }
+    }
+    uint16_t bottomPixel = pixelLayout().pixelAt[col][GRID_HEIGHT - 1];
+    uint32_t bottomColor = strip.getPixelColor(bottomPixel);
+    uint8_t green = (bottomColor >> 8) & 0xFF;
+    strip.setPixelColor(bottomPixel, 0, green > 20 ? green - 20 : 0, 0);
+  }
+}
+
+void referenceFireFrame(Adafruit_NeoPixel& strip, uint8_t step) {
+  // Grid cell of each strip index
+  uint8_t pixelCol[NUM_PIXELS], pixelRow[NUM_PIXELS];
+  for (uint8_t col = 0; col < GRID_WIDTH; col++) {
+    for (uint8_t row = 0; row < GRID_HEIGHT; row++) {
+      pixelCol[pixelLayout().pixelAt[col][row]] = col;
+      pixelRow[pixelLayout().pixelAt[col][row]] = row;
+    }
+  }
+  for (int i = 0; i < NUM_PIXELS; i++) {
+    uint8_t col = pixelCol[i];
+    uint8_t distanceFromBottom = GRID_HEIGHT - 1 - pixelRow[i];
+    uint8_t baseIntensity = max(0, 255 - (distanceFromBottom * 40));
+    uint8_t columnVariation = (col * 17 + step * 3) % 50;
+    baseIntensity = max(0, min(255, baseIntensity + columnVariation - 25));
+    uint16_t hue = distanceFromBottom < 3 ? 0 : distanceFromBottom < 6 ? 3000 : 6000;
+    if ((i * 13 + step * 7) % 100 < 15) {
+      uint16_t sparkleHues[] = {3000, 6000, 2500};
+      hue = sparkleHues[(i + step) % 3];
+      baseIntensity = min(255, baseIntensity + 50);
+    }
+    if (distanceFromBottom <= 2 && (i * 19 + step * 11) % 200 < 3) {
+      hue = 0;
+      baseIntensity = 255;
+    }
+    uint8_t saturation = max(200, 255 - (distanceFromBottom * 10));
+    strip.setPixelColor(i, strip.gamma32(strip.ColorHSV(hue, saturation, baseIntensity)));
+  }
+}
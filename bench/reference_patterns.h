@@ -0,0 +1,23 @@
+/**
+ * Original pattern math, kept as accuracy and cost references for the
+ * integer/table-driven versions in src/patterns.cpp
+ */
+
+#ifndef REFERENCE_PATTERNS_H
+#define REFERENCE_PATTERNS_H
+
+#include <Adafruit_NeoPixel.h>
+
+// Wave frame for a given waveOffset (sin() per pixel)
+void referenceWaveFrame(Adafruit_NeoPixel& strip, uint16_t offset);
+
+// Pulse frame for a given base hue (sqrt() per cell, float ring test)
+void referencePulseFrame(Adafruit_NeoPixel& strip, uint16_t baseHue);
+
+// Fire frame for a given step (modulo arithmetic, ColorHSV + gamma32)
+void referenceFireFrame(Adafruit_NeoPixel& strip, uint8_t step);
+
+// Matrix frame that keeps its drops in the strip and reads them back
+void referenceMatrixFrame(Adafruit_NeoPixel& strip);
+
+#endif // REFERENCE_PATTERNS_H
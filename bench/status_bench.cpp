@@ -0,0 +1,108 @@
+/**
+ * Status messages: serializer output, change-only broadcasting and cost
+ */
+
+#include "bench.h"
+#include "patterns.h"
+#include "status_report.h"
+#include <string>
+
+static volatile uint32_t sink;
+
+static const StatusState sampleState = {
+  PATTERN_WAVE, 0x0A0B0C, 64, false, 6000, 1234, 56,
+};
+
+// Original broadcastStatus(): string concatenation and manual hex padding
+static size_t legacyStatusJson(const StatusState& state) {
+  char hex[3];
+  std::string colorHex = "#";
+  for (int shift = 16; shift >= 0; shift -= 8) {
+    snprintf(hex, sizeof(hex), "%02X", (unsigned)((state.staticColor >> shift) & 0xFF));
+    colorHex += hex;
+  }
+  std::string json = "{\"type\":\"status\",\"mode\":\"" + std::string(getPatternName(state.pattern)) +
+                     "\",\"pattern\":" + std::to_string(state.pattern) + ",\"color\":\"" + colorHex +
+                     "\",\"brightness\":" + std::to_string(state.brightness) + ",\"autoCycle\":" +
+                     std::string(state.autoCycle ? "true" : "false") + ",\"autoCycleInterval\":" +
+                     std::to_string(state.autoCycleInterval) + "}";
+  return json.size();
+}
+
+static int verifyStatus() {
+  int failures = 0;
+  char json[STATUS_JSON_SIZE];
+
+  writeStatusJson(json, sizeof(json), sampleState, STATUS_SETTINGS | STATUS_FRAMES, 7);
+  const char* expected =
+    "{\"type\":\"status\",\"version\":7,\"mode\":\"Wave\",\"pattern\":2,\"color\":\"#0A0B0C\","
+    "\"brightness\":64,\"autoCycle\":false,\"autoCycleInterval\":6000,"
+    "\"framesRendered\":1234,\"framesPushed\":56}";
+  if (strcmp(json, expected) != 0) {
+    printf("status JSON was %s\n", json);
+    failures++;
+  }
+  if (writeStatusJson(json, 40, sampleState, STATUS_SETTINGS, 7) != 0) {
+    printf("status JSON overflowed a short buffer\n");
+    failures++;
+  }
+
+  // First poll sends everything, then only changes, at most every 100 ms
+  StatusBroadcaster broadcaster(100);
+  StatusState state = sampleState;
+  bool ok = broadcaster.poll(state, 0, json, sizeof(json)) > 0 && broadcaster.version == 1 &&
+            broadcaster.poll(state, 500, json, sizeof(json)) == 0;
+
+  state.brightness = 80;
+  ok = ok && broadcaster.poll(state, 510, json, sizeof(json)) > 0 &&
+       strcmp(json, "{\"type\":\"status\",\"version\":2,\"brightness\":80}") == 0;
+
+  // A burst of slider moves inside the interval collapses into one message
+  for (uint8_t b = 81; b <= 120; b++) {
+    state.brightness = b;
+    ok = ok && broadcaster.poll(state, 520 + b - 81, json, sizeof(json)) == 0;
+  }
+  state.staticColor = 0xFFFFFF;
+  ok = ok && broadcaster.poll(state, 610, json, sizeof(json)) > 0 &&
+       strcmp(json, "{\"type\":\"status\",\"version\":3,\"color\":\"#FFFFFF\",\"brightness\":120}") == 0 &&
+       broadcaster.messagesSent == 3;
+
+  // Frame counters never trigger a broadcast
+  state.framesRendered += 100;
+  ok = ok && broadcaster.poll(state, 1000, json, sizeof(json)) == 0;
+  if (!ok) {
+    printf("status broadcaster sent %s\n", json);
+    failures++;
+  }
+
+  printf("status messages: %s\n", failures == 0 ? "ok" : "FAILED");
+  return failures;
+}
+
+int runStatusBench(const BenchOptions& options) {
+  printf("\n");
+  int failures = verifyStatus();
+
+  benchPrintHeader("status messages (ns/message)");
+  if (benchSelected(options, "legacy String concat")) {
+    benchPrintResult(benchRun("legacy String concat", options, []() {
+      sink = legacyStatusJson(sampleState);
+    }));
+  }
+  if (benchSelected(options, "writeStatusJson full")) {
+    benchPrintResult(benchRun("writeStatusJson full", options, []() {
+      char json[STATUS_JSON_SIZE];
+      sink = writeStatusJson(json, sizeof(json), sampleState, STATUS_SETTINGS, 1);
+    }));
+  }
+  if (benchSelected(options, "poll, nothing changed")) {
+    static StatusBroadcaster broadcaster(100);
+    static char json[STATUS_JSON_SIZE];
+    broadcaster.poll(sampleState, 0, json, sizeof(json));
+    benchPrintResult(benchRun("poll, nothing changed", options, []() {
+      sink = broadcaster.poll(sampleState, 1000, json, sizeof(json));
+    }));
+  }
+
+  return failures;
+}
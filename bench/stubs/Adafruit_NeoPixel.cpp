@@ -0,0 +1,157 @@
+/**
+ * Host-native Adafruit_NeoPixel frame buffer
+ *
+ * Color math mirrors Adafruit NeoPixel 1.12 so frames match the device.
+ */
+
+#include "Adafruit_NeoPixel.h"
+
+// Gamma 2.6 table, same contents as _NeoPixelGammaTable in the library
+static const uint8_t gammaTable[256] = {
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   1,   1,   1,   1,   1,   1,   1,   1,
+      1,   1,   1,   1,   2,   2,   2,   2,   2,   2,   2,   2,   3,   3,   3,   3,
+      3,   3,   4,   4,   4,   4,   5,   5,   5,   5,   5,   6,   6,   6,   6,   7,
+      7,   7,   8,   8,   8,   9,   9,   9,  10,  10,  10,  11,  11,  11,  12,  12,
+     13,  13,  13,  14,  14,  15,  15,  16,  16,  17,  17,  18,  18,  19,  19,  20,
+     20,  21,  21,  22,  22,  23,  24,  24,  25,  25,  26,  27,  27,  28,  29,  29,
+     30,  31,  31,  32,  33,  34,  34,  35,  36,  37,  38,  38,  39,  40,  41,  42,
+     42,  43,  44,  45,  46,  47,  48,  49,  50,  51,  52,  53,  54,  55,  56,  57,
+     58,  59,  60,  61,  62,  63,  64,  65,  66,  68,  69,  70,  71,  72,  73,  75,
+     76,  77,  78,  80,  81,  82,  84,  85,  86,  88,  89,  90,  92,  93,  94,  96,
+     97,  99, 100, 102, 103, 105, 106, 108, 109, 111, 112, 114, 115, 117, 119, 120,
+    122, 124, 125, 127, 129, 130, 132, 134, 136, 137, 139, 141, 143, 145, 146, 148,
+    150, 152, 154, 156, 158, 160, 162, 164, 166, 168, 170, 172, 174, 176, 178, 180,
+    182, 184, 186, 188, 191, 193, 195, 197, 199, 202, 204, 206, 209, 211, 213, 215,
+    218, 220, 223, 225, 227, 230, 232, 235, 237, 240, 242, 245, 247, 250, 252, 255,
+};
+
+Adafruit_NeoPixel::Adafruit_NeoPixel(uint16_t n, int16_t, neoPixelType)
+    : numLEDs(n), numBytes(n * 3), brightness(0) {
+  pixels = (uint8_t *)calloc(numBytes, 1);
+}
+
+Adafruit_NeoPixel::~Adafruit_NeoPixel() {
+  free(pixels);
+}
+
+void Adafruit_NeoPixel::setPixelColor(uint16_t n, uint8_t r, uint8_t g, uint8_t b) {
+  if (n < numLEDs) {
+    if (brightness) { // See notes in setBrightness()
+      r = (r * brightness) >> 8;
+      g = (g * brightness) >> 8;
+      b = (b * brightness) >> 8;
+    }
+    uint8_t *p = &pixels[n * 3];
+    p[0] = r;
+    p[1] = g;
+    p[2] = b;
+  }
+}
+
+void Adafruit_NeoPixel::setPixelColor(uint16_t n, uint32_t c) {
+  setPixelColor(n, (uint8_t)(c >> 16), (uint8_t)(c >> 8), (uint8_t)c);
+}
+
+void Adafruit_NeoPixel::fill(uint32_t c, uint16_t first, uint16_t count) {
+  if (first >= numLEDs) return;
+  uint16_t end = (count == 0) ? numLEDs : first + count;
+  if (end > numLEDs) end = numLEDs;
+  for (uint16_t i = first; i < end; i++) {
+    setPixelColor(i, c);
+  }
+}
+
+// Stored brightness is the requested value + 1 so that 0 means "no scaling"
+// and the scale can be applied with a shift instead of a divide.
+void Adafruit_NeoPixel::setBrightness(uint8_t b) {
+  uint8_t newBrightness = b + 1;
+  if (newBrightness != brightness) {
+    uint8_t oldBrightness = brightness - 1;
+    uint16_t scale;
+    if (oldBrightness == 0) {
+      scale = 0; // Avoid /0
+    } else if (b == 255) {
+      scale = 65535 / oldBrightness;
+    } else {
+      scale = (((uint16_t)newBrightness << 8) - 1) / oldBrightness;
+    }
+    for (uint16_t i = 0; i < numBytes; i++) {
+      pixels[i] = (pixels[i] * scale) >> 8;
+    }
+    brightness = newBrightness;
+  }
+}
+
+void Adafruit_NeoPixel::clear() {
+  memset(pixels, 0, numBytes);
+}
+
+uint32_t Adafruit_NeoPixel::getPixelColor(uint16_t n) const {
+  if (n >= numLEDs) return 0;
+  const uint8_t *p = &pixels[n * 3];
+  if (brightness) {
+    // Lossy: the stored value was scaled down by setPixelColor()
+    return (((uint32_t)(p[0] << 8) / brightness) << 16) |
+           (((uint32_t)(p[1] << 8) / brightness) << 8) |
+           ((uint32_t)(p[2] << 8) / brightness);
+  }
+  return ((uint32_t)p[0] << 16) | ((uint32_t)p[1] << 8) | p[2];
+}
+
+uint8_t Adafruit_NeoPixel::gamma8(uint8_t x) {
+  return gammaTable[x];
+}
+
+uint32_t Adafruit_NeoPixel::gamma32(uint32_t x) {
+  uint8_t *y = (uint8_t *)&x;
+  for (uint8_t i = 0; i < 4; i++) y[i] = gamma8(y[i]);
+  return x;
+}
+
+uint32_t Adafruit_NeoPixel::ColorHSV(uint16_t hue, uint8_t sat, uint8_t val) {
+  uint8_t r, g, b;
+
+  // Remap 0-65535 to 0-1529 (six 255-step sextants, rounded)
+  hue = (hue * 1530L + 32768) / 65536;
+
+  if (hue < 510) {         // Red to Green-1
+    b = 0;
+    if (hue < 255) {       //   Red to Yellow-1
+      r = 255;
+      g = hue;
+    } else {               //   Yellow to Green-1
+      r = 510 - hue;
+      g = 255;
+    }
+  } else if (hue < 1020) { // Green to Blue-1
+    r = 0;
+    if (hue < 765) {       //   Green to Cyan-1
+      g = 255;
+      b = hue - 510;
+    } else {               //   Cyan to Blue-1
+      g = 1020 - hue;
+      b = 255;
+    }
+  } else if (hue < 1530) { // Blue to Red-1
+    g = 0;
+    if (hue < 1275) {      //   Blue to Magenta-1
+      r = hue - 1020;
+      b = 255;
+    } else {               //   Magenta to Red-1
+      r = 255;
+      b = 1530 - hue;
+    }
+  } else {                 // Last 0.5 Red
+    r = 255;
+    g = b = 0;
+  }
+
+  // Apply saturation and value to R,G,B, pack into 32-bit result
+  uint32_t v1 = 1 + val;  // 1 to 256; allows >>8 instead of /255
+  uint16_t s1 = 1 + sat;  // 1 to 256; same reason
+  uint8_t s2 = 255 - sat; // 255 to 0
+  return ((((((r * s1) >> 8) + s2) * v1) & 0xff00) << 8) |
+         (((((g * s1) >> 8) + s2) * v1) & 0xff00) |
+         (((((b * s1) >> 8) + s2) * v1) >> 8);
+}
@@ -0,0 +1,56 @@
+/**
+ * Adafruit_NeoPixel stand-in for the host-native build
+ *
+ * Keeps an in-memory frame buffer with the same color packing, HSV
+ * conversion, gamma table and brightness scaling as the real library,
+ * so patterns render bit-identical frames. show() only counts frames.
+ */
+
+#ifndef NATIVE_ADAFRUIT_NEOPIXEL_H
+#define NATIVE_ADAFRUIT_NEOPIXEL_H
+
+#include <Arduino.h>
+
+typedef uint16_t neoPixelType;
+
+#define NEO_RGB  ((0 << 6) | (0 << 4) | (1 << 2) | (2))
+#define NEO_GRB  ((1 << 6) | (1 << 4) | (0 << 2) | (2))
+#define NEO_KHZ800 0x0000
+
+class Adafruit_NeoPixel {
+public:
+  Adafruit_NeoPixel(uint16_t n, int16_t pin = 6, neoPixelType type = NEO_GRB + NEO_KHZ800);
+  ~Adafruit_NeoPixel();
+
+  void begin() {}
+  void show() { showCount++; }
+  void setPin(int16_t) {}
+  void setPixelColor(uint16_t n, uint8_t r, uint8_t g, uint8_t b);
+  void setPixelColor(uint16_t n, uint32_t c);
+  void fill(uint32_t c = 0, uint16_t first = 0, uint16_t count = 0);
+  void setBrightness(uint8_t b);
+  void clear();
+  uint8_t *getPixels() const { return pixels; }
+  uint8_t getBrightness() const { return brightness - 1; }
+  uint16_t numPixels() const { return numLEDs; }
+  uint32_t getPixelColor(uint16_t n) const;
+  bool canShow() const { return true; }
+
+  static uint8_t gamma8(uint8_t x);
+  static uint32_t gamma32(uint32_t x);
+  static uint32_t Color(uint8_t r, uint8_t g, uint8_t b) {
+    return ((uint32_t)r << 16) | ((uint32_t)g << 8) | b;
+  }
+  static uint32_t ColorHSV(uint16_t hue, uint8_t sat = 255, uint8_t val = 255);
+
+  // Host-only: number of show() calls since construction
+  uint32_t showCount = 0;
+
+private:
+  uint16_t numLEDs;
+  uint16_t numBytes;
+  uint8_t brightness;
+  uint8_t *pixels;    // 3 bytes per pixel, stored R, G, B
+};
+
+#endif // NATIVE_ADAFRUIT_NEOPIXEL_H
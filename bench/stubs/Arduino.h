@@ -0,0 +1,70 @@
+/**
+ * Minimal Arduino core stand-in for the host-native build
+ *
+ * Only what the portable sources under src/ use is provided. Timing is
+ * backed by std::chrono and Serial output is formatted and discarded,
+ * so the formatting cost still shows up in the benchmark.
+ */
+
+#ifndef NATIVE_ARDUINO_H
+#define NATIVE_ARDUINO_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+#include <cmath>
+
+using std::abs;
+using std::max;
+using std::min;
+
+#define PI          3.1415926535897932384626433832795
+#define HALF_PI     1.5707963267948966192313216916398
+#define TWO_PI      6.283185307179586476925286766559
+#define DEG_TO_RAD  0.017453292519943295769236907684886
+
+#define HIGH        0x1
+#define LOW         0x0
+#define INPUT       0x01
+#define OUTPUT      0x03
+#define INPUT_PULLUP 0x05
+
+#define HEX         16
+#define DEC         10
+
+// Timing (milliseconds/microseconds since process start)
+uint32_t millis();
+uint32_t micros();
+void delay(uint32_t ms);
+void delayMicroseconds(uint32_t us);
+
+// Random numbers
+void randomSeed(unsigned long seed);
+long random(long howbig);
+long random(long howsmall, long howbig);
+
+// GPIO (no-ops on the host)
+inline void pinMode(uint8_t, uint8_t) {}
+inline int digitalRead(uint8_t) { return HIGH; }
+inline void digitalWrite(uint8_t, uint8_t) {}
+inline uint16_t analogRead(uint8_t) { return 0; }
+
+// Serial port - formats into a scratch buffer and drops the result
+class HardwareSerial {
+public:
+  void begin(unsigned long) {}
+  size_t printf(const char* format, ...) __attribute__((format(printf, 2, 3)));
+  size_t print(const char* s) { return strlen(s); }
+  size_t println(const char* s = "") { return strlen(s) + 2; }
+  size_t write(const uint8_t*, size_t size) { return size; }
+  int availableForWrite() { return 64; }
+};
+
+extern HardwareSerial Serial;
+
+#endif // NATIVE_ARDUINO_H
@@ -0,0 +1,201 @@
+/**
+ * Pattern crossfades: transition timing, frames handed to another task,
+ * and the cost of a frame that renders two patterns against the frame
+ * budget
+ */
+
+#include "bench.h"
+#include "patterns.h"
+#include <stdio.h>
+#include <atomic>
+#include <thread>
+
+#define HANDOVER_FRAMES   20000   // Frames rendered while another thread copies
+
+static volatile uint32_t sink;
+
+// Transition length, layer frame rates and the frame it ends on
+static int verifyTransition() {
+  int failures = 0;
+  PatternEngine& engine = patternEngine;
+  uint32_t savedColor = staticColor;
+  uint32_t now = 100000;
+
+  engine.setTransition(0);
+  engine.select(PATTERN_PULSE);
+  engine.update(now);
+  engine.setTransition(500);
+
+  // Pulse (20 ms) -> Wave (50 ms): each layer at its own rate, blended
+  // whenever either renders
+  uint32_t pulseFrames = getPattern(PATTERN_PULSE).frameCount;
+  uint32_t waveFrames = getPattern(PATTERN_WAVE).frameCount;
+  engine.select(PATTERN_WAVE);
+  uint32_t start = now;
+  uint32_t blended = 0;
+  while (engine.transitioning() && now - start < 2000) {
+    if (engine.update(now)) {
+      blended++;
+    }
+    now++;
+  }
+  uint32_t took = now - 1 - start;
+  pulseFrames = getPattern(PATTERN_PULSE).frameCount - pulseFrames;
+  waveFrames = getPattern(PATTERN_WAVE).frameCount - waveFrames;
+  if (took != 500 || blended != 31 || pulseFrames != 26 || waveFrames != 11 ||
+      engine.millisUntilNextFrame(now) != 49) {
+    printf("Pulse->Wave: %u ms, %u blended frames, %u Pulse and %u Wave renders\n", took, blended,
+           pulseFrames, waveFrames);
+    failures++;
+  }
+
+  // Wave -> Static blue: blended on the way, the static color at the end
+  staticColor = 0x0000FF;
+  engine.select(PATTERN_STATIC);
+  engine.update(now += 20);
+  engine.update(now += 200);
+  bool blending = engine.transitioning() && color8(engine.currentFrame().pixel[0]) != 0x0000FF;
+  engine.update(now += 400);
+  if (!blending || engine.transitioning() || color8(engine.currentFrame().pixel[0]) != 0x0000FF) {
+    printf("Wave->Static did not end on the static color (0x%06X)\n", color8(engine.currentFrame().pixel[0]));
+    failures++;
+  }
+
+  // A layout change cancels the crossfade
+  engine.select(PATTERN_RAINBOW);
+  engine.update(now += 20);
+  engine.restart();
+  if (engine.transitioning()) {
+    printf("restart() left the transition running\n");
+    failures++;
+  }
+
+  engine.setTransition(0);
+  engine.select(PATTERN_WAVE);
+  staticColor = savedColor;
+  return failures;
+}
+
+// One thread renders solid frames of changing colors while another copies
+// them with copyFrame(): every copy is a single color
+static int verifyFrameHandover() {
+  PatternEngine& engine = patternEngine;
+  uint32_t savedColor = staticColor;
+  engine.setTransition(0);
+  engine.select(PATTERN_STATIC);
+  std::atomic<bool> rendering{true};
+  uint32_t copies = 0, torn = 0;
+
+  std::thread renderer([&engine, &rendering]() {
+    for (uint32_t f = 0; f < HANDOVER_FRAMES; f++) {
+      staticColor = (f * 0x010305) & 0xFFFFFF;
+      engine.requestFrame();
+      engine.update(f);
+      if (f % 64 == 0) {
+        engine.restart();
+      }
+    }
+    rendering = false;
+  });
+  Frame frame;
+  while (rendering) {
+    engine.copyFrame(frame);
+    for (uint16_t i = 1; i < NUM_PIXELS; i++) {
+      if (frame.pixel[i] != frame.pixel[0]) {
+        torn++;
+        break;
+      }
+    }
+    copies++;
+  }
+  renderer.join();
+
+  printf("frame handover: %u frames rendered, %u copies, %u torn\n", HANDOVER_FRAMES, copies, torn);
+  engine.select(PATTERN_WAVE);
+  staticColor = savedColor;
+  return torn != 0 ? 1 : 0;
+}
+
+// ns per transition frame in which both layers render, over `frames`
+static double transitionFrameNs(uint8_t from, uint8_t to, uint32_t frames) {
+  PatternEngine& engine = patternEngine;
+  uint32_t now = 0;
+  engine.setTransition(0);
+  engine.select(from);
+  engine.update(now);
+  engine.setTransition(TRANSITION_MAX_MILLIS);
+  engine.select(to);
+
+  // Steps of the longer interval, so both layers render every frame
+  uint16_t step = getPattern(from).frameInterval > getPattern(to).frameInterval
+                ? getPattern(from).frameInterval : getPattern(to).frameInterval;
+  auto begin = std::chrono::steady_clock::now();
+  for (uint32_t i = 0; i < frames; i++) {
+    engine.update(now += step);
+  }
+  auto end = std::chrono::steady_clock::now();
+  return (double)std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count() / frames;
+}
+
+static uint16_t budgetMillis(uint8_t from, uint8_t to) {
+  uint16_t a = getPattern(from).frameInterval;
+  uint16_t b = getPattern(to).frameInterval;
+  return a < b ? a : b;
+}
+
+int runTransitionBench(const BenchOptions& options) {
+  printf("\n");
+  int failures = verifyTransition();
+  failures += verifyFrameHandover();
+
+  // Every pair of cycling patterns; the budget is the blend interval
+  uint8_t worstFrom = 0, worstTo = 0;
+  double worstShare = 0, worstNs = 0;
+  for (uint8_t from = 0; from < PATTERN_COUNT; from++) {
+    for (uint8_t to = 0; to < PATTERN_COUNT; to++) {
+      if (from == to || !getPattern(from).inCycle() || !getPattern(to).inCycle()) {
+        continue;
+      }
+      double ns = transitionFrameNs(from, to, 200);
+      double share = ns / (budgetMillis(from, to) * 1e6);
+      if (share > worstShare) {
+        worstShare = share;
+        worstNs = ns;
+        worstFrom = from;
+        worstTo = to;
+      }
+    }
+  }
+  printf("worst crossfade: %s->%s, %.0f ns/frame, %.4f%% of its %u ms frame budget\n",
+         getPatternName(worstFrom), getPatternName(worstTo), worstNs, worstShare * 100,
+         budgetMillis(worstFrom, worstTo));
+  if (worstShare >= 1) {
+    failures++;
+  }
+  patternEngine.setTransition(0);
+  patternEngine.select(PATTERN_WAVE);
+  printf("pattern transitions: %s\n", failures == 0 ? "ok" : "FAILED");
+
+  benchPrintHeader("pattern transitions (ns/frame)");
+  if (benchSelected(options, "Pulse->Wave frame")) {
+    static uint32_t now = 0;
+    patternEngine.setTransition(0);
+    patternEngine.select(PATTERN_PULSE);
+    patternEngine.update(now);
+    patternEngine.setTransition(TRANSITION_MAX_MILLIS);
+    patternEngine.select(PATTERN_WAVE);
+    benchPrintResult(benchRun("Pulse->Wave frame", options, []() {
+      // Start another crossfade when one ends; both layers render every frame
+      if (!patternEngine.transitioning()) {
+        patternEngine.select(PATTERN_PULSE);
+        patternEngine.select(PATTERN_WAVE);
+      }
+      patternEngine.update(now += 50);
+      sink = patternEngine.currentFrame().pixel[0].r;
+    }));
+    patternEngine.setTransition(0);
+    patternEngine.select(PATTERN_WAVE);
+  }
+
+  return failures;
+}
@@ -0,0 +1,114 @@
+/**
+ * Stored animations: compact frame container and streaming player
+ *
+ * Animations are prepared on a PC (tools/animation_converter.py) and
+ * stored on LittleFS. Playing one only decodes bytes (the native benchmark
+ * holds each frame to a fixed decode budget), and frames are read through
+ * a small read-ahead buffer, so the file is never loaded into RAM.
+ *
+ * File layout (little-endian):
+ *   header   "LANI", u8 version, u8 width, u8 height, u8 flags,
+ *            u16 frame interval (ms), u16 keyframe interval (frames,
+ *            0 = first frame only), u32 frame count
+ *   records  u8 flags (ANIMATION_KEYFRAME), u16 payload length, payload
+ *
+ * A payload is a list of tokens over the grid cells, row by row from the
+ * top left (so files do not depend on the wiring). Each token is one
+ * byte: the top two bits are the op, the low six bits the count - 1:
+ *   LITERAL  count RGB triplets follow
+ *   RUN      one RGB triplet for count cells
+ *   SKIP     count cells keep their color from the previous frame
+ * Keyframes use no SKIP, so playback can (re)start on them.
+ */
+
+#ifndef ANIMATION_H
+#define ANIMATION_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "frame_output.h"
+
+#define ANIMATION_FILE          "/animation.lani"
+#define ANIMATION_VERSION       1
+#define ANIMATION_HEADER_SIZE   16
+#define ANIMATION_RECORD_HEADER 3
+#define ANIMATION_MAX_RECORD    (ANIMATION_RECORD_HEADER + NUM_PIXELS * 4)
+#define ANIMATION_READ_AHEAD    512     // Bytes buffered from the file
+#define ANIMATION_TICK          10      // Animation pattern frame interval (ms)
+
+// Header flags
+#define ANIMATION_LOOP          0x01
+
+// Record flags
+#define ANIMATION_KEYFRAME      0x01
+
+// Token ops
+#define ANIMATION_OP_LITERAL    0x00
+#define ANIMATION_OP_RUN        0x40
+#define ANIMATION_OP_SKIP       0x80
+#define ANIMATION_OP_MASK       0xC0
+#define ANIMATION_MAX_COUNT     64
+
+struct AnimationHeader {
+  uint8_t flags;
+  uint16_t frameInterval;     // ms
+  uint16_t keyframeInterval;  // Frames between keyframes, 0 = first only
+  uint32_t frameCount;
+};
+
+// Parse a file header; false if it is not an animation for this grid
+bool parseAnimationHeader(const uint8_t* data, size_t length, AnimationHeader& header);
+
+// Write a header for this grid; returns ANIMATION_HEADER_SIZE
+size_t writeAnimationHeader(const AnimationHeader& header, uint8_t* buffer);
+
+// Encode one frame as a record. cells holds 0xRRGGBB per grid cell, row by
+// row; previous is the frame before it (ignored for a keyframe). buffer
+// must hold ANIMATION_MAX_RECORD bytes. Returns the record length.
+size_t encodeAnimationFrame(const uint32_t* previous, const uint32_t* cells, bool keyframe,
+                            uint8_t* buffer);
+
+// Apply a record payload to a frame (through the pixel layout's cell
+// table); false if the payload is malformed
+bool decodeAnimationFrame(const uint8_t* payload, size_t length, Frame& frame);
+
+// Where the player reads the file from (LittleFS on the device)
+class AnimationSource {
+public:
+  virtual ~AnimationSource() {}
+  virtual bool seek(uint32_t position) = 0;
+  virtual size_t read(uint8_t* buffer, size_t size) = 0;
+};
+
+class AnimationPlayer {
+public:
+  // Read the header and stop at the first frame; false if the file is
+  // missing or not an animation for this grid
+  bool open(AnimationSource* source);
+  bool isOpen() const { return source != nullptr; }
+  const AnimationHeader& header() const { return info; }
+
+  // Decode the next frame into frame, wrapping to the first frame of a
+  // looping animation. Returns false at the end or on a damaged file
+  // (the player is closed then).
+  bool nextFrame(Frame& frame);
+
+  uint32_t frameIndex = 0;    // Frames decoded since the last wrap
+  uint32_t sourceReads = 0;   // read() calls on the source
+  uint32_t bytesRead = 0;
+
+private:
+  bool fill(size_t needed);
+  bool rewind();
+
+  AnimationSource* source = nullptr;
+  AnimationHeader info = {};
+  uint8_t buffer[ANIMATION_READ_AHEAD];
+  uint16_t start = 0;         // Unread bytes: buffer[start, end)
+  uint16_t end = 0;
+};
+
+// File played by the Animation pattern, null if there is none
+extern AnimationSource* animationSource;
+
+#endif // ANIMATION_H
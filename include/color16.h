@@ -0,0 +1,62 @@
+/**
+ * 16-bit-per-channel colors for the frame buffer
+ *
+ * Patterns render with 16 bits per channel so that gamma and brightness
+ * do not throw away the low bits of dim gradients. FrameOutput brings
+ * them down to 8 bits with temporal dithering on the way to the strip.
+ *
+ * 0xFFFF is full on. An 8-bit channel v widens to v * 257, so 8-bit
+ * colors (staticColor, DDP, stored animations) survive the round trip
+ * exactly.
+ */
+
+#ifndef COLOR16_H
+#define COLOR16_H
+
+#include <stdint.h>
+
+#define COLOR16_ONE       0xFFFF  // Full channel
+#define COLOR16_ALPHA_ONE 256     // Blend alpha that gives the second color
+
+struct Color16 {
+  uint16_t r;
+  uint16_t g;
+  uint16_t b;
+};
+
+inline bool operator==(const Color16& a, const Color16& b) {
+  return a.r == b.r && a.g == b.g && a.b == b.b;
+}
+
+inline bool operator!=(const Color16& a, const Color16& b) {
+  return !(a == b);
+}
+
+inline bool isBlack(const Color16& color) {
+  return (color.r | color.g | color.b) == 0;
+}
+
+// Widen a packed 0xRRGGBB color
+inline Color16 color16(uint32_t rgb) {
+  return { (uint16_t)(((rgb >> 16) & 0xFF) * 257), (uint16_t)(((rgb >> 8) & 0xFF) * 257),
+           (uint16_t)((rgb & 0xFF) * 257) };
+}
+
+// One channel rounded to 8 bits, the exact inverse of v * 257
+inline uint8_t channel8(uint16_t value) {
+  return (value - (value >> 8) + 128) >> 8;
+}
+
+// Packed 0xRRGGBB, rounded (preview, recordings)
+inline uint32_t color8(const Color16& color) {
+  return ((uint32_t)channel8(color.r) << 16) | ((uint32_t)channel8(color.g) << 8) | channel8(color.b);
+}
+
+// a * (1 - alpha) + b * alpha per channel, alpha in 1/256 steps
+inline Color16 color16Lerp(const Color16& a, const Color16& b, uint16_t alpha) {
+  uint32_t keep = COLOR16_ALPHA_ONE - alpha;
+  return { (uint16_t)((a.r * keep + b.r * alpha) >> 8), (uint16_t)((a.g * keep + b.g * alpha) >> 8),
+           (uint16_t)((a.b * keep + b.b * alpha) >> 8) };
+}
+
+#endif // COLOR16_H
@@ -0,0 +1,67 @@
+/**
+ * Table-driven integer color engine
+ *
+ * The ESP32C3 has no FPU, so the render hot path avoids float math:
+ * - colorHSV()/colorHSVGamma() use a precomputed hue -> RGB table and
+ *   give the same result as Adafruit_NeoPixel::ColorHSV() (and gamma32())
+ * - colorHSVGamma16() keeps 16 bits per channel through value and gamma,
+ *   for the frame buffer (color16.h)
+ * - isin16() is a quarter-wave sine table with linear interpolation
+ */
+
+#ifndef COLOR_ENGINE_H
+#define COLOR_ENGINE_H
+
+#include <stdint.h>
+#include "color16.h"
+
+// Hue wheel resolution used by Adafruit_NeoPixel::ColorHSV (6 x 255 steps)
+#define HUE_STEPS       1530
+
+// Sine output scale: isin16() returns sin(angle) * SIN_ONE
+#define SIN_ONE         32767
+
+// Fully saturated, full value color for each hue step (before gamma)
+struct HueColor {
+  uint8_t r;
+  uint8_t g;
+  uint8_t b;
+};
+
+struct HueWheel {
+  HueColor colors[HUE_STEPS + 1];
+};
+
+extern const HueWheel hueWheel;         // Generated at compile time
+extern const uint8_t gammaTable[256];   // Gamma 2.6, same as Adafruit_NeoPixel::gamma8()
+extern const uint16_t gammaTable16[257]; // Gamma 2.6 of i / 256, scaled to COLOR16_ONE
+extern const int16_t sineTable[257];    // First quadrant of sin(), scaled to SIN_ONE
+
+// Map a 16-bit hue (0-65535) to its hueWheel index, rounded like ColorHSV()
+inline uint16_t hueIndex(uint16_t hue) {
+  return (uint16_t)(((uint32_t)hue * HUE_STEPS + 32768) >> 16);
+}
+
+// Packed 0xRRGGBB color, identical to Adafruit_NeoPixel::ColorHSV()
+uint32_t colorHSV(uint16_t hue, uint8_t sat = 255, uint8_t val = 255);
+
+// Packed 0xRRGGBB color, identical to gamma32(ColorHSV(hue, sat, val))
+uint32_t colorHSVGamma(uint16_t hue, uint8_t sat = 255, uint8_t val = 255);
+
+// colorHSVGamma() before rounding to 8 bits: value and gamma at 16 bits
+Color16 colorHSVGamma16(uint16_t hue, uint8_t sat = 255, uint8_t val = 255);
+
+// Gamma 2.6 of a 16-bit linear channel, interpolated from gammaTable16
+uint16_t gamma16(uint16_t linear);
+
+// Sine of a binary angle (65536 = one full turn), scaled to +/-SIN_ONE
+int16_t isin16(uint16_t angle);
+
+// Convert tenths of a degree to a binary angle (65536 = 360 degrees)
+inline uint16_t decidegreesToAngle(uint32_t decidegrees) {
+  // 1193046 = 2^32 / 3600, so the rounded product of a wrapped value
+  // still fits in 32 bits
+  return (uint16_t)(((decidegrees % 3600) * 1193046UL + 32768) >> 16);
+}
+
+#endif // COLOR_ENGINE_H
@@ -0,0 +1,112 @@
+/**
+ * DDP pixel stream receiver with a jitter buffer
+ *
+ * A host PC renders the animation and sends raw frames over UDP using
+ * the Distributed Display Protocol (port 4048, as sent by xLights, WLED
+ * and others). Packets carry strip-order RGB bytes at a byte offset; the
+ * packet with the PUSH flag completes a frame. The External pattern polls
+ * the socket from the render task and shows one frame per poll.
+ *
+ * Payloads are received straight into a jitter buffer slot (the header is
+ * peeked first), so no packet buffer is allocated or copied. Frames wait
+ * DDP_JITTER_DELAY_MS before they are shown, which absorbs WiFi arrival
+ * jitter and lets out-of-order frames be put back in sequence. DDP's
+ * 4-bit sequence number (1-15, 0 = unused) is used to drop duplicates and
+ * packets older than the frame already shown.
+ *
+ * The socket is bound to all interfaces, which in AP mode is the SoftAP.
+ */
+
+#ifndef DDP_RECEIVER_H
+#define DDP_RECEIVER_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "frame_output.h"
+
+#define DDP_PORT              4048
+#define DDP_HEADER_SIZE       10
+#define DDP_FRAME_BYTES       (NUM_PIXELS * 3)
+#define DDP_JITTER_SLOTS      4       // Frames buffered (including one being received)
+#define DDP_JITTER_DELAY_MS   20      // Time each frame is held before it is shown
+#define DDP_POLL_INTERVAL     10      // External pattern frame interval (ms)
+
+// Header byte 0
+#define DDP_FLAG_VERSION_MASK 0xC0
+#define DDP_FLAG_VERSION_1    0x40
+#define DDP_FLAG_PUSH         0x01
+
+struct DdpHeader {
+  uint8_t flags;
+  uint8_t sequence;   // 1-15, 0 if the sender does not number packets
+  uint32_t offset;    // Byte offset into the frame
+  uint16_t length;    // Payload bytes after the header
+};
+
+// Parse a packet header; false if it is not a DDP v1 data packet
+bool parseDdpHeader(const uint8_t* data, size_t length, DdpHeader& header);
+
+// Write a header for a sender; returns DDP_HEADER_SIZE
+size_t writeDdpHeader(const DdpHeader& header, uint8_t* buffer);
+
+struct DdpStats {
+  uint32_t packets;     // Datagrams read from the socket
+  uint32_t invalid;     // Not DDP, or outside the frame
+  uint32_t frames;      // Frames completed (PUSH received)
+  uint32_t played;      // Frames shown
+  uint32_t late;        // Packets older than the frame already shown
+  uint32_t duplicates;  // Packets for a frame already buffered or shown
+  uint32_t overflows;   // Buffered frames dropped to make room
+  uint32_t lost;        // Sequence numbers never shown
+  uint32_t incomplete;  // Frames dropped waiting for a PUSH that never came
+};
+
+class DdpReceiver {
+public:
+  // Open a non-blocking UDP socket; port 0 picks a free port
+  bool begin(uint16_t port);
+  void end();
+  bool isOpen() const { return socketFd >= 0; }
+  uint16_t localPort() const;
+
+  // Read every waiting packet into the jitter buffer
+  void poll(uint32_t nowMillis);
+
+  // Write the oldest frame that is due into frame (pixels it did not
+  // carry keep their previous color); false if none is due
+  bool play(uint32_t nowMillis, Frame& frame);
+
+  // Drop buffered frames and waiting packets and forget the sequence
+  void flush();
+
+  DdpStats stats = {};
+
+private:
+  enum SlotState : uint8_t { SLOT_FREE, SLOT_FILLING, SLOT_READY };
+
+  struct Slot {
+    uint8_t state;
+    uint8_t sequence;
+    uint16_t start;           // Bytes received: [start, end)
+    uint16_t end;
+    uint32_t readyMillis;
+    uint8_t data[DDP_FRAME_BYTES];
+  };
+
+  Slot* reserve(const DdpHeader& header);
+  void received(Slot& slot, const DdpHeader& header, size_t bytes, uint32_t nowMillis);
+  Slot* evict();
+  void dropStale();
+  bool stale(const Slot& slot) const;
+  int8_t order(uint8_t sequence) const;
+
+  Slot slots[DDP_JITTER_SLOTS] = {};
+  int socketFd = -1;
+  bool played = false;        // lastSequence is valid
+  uint8_t lastSequence = 0;
+};
+
+// Receiver polled by the External pattern
+extern DdpReceiver ddpReceiver;
+
+#endif // DDP_RECEIVER_H
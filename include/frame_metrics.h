@@ -0,0 +1,132 @@
+/**
+ * Frame timing metrics
+ *
+ * Render time per pattern, show() time, frame lateness and loop period
+ * are recorded as histograms of nanoseconds with power-of-two buckets, so
+ * recording stays enabled in release builds; the /metrics route formats
+ * them in the Prometheus text format.
+ *
+ * Render and show() times are short busy spans, timed with the CPU cycle
+ * counter and converted at the clock rate of the moment (power management
+ * may run the CPU at 80 MHz). Lateness and the loop period span idle time,
+ * when the clock can change or stop in light sleep, so they are timed
+ * with micros(). Each histogram has its own first bucket: render and
+ * show() times start at 1 us, the loop period at 262 us so its top
+ * bucket still holds a one second sleep.
+ *
+ * Counters are written by one task each and read by the HTTP task
+ * without locking, so a scrape can see a histogram mid-update (off by
+ * one sample), which is fine for monitoring.
+ */
+
+#ifndef FRAME_METRICS_H
+#define FRAME_METRICS_H
+
+#include <stdint.h>
+#include <stddef.h>
+#ifdef ARDUINO_ARCH_ESP32
+#include <hal/cpu_hal.h>
+#include <esp_rom_sys.h>
+#endif
+
+#define METRICS_BUCKETS         14    // Last bucket is +Inf
+#define METRICS_FIRST_BUCKET    10    // First bucket: < 2^10 ns (1 us), last bound 4.2 ms
+#define METRICS_LATE_BUCKET     14    // Lateness: < 16 us, last bound 67 ms
+#define METRICS_LOOP_BUCKET     18    // Loop period: < 262 us, last bound 1.07 s
+#define METRICS_FPS_WINDOW      1000  // ms over which the frame rate is measured
+#define METRICS_HISTOGRAM_TEXT  1400  // Buffer for one formatted histogram
+
+// Timestamp in CPU cycles (nanoseconds on the host); wraps, so only
+// differences are meaningful
+#ifdef ARDUINO_ARCH_ESP32
+inline uint32_t metricsCycles() {
+  return cpu_hal_get_cycle_count();
+}
+#else
+uint32_t metricsCycles();
+#endif
+
+// Nanoseconds in a span of metricsCycles(), at the current clock rate
+#ifdef ARDUINO_ARCH_ESP32
+inline uint32_t metricsNanos(uint32_t cycles) {
+  return (uint64_t)cycles * 1000 / esp_rom_get_cpu_ticks_per_us();
+}
+#else
+inline uint32_t metricsNanos(uint32_t cycles) {
+  return cycles;
+}
+#endif
+
+// Nanoseconds in a span of micros(), saturating past 4.29 s
+inline uint32_t metricsMicrosToNanos(uint32_t micros) {
+  return micros < UINT32_MAX / 1000 ? micros * 1000 : UINT32_MAX;
+}
+
+struct TimingHistogram {
+  explicit TimingHistogram(uint8_t firstBucket = METRICS_FIRST_BUCKET) : firstBucket(firstBucket) {}
+
+  uint32_t buckets[METRICS_BUCKETS] = {};   // Bucket i: < 2^(firstBucket + i) ns
+  uint64_t sumNanos = 0;
+  uint8_t firstBucket;
+
+  void record(uint32_t nanos) {
+    uint32_t scaled = nanos >> firstBucket;
+    uint32_t bucket = scaled == 0 ? 0 : 32 - __builtin_clz(scaled);
+    buckets[bucket < METRICS_BUCKETS ? bucket : METRICS_BUCKETS - 1]++;
+    sumNanos += nanos;
+  }
+};
+
+class FrameMetrics {
+public:
+  // Render task: a frame due `intervalMillis` after the previous one
+  // started `elapsedMicros` after it
+  void frameScheduled(uint32_t elapsedMicros, uint16_t intervalMillis) {
+    uint32_t interval = (uint32_t)intervalMillis * 1000;
+    uint32_t late = elapsedMicros > interval ? elapsedMicros - interval : 0;
+    lateness.record(metricsMicrosToNanos(late));
+    if (late >= interval) {
+      deadlinesMissed++;   // A whole frame slot went by without a frame
+    }
+  }
+
+  // Render task: any frame rendered (for the frame rate)
+  void frameStarted(uint32_t nowMillis) {
+    windowFrames++;
+    if (nowMillis - windowStart >= METRICS_FPS_WINDOW) {
+      framesPerSecondMilli = (uint64_t)windowFrames * 1000000 / (nowMillis - windowStart);
+      windowStart = nowMillis;
+      windowFrames = 0;
+    }
+  }
+
+  // Loop task: call at the top of every iteration
+  void loopStarted(uint32_t nowMicros) {
+    if (loopSeen) {
+      loopPeriod.record(metricsMicrosToNanos(nowMicros - lastLoop));
+    }
+    lastLoop = nowMicros;
+    loopSeen = true;
+  }
+
+  TimingHistogram show;                               // strip.show()
+  TimingHistogram lateness{METRICS_LATE_BUCKET};      // Frame start after its due time
+  TimingHistogram loopPeriod{METRICS_LOOP_BUCKET};    // Between loop() iterations
+  uint32_t deadlinesMissed = 0;
+  uint32_t framesPerSecondMilli = 0;   // Achieved frame rate x 1000
+
+private:
+  uint32_t windowStart = 0;
+  uint32_t windowFrames = 0;
+  uint32_t lastLoop = 0;
+  bool loopSeen = false;
+};
+
+extern FrameMetrics frameMetrics;
+
+// Write a histogram in the Prometheus text format, in seconds. labels
+// is "" or e.g. "pattern=\"wave\"". Returns the length, 0 if it did not fit.
+size_t formatHistogram(char* buffer, size_t size, const char* name, const char* labels,
+                       const TimingHistogram& histogram);
+
+#endif // FRAME_METRICS_H
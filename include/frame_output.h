@@ -0,0 +1,75 @@
+/**
+ * Frame buffer and change-detecting output to the NeoPixel strip
+ *
+ * Patterns render into a Frame. FrameOutput compares each frame with the
+ * last one sent to the strip and only calls show() when a pixel or the
+ * brightness changed, since every show() blocks interrupts (and WiFi)
+ * for the whole WS2812 transmission.
+ *
+ * Frames hold 16 bits per channel (color16.h). One output pass applies
+ * the brightness and brings each channel down to 8 bits with temporal
+ * dithering: the part below one 8-bit step is carried over to the
+ * pixel's next frame, so over a few frames the LED averages the full
+ * value instead of the truncated one. Dim gradients keep their steps at
+ * low brightness instead of banding. The strip's own brightness stays
+ * at "no scaling".
+ *
+ * Dithering runs at the pattern's frame rate. A frame that does not
+ * change is not pushed again, so static output holds one dithered frame
+ * (within one 8-bit step) instead of flickering at 1 fps.
+ */
+
+#ifndef FRAME_OUTPUT_H
+#define FRAME_OUTPUT_H
+
+#include <Arduino.h>
+#include <Adafruit_NeoPixel.h>
+#include "grid.h"
+#include "color16.h"
+
+// One frame of 16-bit colors, before brightness is applied
+struct Frame {
+  Color16 pixel[NUM_PIXELS];
+
+  void fill(Color16 color) {
+    for (uint16_t i = 0; i < NUM_PIXELS; i++) {
+      pixel[i] = color;
+    }
+  }
+
+  void clear() {
+    memset(pixel, 0, sizeof(pixel));
+  }
+};
+
+class FrameOutput {
+public:
+  explicit FrameOutput(Adafruit_NeoPixel& strip);
+
+  // Send a frame to the strip unless it matches what is already shown.
+  // Returns true if show() was called.
+  bool present(const Frame& frame);
+
+  // Brightness is applied in the output pass, before dithering
+  void setBrightness(uint8_t value);
+  uint8_t getBrightness() const { return brightness; }
+
+  // Force the next present() to push (e.g. after the strip was cleared)
+  void invalidate() { dirty = true; }
+
+  // Frames handed to present() vs frames actually sent to the LEDs
+  uint32_t framesRendered = 0;
+  uint32_t framesPushed = 0;
+
+private:
+  Adafruit_NeoPixel& strip;
+  Frame shown = {};
+  uint8_t residual[NUM_PIXELS][3];  // Dither error carried to the next frame, 1/256 steps
+  uint8_t brightness = 255;
+  bool dirty = true;
+};
+
+// Output for the main strip
+extern FrameOutput frameOutput;
+
+#endif // FRAME_OUTPUT_H
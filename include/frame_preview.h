@@ -0,0 +1,70 @@
+/**
+ * Live frame preview for WebSocket clients
+ *
+ * A client subscribes with the PREVIEW command and the FPS it wants. The
+ * loop task then sends it the current frame as one binary message:
+ *   byte 0   protocol version (WS_PROTOCOL_VERSION)
+ *   byte 1   WS_OP_PREVIEW
+ *   byte 2-3 u16 frame sequence, little-endian (gaps = skipped frames)
+ *   byte 4-  R, G, B per grid cell, row by row from the top left,
+ *            before brightness
+ *
+ * Nothing is queued: a client gets the newest frame when its interval is
+ * up and the frame changed, and every frame in between is dropped. A send
+ * that fails or blocks (full TCP window) halves that client's rate, so a
+ * slow phone costs neither heap nor loop time. The render task is never
+ * involved.
+ */
+
+#ifndef FRAME_PREVIEW_H
+#define FRAME_PREVIEW_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "frame_output.h"
+
+#define PREVIEW_MAX_CLIENTS   8       // At least WEBSOCKETS_SERVER_CLIENT_MAX
+#define PREVIEW_MAX_FPS       30
+#define PREVIEW_FRAME_SIZE    (4 + NUM_PIXELS * 3)
+#define PREVIEW_SLOW_SEND_US  20000   // A send this slow means the client is behind
+#define PREVIEW_MAX_BACKOFF   3       // Slow clients drop to 1/8 of their rate at most
+#define PREVIEW_MAX_FAILURES  3       // Failed sends in a row before unsubscribing
+
+struct PreviewClient {
+  uint8_t fps;                // 0 = not subscribed
+  uint8_t backoff;            // Interval is doubled this many times
+  uint8_t failures;           // Failed sends in a row
+  uint16_t interval;          // ms between frames at the requested FPS
+  uint32_t nextMillis;        // Earliest time for the next frame
+  uint32_t lastSequence;      // Sequence of the last frame sent
+  uint32_t framesSent;
+  uint32_t framesSkipped;     // Frames produced but not sent to this client
+};
+
+class PreviewStream {
+public:
+  // Start streaming to a client at fps (capped at PREVIEW_MAX_FPS), or
+  // stop with fps 0. The first frame is due immediately.
+  void subscribe(uint8_t client, uint8_t fps, uint32_t nowMillis);
+  void unsubscribe(uint8_t client) { subscribe(client, 0, 0); }
+
+  // True if a client should get the frame with this sequence now
+  bool due(uint8_t client, uint32_t sequence, uint32_t nowMillis) const;
+
+  // Record a send: ok = the message went out, sendMicros = time it took
+  void sent(uint8_t client, uint32_t sequence, uint32_t nowMillis, bool ok, uint32_t sendMicros);
+
+  uint8_t subscribers() const;
+  const PreviewClient& client(uint8_t client) const { return clients[client]; }
+
+  uint32_t sendFailures = 0;
+
+private:
+  PreviewClient clients[PREVIEW_MAX_CLIENTS] = {};
+};
+
+// Encode a frame in grid order (see above); returns PREVIEW_FRAME_SIZE.
+// buffer must hold PREVIEW_FRAME_SIZE bytes.
+size_t encodePreviewFrame(const Frame& frame, uint16_t sequence, uint8_t* buffer);
+
+#endif // FRAME_PREVIEW_H
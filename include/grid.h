@@ -0,0 +1,12 @@
+/**
+ * LED grid dimensions for the lithophane
+ */
+
+#ifndef GRID_H
+#define GRID_H
+
+#define NUM_PIXELS      60    // Number of NeoPixels
+#define GRID_WIDTH      6     // Grid width (columns)
+#define GRID_HEIGHT     10    // Grid height (rows)
+
+#endif // GRID_H
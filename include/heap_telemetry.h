@@ -0,0 +1,114 @@
+/**
+ * Heap telemetry: allocations per code path and free-heap history
+ *
+ * Every heap allocation is counted against the AllocSite whose AllocScope
+ * is open on the allocating task: a command, an HTTP route, a broadcast
+ * or the render path. Allocations outside any scope go to the
+ * "unattributed" site. Frees are counted where they happen, which is not
+ * always the site that allocated.
+ *
+ * The firmware links malloc/calloc/realloc/free through --wrap (see
+ * platformio.ini), so String and operator new are counted too; the
+ * native benchmark feeds the same counters from its interposed
+ * allocator. Counters are plain increments, so two tasks allocating
+ * under the same site at once can lose a count.
+ *
+ * HeapHistory samples free heap and the largest free block every few
+ * seconds; fragmentation is the share of free heap that is not in the
+ * largest block.
+ */
+
+#ifndef HEAP_TELEMETRY_H
+#define HEAP_TELEMETRY_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define ALLOC_SITE_NAME         24    // Characters, including the terminator
+#define ALLOC_MAX_TASKS         6     // Tasks that can open scopes
+#define HEAP_HISTORY_SAMPLES    60
+#define HEAP_SAMPLE_INTERVAL    10000 // ms (60 samples = 10 minutes)
+
+class AllocSite {
+public:
+  // Sites register themselves; create them at startup, before the
+  // tasks that use them (they are never removed)
+  explicit AllocSite(const char* name);
+  AllocSite(const AllocSite&) = delete;
+  AllocSite& operator=(const AllocSite&) = delete;
+
+  char name[ALLOC_SITE_NAME];
+  uint32_t entries = 0;       // Scopes opened
+  uint32_t allocations = 0;
+  uint32_t frees = 0;
+  uint32_t bytes = 0;         // Bytes requested
+  AllocSite* nextSite;
+};
+
+// Count this task's allocations against a site until the scope closes.
+// Scopes nest; the innermost one wins.
+class AllocScope {
+public:
+  explicit AllocScope(AllocSite& site);
+  ~AllocScope();
+  AllocScope(const AllocScope&) = delete;
+  AllocScope& operator=(const AllocScope&) = delete;
+
+private:
+  struct TaskScope* task;
+  AllocSite* previous;
+};
+
+// Called by the allocator hooks
+void allocTrackerAlloc(size_t bytes);
+void allocTrackerFree();
+
+// All sites, newest first
+AllocSite* firstAllocSite();
+
+// Allocations made outside any scope
+extern AllocSite unattributedAllocs;
+
+struct HeapSample {
+  uint32_t millis;
+  uint32_t freeBytes;
+  uint32_t largestBlock;
+
+  // Free heap not in the largest block, in percent
+  uint8_t fragmentation() const {
+    return freeBytes == 0 ? 0 : 100 - (uint64_t)largestBlock * 100 / freeBytes;
+  }
+};
+
+class HeapHistory {
+public:
+  bool due(uint32_t nowMillis) const {
+    return count == 0 || nowMillis - samples[newest()].millis >= HEAP_SAMPLE_INTERVAL;
+  }
+
+  // Time the next sample is due (after the first one)
+  uint32_t nextSampleMillis() const { return samples[newest()].millis + HEAP_SAMPLE_INTERVAL; }
+
+  void add(const HeapSample& sample);
+
+  uint8_t size() const { return count; }
+  // Oldest first
+  const HeapSample& at(uint8_t i) const {
+    return samples[(next + HEAP_HISTORY_SAMPLES - count + i) % HEAP_HISTORY_SAMPLES];
+  }
+
+  uint32_t minFreeBytes = UINT32_MAX;   // Lowest free heap sampled
+  uint32_t minLargestBlock = UINT32_MAX;
+  uint8_t maxFragmentation = 0;
+
+private:
+  uint8_t newest() const { return (next + HEAP_HISTORY_SAMPLES - 1) % HEAP_HISTORY_SAMPLES; }
+
+  HeapSample samples[HEAP_HISTORY_SAMPLES] = {};
+  uint8_t next = 0;
+  uint8_t count = 0;
+};
+
+extern HeapHistory heapHistory;
+
+#endif // HEAP_TELEMETRY_H
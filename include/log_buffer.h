@@ -0,0 +1,102 @@
+/**
+ * Leveled logging into a RAM ring buffer
+ *
+ * LOG_E/LOG_W/LOG_I/LOG_D format one line into a fixed-size slot and
+ * return without touching the serial port, so a host that is not
+ * reading USB-CDC can no longer stall a frame. The loop task prints the
+ * buffered lines when it is idle and the port has room, and /logs
+ * returns the most recent ones. Calls above LOG_LEVEL (set with
+ * -DLOG_LEVEL=...) compile to nothing and their arguments are not
+ * evaluated.
+ *
+ * Any task may log. A writer claims a slot with one atomic increment
+ * and publishes it by storing its sequence number; readers copy a slot
+ * and check the number again, so a line overwritten mid-copy is counted
+ * as dropped instead of shown torn. When the buffer wraps, the oldest
+ * lines are dropped.
+ */
+
+#ifndef LOG_BUFFER_H
+#define LOG_BUFFER_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdarg.h>
+#include <atomic>
+
+#define LOG_LEVEL_NONE    0
+#define LOG_LEVEL_ERROR   1
+#define LOG_LEVEL_WARN    2
+#define LOG_LEVEL_INFO    3
+#define LOG_LEVEL_DEBUG   4
+
+#ifndef LOG_LEVEL
+#define LOG_LEVEL LOG_LEVEL_INFO
+#endif
+
+#define LOG_SLOTS         64      // Lines kept (power of two)
+#define LOG_TEXT_SIZE     96      // Characters per line, including the terminator
+#define LOG_LINE_SIZE     (LOG_TEXT_SIZE + 16)   // Formatted by formatLogLine()
+
+// One buffered line, as copied out by a reader
+struct LogEntry {
+  uint32_t sequence;    // Position in the log, counting from 0
+  uint32_t millis;
+  uint8_t level;
+  char text[LOG_TEXT_SIZE];
+};
+
+// Where a reader is in the log; dropped counts lines it never saw
+struct LogCursor {
+  uint32_t next = 0;
+  uint32_t dropped = 0;
+};
+
+class LogBuffer {
+  static_assert(LOG_SLOTS > 0 && (LOG_SLOTS & (LOG_SLOTS - 1)) == 0, "Log size must be a power of two");
+
+public:
+  // Format a line into the next slot; safe from any task
+  void write(uint8_t level, uint32_t nowMillis, const char* format, va_list args);
+
+  // Copy the line at the cursor and move past it; false when the cursor
+  // has caught up (or the next line is still being written)
+  bool read(LogCursor& cursor, LogEntry& entry);
+
+  // Cursor at the oldest line still in the buffer
+  LogCursor oldest() const;
+
+  uint32_t written() const { return head.load(std::memory_order_relaxed); }
+
+private:
+  struct Slot {
+    std::atomic<uint32_t> published{0};   // sequence + 1 once written, 0 while writing
+    uint32_t millis = 0;
+    uint8_t level = 0;
+    char text[LOG_TEXT_SIZE];
+  };
+
+  Slot slots[LOG_SLOTS];
+  std::atomic<uint32_t> head{0};   // Next sequence number to claim
+};
+
+extern LogBuffer logBuffer;
+
+// Log a line at a level, timestamped with millis(); use the macros below
+void logWrite(uint8_t level, const char* format, ...) __attribute__((format(printf, 2, 3)));
+
+// "[   12.345] I text\n"; returns the length (truncated to fit size)
+size_t formatLogLine(const LogEntry& entry, char* buffer, size_t size);
+
+// Single-letter level name (E, W, I, D)
+char logLevelLetter(uint8_t level);
+
+#define LOG_AT(level, ...) \
+  do { if ((level) <= LOG_LEVEL) logWrite((level), __VA_ARGS__); } while (0)
+
+#define LOG_E(...) LOG_AT(LOG_LEVEL_ERROR, __VA_ARGS__)
+#define LOG_W(...) LOG_AT(LOG_LEVEL_WARN, __VA_ARGS__)
+#define LOG_I(...) LOG_AT(LOG_LEVEL_INFO, __VA_ARGS__)
+#define LOG_D(...) LOG_AT(LOG_LEVEL_DEBUG, __VA_ARGS__)
+
+#endif // LOG_BUFFER_H
@@ -0,0 +1,105 @@
+/**
+ * Deadline scheduling for the main loop
+ *
+ * Each pass of the loop collects the times its work is next due: the
+ * auto-cycle, a preference commit, the next heap sample, a WebSocket
+ * poll, a held button or a log line waiting for the serial port. The
+ * loop then blocks until the earliest one instead of a fixed delay.
+ * Commands forwarded by the HTTP task and button edges wake it early, so
+ * nothing waits for a deadline that was not known when it went to sleep.
+ * Frames are not the loop's business: the render task sleeps until its
+ * own next frame.
+ *
+ * WebSocketsServer has to be polled. It is polled often while clients
+ * are connected, less often while stations are associated with the
+ * access point (to accept new clients), and only every LOOP_MAX_SLEEP
+ * with nobody on the network.
+ *
+ * Power save is allowed once no frame has changed for LOOP_STATIC_AFTER
+ * and no station is associated; the firmware then lets the CPU clock
+ * down between deadlines (where power management is built in).
+ */
+
+#ifndef LOOP_SCHEDULER_H
+#define LOOP_SCHEDULER_H
+
+#include <stdint.h>
+
+#define LOOP_MAX_SLEEP        1000  // ms; the loop wakes at least this often
+#define LOOP_NETWORK_POLL     10    // ms between WebSocket polls with clients connected
+#define LOOP_ACCEPT_POLL      100   // ms between polls for new clients while stations are associated
+#define LOOP_BUTTON_POLL      10    // ms between button reads while it is held
+#define LOOP_LOG_RETRY        10    // ms until the serial port has room again
+#define LOOP_STATIC_AFTER     2000  // ms without a new frame before the output counts as static
+
+class LoopScheduler {
+public:
+  // Start a pass: forget the previous deadlines
+  void begin(uint32_t nowMillis) {
+    now = nowMillis;
+    sleep = LOOP_MAX_SLEEP;
+  }
+
+  // Work due at a time (a time in the past means now)
+  void wakeAt(uint32_t dueMillis) {
+    int32_t left = (int32_t)(dueMillis - now);
+    wakeIn(left < 0 ? 0 : left);
+  }
+
+  // Work due in a number of ms from the start of the pass
+  void wakeIn(uint32_t millis) {
+    if (millis < sleep) {
+      sleep = millis;
+    }
+  }
+
+  // WebSocket polling for the clients and stations currently connected
+  void pollNetwork(uint8_t webSocketClients, uint8_t stations) {
+    if (webSocketClients > 0) {
+      wakeIn(LOOP_NETWORK_POLL);
+    } else if (stations > 0) {
+      wakeIn(LOOP_ACCEPT_POLL);
+    }
+  }
+
+  // ms until the earliest deadline of this pass
+  uint32_t sleepMillis() const { return sleep; }
+
+  // Track the count of frames sent to the LEDs, to tell static output
+  void framesPushed(uint32_t count, uint32_t nowMillis) {
+    if (count != lastFramesPushed || !framesSeen) {
+      framesSeen = true;
+      lastFramesPushed = count;
+      lastFrameMillis = nowMillis;
+    }
+  }
+
+  bool outputStatic(uint32_t nowMillis) const {
+    return framesSeen && nowMillis - lastFrameMillis >= LOOP_STATIC_AFTER;
+  }
+
+  // Static output and nobody connected
+  bool powerSaveAllowed(uint32_t nowMillis, uint8_t stations) const {
+    return stations == 0 && outputStatic(nowMillis);
+  }
+
+  // Count a wakeup; notified = woken early by a command or the button
+  void woke(bool notified) {
+    wakeups++;
+    if (notified) {
+      notifiedWakeups++;
+    }
+  }
+
+  uint32_t wakeups = 0;
+  uint32_t notifiedWakeups = 0;
+
+private:
+  uint32_t now = 0;
+  uint32_t sleep = LOOP_MAX_SLEEP;
+  uint32_t lastFramesPushed = 0;
+  uint32_t lastFrameMillis = 0;
+  bool framesSeen = false;
+};
+
+#endif // LOOP_SCHEDULER_H
@@ -0,0 +1,79 @@
+/**
+ * Packed-pixel math on Color16 frames
+ *
+ * A frame is a run of 16-bit channels (r, g, b, r, g, ...), so the
+ * kernels load four channels at a time into a uint64_t instead of
+ * working through them one by one. Multiplies split the word into two
+ * pairs of channels in 32-bit lanes (0x0000FFFF0000FFFF), where a 16-bit
+ * channel times a 1/256 step scale or alpha has the headroom it needs,
+ * and handle each pair in one operation. Saturating add works on all
+ * four 16-bit lanes at once: the low 15 bits of each lane are added
+ * without carries between lanes, and the carry out of each top bit is
+ * turned into a 0xFFFF mask for that lane.
+ *
+ * The same tricks on eight byte lanes fade Fire's heat cells.
+ *
+ * Scales and alphas are in 1/256 steps, 0-PIXEL_SCALE_ONE, and round down
+ * like color16Lerp().
+ */
+
+#ifndef PACKED_PIXEL_H
+#define PACKED_PIXEL_H
+
+#include <stdint.h>
+#include "color16.h"
+
+#define PIXEL_SCALE_ONE   COLOR16_ALPHA_ONE   // Scale or alpha that keeps a color unchanged
+#define PIXEL_PAIR_LANES  0x0000FFFF0000FFFFull
+#define PIXEL_LOW_BITS    0x7FFF7FFF7FFF7FFFull
+#define PIXEL_HIGH_BITS   0x8000800080008000ull
+#define BYTE_PAIR_LANES   0x00FF00FF00FF00FFull
+#define BYTE_LOW_BITS     0x7F7F7F7F7F7F7F7Full
+#define BYTE_HIGH_BITS    0x8080808080808080ull
+
+// Each of four channels times scale / 256
+inline uint64_t packedScale(uint64_t channels, uint16_t scale) {
+  uint64_t even = ((channels & PIXEL_PAIR_LANES) * scale >> 8) & PIXEL_PAIR_LANES;
+  uint64_t odd = (((channels >> 16) & PIXEL_PAIR_LANES) * scale >> 8) & PIXEL_PAIR_LANES;
+  return even | odd << 16;
+}
+
+// a * (1 - alpha) + b * alpha for each of four channels
+inline uint64_t packedLerp(uint64_t a, uint64_t b, uint16_t alpha) {
+  uint32_t keep = PIXEL_SCALE_ONE - alpha;
+  uint64_t even = ((a & PIXEL_PAIR_LANES) * keep + (b & PIXEL_PAIR_LANES) * alpha) >> 8;
+  uint64_t odd = (((a >> 16) & PIXEL_PAIR_LANES) * keep + ((b >> 16) & PIXEL_PAIR_LANES) * alpha) >> 8;
+  return (even & PIXEL_PAIR_LANES) | (odd & PIXEL_PAIR_LANES) << 16;
+}
+
+// a + b for each of four channels, clamped at COLOR16_ONE
+inline uint64_t packedAdd(uint64_t a, uint64_t b) {
+  uint64_t sum = ((a & PIXEL_LOW_BITS) + (b & PIXEL_LOW_BITS)) ^ ((a ^ b) & PIXEL_HIGH_BITS);
+  uint64_t carry = ((a & b) | ((a | b) & ~sum)) & PIXEL_HIGH_BITS;
+  return sum | carry | (carry - (carry >> 15));
+}
+
+// Each of eight bytes times scale / 256
+inline uint64_t packedScaleBytes(uint64_t bytes, uint16_t scale) {
+  uint64_t even = ((bytes & BYTE_PAIR_LANES) * scale >> 8) & BYTE_PAIR_LANES;
+  uint64_t odd = ((bytes >> 8) & BYTE_PAIR_LANES) * scale & ~BYTE_PAIR_LANES;
+  return even | odd;
+}
+
+// a - b for each of eight bytes, clamped at 0
+inline uint64_t packedSubtractBytes(uint64_t a, uint64_t b) {
+  uint64_t difference = ((a | BYTE_HIGH_BITS) - (b & BYTE_LOW_BITS)) ^ ((a ^ ~b) & BYTE_HIGH_BITS);
+  uint64_t borrow = ((~a & b) | (~(a ^ b) & difference)) & BYTE_HIGH_BITS;
+  return difference & ~(borrow | (borrow - (borrow >> 7)));
+}
+
+// Whole buffers (e.g. Frame::pixel with NUM_PIXELS)
+void scalePixels(Color16* pixels, uint16_t count, uint16_t scale);
+void fadePixels(Color16* pixels, uint16_t count, uint8_t amount);   // Toward black by amount/256
+void addPixels(Color16* pixels, const Color16* add, uint16_t count);
+void lerpPixels(const Color16* a, const Color16* b, Color16* out, uint16_t count, uint16_t alpha);
+
+// Each value minus amount * scale / 256, clamped at 0 (Fire's cooling)
+void fadeBytes(uint8_t* values, const uint8_t* amounts, uint16_t count, uint16_t scale);
+
+#endif // PACKED_PIXEL_H
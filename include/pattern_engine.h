@@ -0,0 +1,145 @@
+/**
+ * Pattern engine: pattern objects and the frame scheduler
+ *
+ * Every pattern owns its animation state and declares the frame interval
+ * it wants. The engine renders the selected pattern at that interval,
+ * records how long rendering took and hands the frame to the frame
+ * output, which skips frames that did not change.
+ *
+ * Frames are double-buffered: a pattern draws into the back buffer (a copy
+ * of the last frame) and the buffers swap once the frame is complete. The
+ * swap is published with a frame counter, seqlock style: copyFrame() lets
+ * other tasks take the last complete frame, and retries a copy that the
+ * render task overwrote half way through. currentFrame() is for the task
+ * that calls update().
+ *
+ * With a transition time set, switching patterns crossfades instead of
+ * cutting. The outgoing pattern keeps drawing on the frame that was shown,
+ * the incoming one starts from a blank frame in a buffer of its own, and
+ * each frame blends the two with a fixed-point alpha that rises over the
+ * transition. Each pattern still renders at its own frame interval, and
+ * the blend is redrawn whenever either of them renders.
+ */
+
+#ifndef PATTERN_ENGINE_H
+#define PATTERN_ENGINE_H
+
+#include <Arduino.h>
+#include <atomic>
+#include "frame_output.h"
+#include "frame_metrics.h"
+#include "heap_telemetry.h"
+#include "random_stream.h"
+
+#define TRANSITION_MAX_MILLIS   10000   // Longest crossfade
+#define NO_TRANSITION           0xFF    // outgoing index when no crossfade runs
+
+class Pattern {
+public:
+  Pattern(const char* name, const char* key, uint16_t frameInterval)
+    : name(name), key(key), frameInterval(frameInterval) {}
+
+  // Restart the animation from its first frame
+  virtual void reset() {}
+
+  // False for patterns that need an outside source (skipped by next())
+  virtual bool inCycle() const { return true; }
+
+  // Render the next frame. The frame still holds the previous one, so
+  // patterns may update it incrementally.
+  virtual void render(Frame& frame) = 0;
+
+  const char* const name;       // Display name ("Rainbow")
+  const char* const key;        // Command/route name ("rainbow")
+  const uint16_t frameInterval; // Target time between frames (ms)
+
+  // The pattern's own random numbers, see seedPatterns()
+  RandomStream rng;
+
+  // Measured render cost, updated by the engine
+  uint32_t frameCount = 0;
+  uint32_t lastRenderMicros = 0;
+  uint32_t maxRenderMicros = 0;
+  uint32_t averageRenderMicros = 0; // Moving average over ~8 frames
+  TimingHistogram renderTime;       // Time per render, for /metrics
+};
+
+class PatternEngine {
+public:
+  PatternEngine(Pattern* const* patterns, uint8_t count, uint8_t initial)
+    : patterns(patterns), count(count), current(initial) {}
+
+  // Switch pattern; a different pattern restarts from a blank frame,
+  // crossfading from the current one if a transition time is set
+  void select(uint8_t index);
+  void next();
+
+  // Crossfade time for pattern changes, 0 cuts (capped at TRANSITION_MAX_MILLIS)
+  void setTransition(uint16_t millis) {
+    transitionMillis = millis > TRANSITION_MAX_MILLIS ? TRANSITION_MAX_MILLIS : millis;
+  }
+  uint16_t transition() const { return transitionMillis; }
+  bool transitioning() const { return outgoing != NO_TRANSITION; }
+
+  // Render a frame on the next update() regardless of the interval
+  void requestFrame() { framePending = true; }
+
+  // Blank the frame and restart the current pattern (e.g. after the
+  // pixel layout changed); ends a running transition
+  void restart();
+
+  // Render and present a frame if one is due; returns true if it rendered
+  bool update(uint32_t nowMillis);
+
+  // Time left until update() will render the next frame
+  uint32_t millisUntilNextFrame(uint32_t nowMillis) const;
+
+  // Last completed frame, from the rendering task only
+  const Frame& currentFrame() const { return frames[front()]; }
+
+  // Copy of the last completed frame, safe from any task
+  void copyFrame(Frame& out) const;
+
+  uint8_t currentIndex() const { return current; }
+  Pattern& currentPattern() const { return *patterns[current]; }
+  uint8_t patternCount() const { return count; }
+  Pattern& pattern(uint8_t index) const { return *patterns[index]; }
+
+private:
+  // ms after the last frame that the next one is due: the pattern's
+  // interval, or while crossfading the next render of either layer
+  uint16_t frameInterval() const;
+  // Render a pattern into its frame and update its render statistics
+  void renderPattern(Pattern& pattern, Frame& frame);
+  // Render the next crossfade frame into out
+  void renderTransition(uint32_t nowMillis, Frame& out);
+  // The shown buffer follows the frame counter; publish() swaps them
+  uint8_t front() const { return framesPublished.load(std::memory_order_relaxed) & 1; }
+  Frame& backFrame();
+  void publish();
+
+  Pattern* const* patterns;
+  uint8_t count;
+  uint8_t current;
+  uint32_t lastFrameMillis = 0;
+  uint32_t lastFrameMicros = 0;
+  bool framePending = true;
+  bool scheduled = false;       // A frame has been rendered (lastFrameMicros is set)
+  Frame frames[2] = {};
+  std::atomic<uint32_t> framesPublished{0};   // Bumped each time the buffers swap
+
+  // Crossfade state
+  uint16_t transitionMillis = 0;
+  uint8_t outgoing = NO_TRANSITION;
+  bool transitionStarted = false;   // Start time and layers set on its first frame
+  uint32_t transitionStart = 0;
+  uint32_t outgoingMillis = 0;      // Last render of each layer
+  uint32_t incomingMillis = 0;
+  Frame outgoingFrame = {};
+  Frame incomingFrame = {};
+};
+
+// Allocations made while rendering and presenting frames (should stay 0)
+extern AllocSite renderAllocs;
+
+#endif // PATTERN_ENGINE_H
@@ -0,0 +1,51 @@
+/**
+ * LED patterns for the lithophane grid
+ *
+ * The patterns only write into a Frame, so the same code builds for the
+ * XIAO ESP32C3 and for the host-native benchmark (see bench/). Each
+ * pattern is an object in the registry below; the pattern engine
+ * schedules their frames and hands them to the frame output.
+ */
+
+#ifndef PATTERNS_H
+#define PATTERNS_H
+
+#include <Arduino.h>
+#include <Adafruit_NeoPixel.h>
+#include "grid.h"
+#include "pattern_engine.h"
+
+// Pattern registry indices (also the "pattern" number sent to the web UI)
+enum PatternId : uint8_t {
+  PATTERN_RAINBOW = 0,
+  PATTERN_STATIC,
+  PATTERN_WAVE,
+  PATTERN_FIRE,
+  PATTERN_MATRIX,
+  PATTERN_SPIRAL,
+  PATTERN_PULSE,
+  PATTERN_EXTERNAL,
+  PATTERN_ANIMATION,
+  PATTERN_COUNT
+};
+
+// NeoPixel strip (defined by the firmware or by the native benchmark)
+extern Adafruit_NeoPixel pixels;
+
+// Color shown by the Static and Spiral patterns
+extern uint32_t staticColor;
+
+// Engine driving the registered patterns, starts on Wave
+extern PatternEngine patternEngine;
+
+// Reseed every pattern's random stream from one seed. The same seed
+// followed by the same selections renders the same frames.
+void seedPatterns(uint32_t seed);
+
+// Registered pattern by index (PatternId)
+Pattern& getPattern(uint8_t index);
+
+// Display name of a pattern, "Unknown" for an invalid index
+const char* getPatternName(uint8_t index);
+
+#endif // PATTERNS_H
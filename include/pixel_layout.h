@@ -0,0 +1,94 @@
+/**
+ * Pixel layout mapping between grid cells and strip positions
+ *
+ * Lithophanes are wired in different orders, so patterns never compute
+ * strip indices themselves. They look them up in the active layout:
+ * - pixelAt[col][row]        grid cell -> strip index
+ * - cellPixel[row * W + col] the same, row by row (stored animations)
+ *
+ * The built-in wirings are generated at compile time; custom wirings are
+ * loaded at runtime from a text map on LittleFS (see parsePixelLayout()).
+ * Loading and activating are separate steps so the file can be read by
+ * the network task while only the render task switches the active table.
+ * Switching swaps a pointer instead of copying a table, so the preview
+ * encoder on another task never reads a half-copied layout.
+ */
+
+#ifndef PIXEL_LAYOUT_H
+#define PIXEL_LAYOUT_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+#include "grid.h"
+
+// Supported wiring orders (values are stored in preferences)
+enum PixelLayoutType : uint8_t {
+  LAYOUT_COLUMN_SERPENTINE = 0,   // Down even columns, up odd columns
+  LAYOUT_ROW_SERPENTINE = 1,      // Right along even rows, left along odd rows
+  LAYOUT_ROW_MAJOR = 2,           // Every row left to right
+  LAYOUT_CUSTOM = 3,              // Per-pixel map loaded from LittleFS
+  LAYOUT_COUNT
+};
+
+#define LAYOUT_FILE     "/layout.txt"   // Custom map on LittleFS
+
+// Cell to strip index tables for a W x H grid
+template <uint8_t W, uint8_t H>
+struct GridLayout {
+  uint8_t type;
+  uint16_t pixelAt[W][H];     // Strip index for each grid cell
+  uint16_t cellPixel[W * H];  // pixelAt in row-by-row cell order
+};
+
+// Strip index of a cell for one of the built-in wirings
+constexpr uint16_t builtinPixelIndex(PixelLayoutType type, uint8_t width, uint8_t height,
+                                     uint8_t col, uint8_t row) {
+  return type == LAYOUT_ROW_SERPENTINE ? row * width + (row % 2 == 0 ? col : width - 1 - col)
+       : type == LAYOUT_ROW_MAJOR      ? row * width + col
+       : col * height + (col % 2 == 0 ? row : height - 1 - row);
+}
+
+template <uint8_t W, uint8_t H>
+constexpr GridLayout<W, H> makeGridLayout(PixelLayoutType type) {
+  GridLayout<W, H> layout = {};
+  layout.type = type;
+  for (uint8_t col = 0; col < W; col++) {
+    for (uint8_t row = 0; row < H; row++) {
+      uint16_t pixel = builtinPixelIndex(type, W, H, col, row);
+      layout.pixelAt[col][row] = pixel;
+      layout.cellPixel[row * W + col] = pixel;
+    }
+  }
+  return layout;
+}
+
+typedef GridLayout<GRID_WIDTH, GRID_HEIGHT> PixelLayout;
+
+// Active layout used by all patterns. A table does not change while it
+// is active; patterns take the reference once per frame.
+extern std::atomic<const PixelLayout*> activePixelLayout;
+
+inline const PixelLayout& pixelLayout() {
+  return *activePixelLayout.load(std::memory_order_acquire);
+}
+
+// Switch the active wiring (render task). LAYOUT_CUSTOM activates the
+// last map loaded by parsePixelLayout(); returns false if no custom map
+// was loaded or the type is unknown.
+bool selectPixelLayout(PixelLayoutType type);
+
+// Parse a custom map without activating it (loop task). The text lists
+// one strip index per grid cell, row by row from the top-left cell,
+// separated by spaces, commas or newlines; '#' starts a comment. Every
+// strip index must appear exactly once. On error the loaded map is left
+// unchanged. The map goes into a table that is not active; the render
+// task, which preempts the loop once a command is posted, activates it
+// before the loop can load another one.
+bool parsePixelLayout(const char* text, size_t length);
+
+// Layout names used by the /layout route ("column_serpentine", ...)
+const char* getLayoutName(uint8_t type);
+bool getLayoutType(const char* name, PixelLayoutType* type);
+
+#endif // PIXEL_LAYOUT_H
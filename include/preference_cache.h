@@ -0,0 +1,136 @@
+/**
+ * Write-behind cache over the Preferences (NVS) store
+ *
+ * Command handlers only change the cached values. Changed fields are
+ * written to flash together once no setting has changed for a quiet
+ * period, or right away by flush() (e.g. before a restart), so dragging
+ * the color picker costs one flash commit instead of one per command.
+ */
+
+#ifndef PREFERENCE_CACHE_H
+#define PREFERENCE_CACHE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define PREFERENCES_QUIET_PERIOD  3000  // Commit after this long without changes (ms)
+
+// Persisted settings
+enum PreferenceKey : uint8_t {
+  PREF_BRIGHTNESS = 0,
+  PREF_AUTO_CYCLE,
+  PREF_AUTO_CYCLE_INTERVAL,
+  PREF_STATIC_COLOR,
+  PREF_LAYOUT,
+  PREF_TRANSITION,
+  PREF_COUNT
+};
+
+enum PreferenceType : uint8_t {
+  PREF_TYPE_U8,
+  PREF_TYPE_BOOL,
+  PREF_TYPE_U32,
+};
+
+struct PreferenceSpec {
+  const char* key;        // NVS key
+  uint8_t type;
+  uint32_t defaultValue;
+};
+
+// Key, type and default of every setting, indexed by PreferenceKey
+extern const PreferenceSpec preferenceSpecs[PREF_COUNT];
+
+// Store is Preferences on the device; the native bench passes a fake
+template <typename Store>
+class PreferenceCache {
+public:
+  PreferenceCache(Store& store, uint32_t quietPeriodMillis)
+    : store(store), quietPeriod(quietPeriodMillis) {}
+
+  // Read every setting from the store, dropping unsaved changes
+  void load() {
+    for (uint8_t i = 0; i < PREF_COUNT; i++) {
+      const PreferenceSpec& spec = preferenceSpecs[i];
+      switch (spec.type) {
+        case PREF_TYPE_U8:   values[i] = store.getUChar(spec.key, spec.defaultValue); break;
+        case PREF_TYPE_BOOL: values[i] = store.getBool(spec.key, spec.defaultValue); break;
+        default:             values[i] = store.getULong(spec.key, spec.defaultValue); break;
+      }
+    }
+    dirtyMask = 0;
+  }
+
+  uint32_t get(PreferenceKey key) const { return values[key]; }
+
+  // Change a setting in RAM; never touches flash
+  void set(PreferenceKey key, uint32_t value, uint32_t nowMillis) {
+    requests++;
+    if (values[key] == value) {
+      return;
+    }
+    values[key] = value;
+    dirtyMask |= 1 << key;
+    lastChangeMillis = nowMillis;
+  }
+
+  // Commit the changed settings once they have been quiet long enough;
+  // returns true if it wrote to flash
+  bool update(uint32_t nowMillis) {
+    if (dirtyMask == 0 || nowMillis - lastChangeMillis < quietPeriod) {
+      return false;
+    }
+    return flush() > 0;
+  }
+
+  // Commit the changed settings now; returns the number written
+  uint8_t flush() {
+    uint8_t written = 0;
+    for (uint8_t i = 0; i < PREF_COUNT; i++) {
+      if (!(dirtyMask & (1 << i))) {
+        continue;
+      }
+      const PreferenceSpec& spec = preferenceSpecs[i];
+      switch (spec.type) {
+        case PREF_TYPE_U8:   bytesWritten += store.putUChar(spec.key, values[i]); break;
+        case PREF_TYPE_BOOL: bytesWritten += store.putBool(spec.key, values[i] != 0); break;
+        default:             bytesWritten += store.putULong(spec.key, values[i]); break;
+      }
+      written++;
+    }
+    if (written > 0) {
+      commits++;
+      fieldsWritten += written;
+    }
+    dirtyMask = 0;
+    return written;
+  }
+
+  bool dirty() const { return dirtyMask != 0; }
+
+  // ms until update() would commit, UINT32_MAX if nothing changed
+  uint32_t millisUntilCommit(uint32_t nowMillis) const {
+    if (dirtyMask == 0) {
+      return UINT32_MAX;
+    }
+    uint32_t quiet = nowMillis - lastChangeMillis;
+    return quiet >= quietPeriod ? 0 : quietPeriod - quiet;
+  }
+
+  // set() calls that did not lead to a flash commit of their own
+  uint32_t commitsAvoided() const { return requests - commits; }
+
+  uint32_t requests = 0;        // set() calls
+  uint32_t commits = 0;         // Flushes that wrote to flash
+  uint32_t fieldsWritten = 0;
+  uint32_t bytesWritten = 0;
+
+private:
+  Store& store;
+  uint32_t quietPeriod;
+  uint32_t values[PREF_COUNT] = {};
+  uint8_t dirtyMask = 0;
+  uint32_t lastChangeMillis = 0;
+};
+
+#endif // PREFERENCE_CACHE_H
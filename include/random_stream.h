@@ -0,0 +1,74 @@
+/**
+ * Seedable random number streams for the patterns
+ *
+ * Each pattern owns a RandomStream (Pattern::rng), so patterns rendering
+ * side by side during a crossfade do not change each other's sequences.
+ * seedPatterns() (patterns.h) derives every stream from one seed: the
+ * same seed followed by the same selections replays the same frames,
+ * which the native benchmark uses to check patterns frame by frame.
+ *
+ * The generator is xorshift32: three shifts and XORs per 32 bits, no
+ * multiply, and far cheaper than Arduino's random(), which goes through
+ * the hardware RNG and a modulo on the ESP32. Its quality is plenty for
+ * animation. fill() takes a frame's worth of random bytes in one call.
+ */
+
+#ifndef RANDOM_STREAM_H
+#define RANDOM_STREAM_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define RANDOM_GOLDEN_GAMMA   0x9E3779B9   // Spacing between derived stream seeds
+
+class RandomStream {
+public:
+  // Seeds that differ by one give unrelated sequences (splitmix32)
+  void seed(uint32_t value) {
+    value += RANDOM_GOLDEN_GAMMA;
+    value = (value ^ (value >> 16)) * 0x85EBCA6B;
+    value = (value ^ (value >> 13)) * 0xC2B2AE35;
+    value ^= value >> 16;
+    state = value != 0 ? value : RANDOM_GOLDEN_GAMMA;  // xorshift never leaves 0
+  }
+
+  uint32_t next() {
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+  }
+
+  // 0 to bound - 1, by multiply-shift instead of a modulo
+  uint32_t below(uint32_t bound) {
+    return (uint32_t)(((uint64_t)next() * bound) >> 32);
+  }
+
+  // low to high - 1, like Arduino's random(low, high)
+  int32_t between(int32_t low, int32_t high) {
+    return high > low ? low + (int32_t)below(high - low) : low;
+  }
+
+  // count random bytes, four per step
+  void fill(uint8_t* bytes, size_t count) {
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+      uint32_t value = next();
+      bytes[i] = value;
+      bytes[i + 1] = value >> 8;
+      bytes[i + 2] = value >> 16;
+      bytes[i + 3] = value >> 24;
+    }
+    if (i < count) {
+      uint32_t value = next();
+      for (; i < count; i++, value >>= 8) {
+        bytes[i] = value;
+      }
+    }
+  }
+
+private:
+  uint32_t state = RANDOM_GOLDEN_GAMMA;
+};
+
+#endif // RANDOM_STREAM_H
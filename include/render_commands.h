@@ -0,0 +1,49 @@
+/**
+ * Commands from the web handlers to the renderer
+ *
+ * The HTTP routes and WebSocket handler never touch the pattern engine,
+ * the frame output or the active layout directly. They post a command to
+ * a lock-free queue; the render task applies all queued commands at the
+ * next frame boundary, so a frame is never rendered with half-applied
+ * settings and a slow client never holds up the animation.
+ */
+
+#ifndef RENDER_COMMANDS_H
+#define RENDER_COMMANDS_H
+
+#include <Arduino.h>
+#include <atomic>
+#include "spsc_queue.h"
+
+#define RENDER_QUEUE_SIZE   16    // Pending commands (power of two)
+
+enum RenderCommandType : uint8_t {
+  RENDER_SELECT_PATTERN = 0,  // value: pattern index
+  RENDER_NEXT_PATTERN,        // Cycle to the next pattern
+  RENDER_SET_COLOR,           // value: 0xRRGGBB, shown on Static unless Spiral is running
+  RENDER_SET_BRIGHTNESS,      // value: 1-255
+  RENDER_SET_LAYOUT,          // value: PixelLayoutType (custom map must be loaded first)
+  RENDER_SET_TRANSITION,      // value: crossfade time for pattern changes (ms)
+};
+
+struct RenderCommand {
+  uint8_t type;
+  uint32_t value;
+};
+
+typedef SpscQueue<RenderCommand, RENDER_QUEUE_SIZE> RenderCommandQueue;
+
+// Filled by the network task, drained by the render task
+extern RenderCommandQueue renderCommands;
+
+// Commands the render task has finished applying, reported in /metrics
+// next to the commands posted and dropped (render_task.h)
+extern std::atomic<uint32_t> renderCommandsApplied;
+
+// Apply one command to the pattern engine, frame output and layout
+void applyRenderCommand(const RenderCommand& command);
+
+// Apply every queued command; returns how many were applied
+uint8_t processRenderCommands();
+
+#endif // RENDER_COMMANDS_H
@@ -0,0 +1,33 @@
+/**
+ * FreeRTOS task that renders and shows the patterns
+ *
+ * The render task runs at a higher priority than the tasks serving
+ * clients: the Arduino loop task (WebSocket) and the async TCP task
+ * (HTTP). It sleeps until the current pattern's next frame is due or a
+ * command is posted, applies queued commands at the frame boundary and
+ * then renders.
+ */
+
+#ifndef RENDER_TASK_H
+#define RENDER_TASK_H
+
+#include <Arduino.h>
+#include "render_commands.h"
+
+#define RENDER_TASK_STACK     4096  // Bytes
+#define RENDER_TASK_PRIORITY  4     // Above async TCP (3) and loop (1), below WiFi
+
+// Start the render task; call once from setup() after the state is loaded
+void startRenderTask();
+
+// Queue a command for the render task and wake it up. Only call from
+// the loop task (the queue has a single producer). Returns false and
+// drops the command if the queue is full.
+bool postRenderCommand(RenderCommandType type, uint32_t value = 0);
+
+// Commands queued and commands rejected because the queue was full
+// (written by the loop task, reported in /metrics)
+extern uint32_t renderCommandsPosted;
+extern uint32_t renderCommandsDropped;
+
+#endif // RENDER_TASK_H
@@ -0,0 +1,56 @@
+/**
+ * Lock-free single-producer / single-consumer queue
+ *
+ * One task pushes, one task pops. Neither side ever blocks or takes a
+ * lock; push() fails when the queue is full and pop() when it is empty.
+ */
+
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+
+#include <stdint.h>
+#include <atomic>
+
+template <typename T, uint32_t N>
+class SpscQueue {
+  static_assert(N > 0 && (N & (N - 1)) == 0, "Queue size must be a power of two");
+
+public:
+  // Producer side; returns false if the queue is full
+  bool push(const T& item) {
+    uint32_t h = head.load(std::memory_order_relaxed);
+    if (h - tail.load(std::memory_order_acquire) == N) {
+      return false;
+    }
+    items[h % N] = item;
+    head.store(h + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Consumer side; returns false if the queue is empty
+  bool pop(T& item) {
+    uint32_t t = tail.load(std::memory_order_relaxed);
+    if (t == head.load(std::memory_order_acquire)) {
+      return false;
+    }
+    item = items[t % N];
+    tail.store(t + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Producer side; pushes that will succeed
+  uint32_t space() const {
+    return N - (head.load(std::memory_order_relaxed) - tail.load(std::memory_order_acquire));
+  }
+
+  bool empty() const {
+    return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire);
+  }
+
+private:
+  T items[N];
+  std::atomic<uint32_t> head{0};  // Next slot to write (producer)
+  std::atomic<uint32_t> tail{0};  // Next slot to read (consumer)
+};
+
+#endif // SPSC_QUEUE_H
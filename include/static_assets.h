@@ -0,0 +1,58 @@
+/**
+ * Static web assets: gzipped files, ETags and a RAM hot set
+ *
+ * tools/compress_assets.py gzips web/ into data/ at build time. At boot
+ * the firmware derives a strong ETag from each asset's bytes and keeps
+ * the small, frequently loaded ones ("hot") in RAM, so a page load with
+ * a matching If-None-Match is answered with 304 and a repeat full load
+ * never reads flash.
+ */
+
+#ifndef STATIC_ASSETS_H
+#define STATIC_ASSETS_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define ASSET_HOT_BUDGET    16384   // Max bytes of assets kept in RAM
+#define ASSET_ETAG_SIZE     20      // "xxxxxxxx-xxxxxx" + quotes + null
+
+struct StaticAsset {
+  const char* uri;            // Route ("/")
+  const char* path;           // Gzipped file on LittleFS ("/index.html.gz")
+  const char* fallbackPath;   // Uncompressed file for older filesystem images
+  const char* contentType;
+  bool hot;                   // Keep in RAM if it fits the budget
+
+  // Filled in at boot
+  bool available;
+  bool gzip;                  // Serving path (gzipped) rather than fallbackPath
+  size_t size;                // Bytes on the wire
+  const uint8_t* data;        // RAM copy, null if served from flash
+  char etag[ASSET_ETAG_SIZE];
+
+  // Counters
+  uint32_t requests;
+  uint32_t notModified;       // Answered with 304
+  uint32_t flashReads;        // Bodies streamed from LittleFS
+  uint32_t bytesSent;
+};
+
+extern StaticAsset staticAssets[];
+extern const uint8_t staticAssetCount;
+
+// Asset served for a route, or null
+StaticAsset* findStaticAsset(const char* uri);
+
+// Strong ETag from the asset bytes: "<fnv1a32>-<size>" in hex
+void makeAssetETag(const uint8_t* data, size_t size, char* etag);
+
+// Same ETag built incrementally, for files read in chunks
+uint32_t assetHashUpdate(uint32_t hash, const uint8_t* data, size_t size);
+#define ASSET_HASH_INIT     2166136261u
+void formatAssetETag(uint32_t hash, size_t size, char* etag);
+
+// True if an If-None-Match header value lists the ETag (or is "*")
+bool etagMatches(const char* ifNoneMatch, const char* etag);
+
+#endif // STATIC_ASSETS_H
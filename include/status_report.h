@@ -0,0 +1,73 @@
+/**
+ * Controller status as JSON, written into fixed buffers
+ *
+ * The status broadcaster remembers what it last sent to the WebSocket
+ * clients. It only sends the fields that changed since then, at most
+ * once per interval, so a burst of slider commands collapses into one
+ * message holding the final values. The same serializer writes the full
+ * status for /status and for newly connected clients.
+ */
+
+#ifndef STATUS_REPORT_H
+#define STATUS_REPORT_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define STATUS_JSON_SIZE    256   // Buffer size that fits every field
+
+// Fields of a status message (bit mask)
+enum StatusField : uint8_t {
+  STATUS_PATTERN             = 0x01,  // "mode" and "pattern"
+  STATUS_COLOR               = 0x02,
+  STATUS_BRIGHTNESS          = 0x04,
+  STATUS_AUTO_CYCLE          = 0x08,
+  STATUS_AUTO_CYCLE_INTERVAL = 0x10,
+  STATUS_FRAMES              = 0x20,  // Frame counters, only sent on request
+  STATUS_SETTINGS            = 0x1F,  // Everything clients keep in sync
+};
+
+struct StatusState {
+  uint8_t pattern;
+  uint32_t staticColor;
+  uint8_t brightness;
+  bool autoCycle;
+  uint32_t autoCycleInterval;
+  uint32_t framesRendered;
+  uint32_t framesPushed;
+};
+
+// Settings fields that differ between two states
+uint8_t diffStatus(const StatusState& a, const StatusState& b);
+
+// Write {"type":"status","version":N,...} with the given fields. Returns
+// the length, or 0 if the buffer is too small.
+size_t writeStatusJson(char* buffer, size_t size, const StatusState& state,
+                       uint8_t fields, uint32_t version);
+
+class StatusBroadcaster {
+public:
+  explicit StatusBroadcaster(uint16_t minIntervalMillis) : minInterval(minIntervalMillis) {}
+
+  // Write a message with the fields changed since the last one, if any
+  // changed and the minimum interval has passed. Returns its length, 0
+  // if nothing should be sent now.
+  size_t poll(const StatusState& state, uint32_t nowMillis, char* buffer, size_t size);
+
+  // Write the full settings at the current version (for one client)
+  size_t snapshot(const StatusState& state, char* buffer, size_t size) const;
+
+  void setMinInterval(uint16_t minIntervalMillis) { minInterval = minIntervalMillis; }
+
+  uint32_t version = 0;          // Bumped for every change that goes out
+  uint32_t messagesSent = 0;
+  uint32_t pollsDeferred = 0;    // Changes held back by the rate limit
+
+private:
+  uint16_t minInterval;
+  StatusState sent = {};
+  bool hasSent = false;
+  uint32_t lastSentMillis = 0;
+};
+
+#endif // STATUS_REPORT_H
@@ -0,0 +1,74 @@
+/**
+ * WebSocket command protocol
+ *
+ * Clients send commands either as compact binary frames or, as a
+ * fallback, as the original JSON text messages. Both decode into the same
+ * WsCommand without allocating, so the handler does not care which form
+ * arrived.
+ *
+ * Binary frame (all multi-byte fields little-endian):
+ *   byte 0   protocol version (WS_PROTOCOL_VERSION)
+ *   byte 1   opcode (WsOpcode)
+ *   byte 2-  fixed-width payload for the opcode:
+ *            SELECT_PATTERN       u8 pattern index
+ *            NEXT                 -
+ *            COLOR                u8 red, u8 green, u8 blue
+ *            BRIGHTNESS           u8 brightness
+ *            STATUS               -
+ *            AUTO_CYCLE           - (toggles)
+ *            AUTO_CYCLE_INTERVAL  u32 interval in ms
+ *            LAYOUT               u8 PixelLayoutType
+ *            PREVIEW              u8 frames per second, 0 stops
+ *            TRANSITION           u16 crossfade time in ms, 0 cuts
+ *
+ * The controller sends preview frames back with the PREVIEW opcode (see
+ * include/frame_preview.h).
+ *
+ * JSON message: {"command":"<name>","value":<number or "string">}, where
+ * <name> is a pattern key, "next", "color" (value "RRGGBB"), "brightness",
+ * "status", "autoCycle", "autoCycleInterval", "layout", "preview" or
+ * "transition".
+ */
+
+#ifndef WS_PROTOCOL_H
+#define WS_PROTOCOL_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define WS_PROTOCOL_VERSION   1
+#define WS_HEADER_SIZE        2     // Version + opcode
+
+enum WsOpcode : uint8_t {
+  WS_OP_INVALID = 0,
+  WS_OP_SELECT_PATTERN,
+  WS_OP_NEXT,
+  WS_OP_COLOR,
+  WS_OP_BRIGHTNESS,
+  WS_OP_STATUS,
+  WS_OP_AUTO_CYCLE,
+  WS_OP_AUTO_CYCLE_INTERVAL,
+  WS_OP_LAYOUT,
+  WS_OP_PREVIEW,
+  WS_OP_TRANSITION,
+  WS_OP_COUNT
+};
+
+struct WsCommand {
+  uint8_t opcode;
+  uint32_t value;   // Pattern index, 0xRRGGBB, brightness, interval (ms), layout, FPS or transition (ms)
+};
+
+// Decode a binary frame; false for an unknown version/opcode or a frame
+// whose length does not match the opcode's payload
+bool decodeBinaryCommand(const uint8_t* data, size_t length, WsCommand& command);
+
+// Encode a command as a binary frame; returns the frame length, or 0 if
+// the buffer is too small or the opcode is unknown
+size_t encodeBinaryCommand(const WsCommand& command, uint8_t* buffer, size_t size);
+
+// Parse a JSON command in a single pass; false if the text is not a flat
+// JSON object or names no known command
+bool parseJsonCommand(const char* text, size_t length, WsCommand& command);
+
+#endif // WS_PROTOCOL_H
@@ -0,0 +1,189 @@
+/**
+ * Stored animations: compact frame container and streaming player
+ */
+
+#include "animation.h"
+#include "pixel_layout.h"
+#include <string.h>
+
+AnimationSource* animationSource = nullptr;
+
+bool parseAnimationHeader(const uint8_t* data, size_t length, AnimationHeader& header) {
+  if (length < ANIMATION_HEADER_SIZE || memcmp(data, "LANI", 4) != 0 ||
+      data[4] != ANIMATION_VERSION || data[5] != GRID_WIDTH || data[6] != GRID_HEIGHT) {
+    return false;
+  }
+  header.flags = data[7];
+  header.frameInterval = data[8] | (data[9] << 8);
+  header.keyframeInterval = data[10] | (data[11] << 8);
+  header.frameCount = data[12] | (data[13] << 8) | ((uint32_t)data[14] << 16) | ((uint32_t)data[15] << 24);
+  return header.frameCount > 0;
+}
+
+size_t writeAnimationHeader(const AnimationHeader& header, uint8_t* buffer) {
+  memcpy(buffer, "LANI", 4);
+  buffer[4] = ANIMATION_VERSION;
+  buffer[5] = GRID_WIDTH;
+  buffer[6] = GRID_HEIGHT;
+  buffer[7] = header.flags;
+  buffer[8] = header.frameInterval;
+  buffer[9] = header.frameInterval >> 8;
+  buffer[10] = header.keyframeInterval;
+  buffer[11] = header.keyframeInterval >> 8;
+  buffer[12] = header.frameCount;
+  buffer[13] = header.frameCount >> 8;
+  buffer[14] = header.frameCount >> 16;
+  buffer[15] = header.frameCount >> 24;
+  return ANIMATION_HEADER_SIZE;
+}
+
+static uint8_t* writeRgb(uint8_t* out, uint32_t color) {
+  *out++ = color >> 16;
+  *out++ = color >> 8;
+  *out++ = color;
+  return out;
+}
+
+size_t encodeAnimationFrame(const uint32_t* previous, const uint32_t* cells, bool keyframe,
+                            uint8_t* buffer) {
+  uint8_t* out = buffer + ANIMATION_RECORD_HEADER;
+  uint16_t i = 0;
+
+  while (i < NUM_PIXELS) {
+    uint16_t n = 1;
+    if (!keyframe && cells[i] == previous[i]) {
+      while (i + n < NUM_PIXELS && n < ANIMATION_MAX_COUNT && cells[i + n] == previous[i + n]) n++;
+      *out++ = ANIMATION_OP_SKIP | (n - 1);
+    } else {
+      while (i + n < NUM_PIXELS && n < ANIMATION_MAX_COUNT && cells[i + n] == cells[i]) n++;
+      if (n > 1) {
+        *out++ = ANIMATION_OP_RUN | (n - 1);
+        out = writeRgb(out, cells[i]);
+      } else {
+        // Literal until a run or an unchanged cell, which encode smaller
+        while (i + n < NUM_PIXELS && n < ANIMATION_MAX_COUNT &&
+               (keyframe || cells[i + n] != previous[i + n]) &&
+               (i + n + 1 >= NUM_PIXELS || cells[i + n + 1] != cells[i + n])) {
+          n++;
+        }
+        *out++ = ANIMATION_OP_LITERAL | (n - 1);
+        for (uint16_t k = 0; k < n; k++) {
+          out = writeRgb(out, cells[i + k]);
+        }
+      }
+    }
+    i += n;
+  }
+
+  size_t length = out - buffer - ANIMATION_RECORD_HEADER;
+  buffer[0] = keyframe ? ANIMATION_KEYFRAME : 0;
+  buffer[1] = length;
+  buffer[2] = length >> 8;
+  return out - buffer;
+}
+
+static inline Color16 readRgb(const uint8_t* rgb) {
+  return { (uint16_t)(rgb[0] * 257), (uint16_t)(rgb[1] * 257), (uint16_t)(rgb[2] * 257) };
+}
+
+bool decodeAnimationFrame(const uint8_t* payload, size_t length, Frame& frame) {
+  const uint8_t* end = payload + length;
+  const uint16_t* pixelIndex = pixelLayout().cellPixel;
+  uint16_t cell = 0;
+
+  while (payload < end) {
+    uint8_t token = *payload++;
+    uint8_t op = token & ANIMATION_OP_MASK;
+    uint8_t count = (token & ~ANIMATION_OP_MASK) + 1;
+    if (op == ANIMATION_OP_MASK || cell + count > NUM_PIXELS) {
+      return false;
+    }
+    size_t bytes = op == ANIMATION_OP_LITERAL ? count * 3 : op == ANIMATION_OP_RUN ? 3 : 0;
+    if ((size_t)(end - payload) < bytes) {
+      return false;
+    }
+
+    // One loop per op, so the op is not tested per cell; SKIP only moves on
+    if (op == ANIMATION_OP_RUN) {
+      Color16 color = readRgb(payload);
+      for (uint8_t k = 0; k < count; k++) {
+        frame.pixel[pixelIndex[k]] = color;
+      }
+    } else if (op == ANIMATION_OP_LITERAL) {
+      for (uint8_t k = 0; k < count; k++) {
+        frame.pixel[pixelIndex[k]] = readRgb(payload + k * 3);
+      }
+    }
+    pixelIndex += count;
+    cell += count;
+    payload += bytes;
+  }
+  return cell == NUM_PIXELS;
+}
+
+bool AnimationPlayer::open(AnimationSource* newSource) {
+  source = newSource;
+  start = end = 0;
+  frameIndex = 0;
+  if (source == nullptr) {
+    return false;
+  }
+  if (!source->seek(0) || !fill(ANIMATION_HEADER_SIZE) ||
+      !parseAnimationHeader(buffer + start, end - start, info)) {
+    source = nullptr;
+    return false;
+  }
+  start += ANIMATION_HEADER_SIZE;
+  return true;
+}
+
+// Make at least `needed` unread bytes available, topping up the buffer
+bool AnimationPlayer::fill(size_t needed) {
+  if ((size_t)(end - start) >= needed) {
+    return true;
+  }
+  memmove(buffer, buffer + start, end - start);
+  end -= start;
+  start = 0;
+  while (end < needed) {
+    size_t count = source->read(buffer + end, sizeof(buffer) - end);
+    sourceReads++;
+    if (count == 0) {
+      return false;
+    }
+    end += count;
+    bytesRead += count;
+  }
+  return true;
+}
+
+bool AnimationPlayer::rewind() {
+  start = end = 0;
+  frameIndex = 0;
+  return source->seek(ANIMATION_HEADER_SIZE);
+}
+
+bool AnimationPlayer::nextFrame(Frame& frame) {
+  if (source == nullptr) {
+    return false;
+  }
+  if (frameIndex == info.frameCount && (!(info.flags & ANIMATION_LOOP) || !rewind())) {
+    source = nullptr;
+    return false;
+  }
+
+  if (!fill(ANIMATION_RECORD_HEADER)) {
+    source = nullptr;
+    return false;
+  }
+  uint16_t length = buffer[start + 1] | (buffer[start + 2] << 8);
+  if (ANIMATION_RECORD_HEADER + length > ANIMATION_MAX_RECORD ||
+      !fill(ANIMATION_RECORD_HEADER + length) ||
+      !decodeAnimationFrame(buffer + start + ANIMATION_RECORD_HEADER, length, frame)) {
+    source = nullptr;   // Truncated or damaged file
+    return false;
+  }
+  start += ANIMATION_RECORD_HEADER + length;
+  frameIndex++;
+  return true;
+}
@@ -0,0 +1,196 @@
+/**
+ * Table-driven integer color engine
+ *
+ * All tables are const so they stay in flash. The hue wheel is generated
+ * at compile time from the same piecewise ramps ColorHSV() uses.
+ */
+
+#include "color_engine.h"
+
+// Build the hue wheel: red -> yellow -> green -> cyan -> blue -> magenta -> red
+static constexpr HueWheel buildHueWheel() {
+  HueWheel wheel = {};
+  for (uint16_t hue = 0; hue <= HUE_STEPS; hue++) {
+    HueColor &c = wheel.colors[hue];
+    if (hue < 510) {         // Red to Green-1
+      c.r = hue < 255 ? 255 : 510 - hue;
+      c.g = hue < 255 ? hue : 255;
+      c.b = 0;
+    } else if (hue < 1020) { // Green to Blue-1
+      c.r = 0;
+      c.g = hue < 765 ? 255 : 1020 - hue;
+      c.b = hue < 765 ? hue - 510 : 255;
+    } else if (hue < 1530) { // Blue to Red-1
+      c.r = hue < 1275 ? hue - 1020 : 255;
+      c.g = 0;
+      c.b = hue < 1275 ? 255 : 1530 - hue;
+    } else {                 // Last 0.5 Red
+      c.r = 255;
+      c.g = 0;
+      c.b = 0;
+    }
+  }
+  return wheel;
+}
+
+constexpr HueWheel hueWheel = buildHueWheel();
+
+const uint8_t gammaTable[256] = {
+    0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+    0,   0,   0,   0,   0,   0,   0,   0,   1,   1,   1,   1,   1,   1,   1,   1,
+    1,   1,   1,   1,   2,   2,   2,   2,   2,   2,   2,   2,   3,   3,   3,   3,
+    3,   3,   4,   4,   4,   4,   5,   5,   5,   5,   5,   6,   6,   6,   6,   7,
+    7,   7,   8,   8,   8,   9,   9,   9,  10,  10,  10,  11,  11,  11,  12,  12,
+   13,  13,  13,  14,  14,  15,  15,  16,  16,  17,  17,  18,  18,  19,  19,  20,
+   20,  21,  21,  22,  22,  23,  24,  24,  25,  25,  26,  27,  27,  28,  29,  29,
+   30,  31,  31,  32,  33,  34,  34,  35,  36,  37,  38,  38,  39,  40,  41,  42,
+   42,  43,  44,  45,  46,  47,  48,  49,  50,  51,  52,  53,  54,  55,  56,  57,
+   58,  59,  60,  61,  62,  63,  64,  65,  66,  68,  69,  70,  71,  72,  73,  75,
+   76,  77,  78,  80,  81,  82,  84,  85,  86,  88,  89,  90,  92,  93,  94,  96,
+   97,  99, 100, 102, 103, 105, 106, 108, 109, 111, 112, 114, 115, 117, 119, 120,
+  122, 124, 125, 127, 129, 130, 132, 134, 136, 137, 139, 141, 143, 145, 146, 148,
+  150, 152, 154, 156, 158, 160, 162, 164, 166, 168, 170, 172, 174, 176, 178, 180,
+  182, 184, 186, 188, 191, 193, 195, 197, 199, 202, 204, 206, 209, 211, 213, 215,
+  218, 220, 223, 225, 227, 230, 232, 235, 237, 240, 242, 245, 247, 250, 252, 255,
+};
+
+// (i / 256)^2.6 * 65535 for i = 0..256
+const uint16_t gammaTable16[257] = {
+      0,     0,     0,     1,     1,     2,     4,     6,
+      8,    11,    14,    18,    23,    28,    34,    41,
+     49,    57,    66,    76,    87,    98,   111,   125,
+    139,   155,   171,   189,   208,   228,   249,   271,
+    294,   319,   344,   371,   399,   429,   460,   492,
+    525,   560,   596,   634,   673,   714,   755,   799,
+    844,   890,   938,   988,  1039,  1092,  1146,  1202,
+   1260,  1319,  1380,  1443,  1507,  1574,  1642,  1711,
+   1783,  1856,  1931,  2008,  2087,  2168,  2251,  2335,
+   2422,  2510,  2600,  2693,  2787,  2884,  2982,  3082,
+   3185,  3289,  3396,  3505,  3616,  3729,  3844,  3961,
+   4080,  4202,  4326,  4452,  4580,  4711,  4844,  4979,
+   5116,  5256,  5398,  5542,  5689,  5838,  5990,  6144,
+   6300,  6459,  6620,  6783,  6949,  7118,  7289,  7463,
+   7639,  7817,  7998,  8182,  8368,  8557,  8749,  8943,
+   9139,  9339,  9541,  9745,  9953, 10163, 10376, 10591,
+  10809, 11030, 11254, 11480, 11710, 11942, 12176, 12414,
+  12655, 12898, 13144, 13393, 13645, 13900, 14158, 14419,
+  14682, 14949, 15218, 15491, 15766, 16045, 16326, 16611,
+  16898, 17189, 17482, 17779, 18079, 18382, 18688, 18997,
+  19309, 19624, 19943, 20265, 20589, 20917, 21249, 21583,
+  21921, 22262, 22606, 22953, 23304, 23658, 24015, 24375,
+  24739, 25106, 25477, 25850, 26228, 26608, 26992, 27379,
+  27770, 28164, 28562, 28963, 29367, 29775, 30186, 30601,
+  31019, 31441, 31866, 32295, 32728, 33164, 33603, 34046,
+  34493, 34943, 35397, 35854, 36315, 36780, 37248, 37720,
+  38196, 38675, 39158, 39645, 40135, 40629, 41127, 41628,
+  42134, 42643, 43156, 43672, 44192, 44717, 45245, 45776,
+  46312, 46852, 47395, 47942, 48493, 49048, 49607, 50170,
+  50736, 51307, 51881, 52460, 53042, 53628, 54219, 54813,
+  55411, 56014, 56620, 57230, 57845, 58463, 59085, 59712,
+  60343, 60977, 61616, 62259, 62906, 63557, 64212, 64871,
+  65535,
+
+};
+
+// sin(i * 90deg / 256) * SIN_ONE for i = 0..256
+const int16_t sineTable[257] = {
+      0,   201,   402,   603,   804,  1005,  1206,  1407,
+   1608,  1809,  2009,  2210,  2410,  2611,  2811,  3012,
+   3212,  3412,  3612,  3811,  4011,  4210,  4410,  4609,
+   4808,  5007,  5205,  5404,  5602,  5800,  5998,  6195,
+   6393,  6590,  6786,  6983,  7179,  7375,  7571,  7767,
+   7962,  8157,  8351,  8545,  8739,  8933,  9126,  9319,
+   9512,  9704,  9896, 10087, 10278, 10469, 10659, 10849,
+  11039, 11228, 11417, 11605, 11793, 11980, 12167, 12353,
+  12539, 12725, 12910, 13094, 13279, 13462, 13645, 13828,
+  14010, 14191, 14372, 14553, 14732, 14912, 15090, 15269,
+  15446, 15623, 15800, 15976, 16151, 16325, 16499, 16673,
+  16846, 17018, 17189, 17360, 17530, 17700, 17869, 18037,
+  18204, 18371, 18537, 18703, 18868, 19032, 19195, 19357,
+  19519, 19680, 19841, 20000, 20159, 20317, 20475, 20631,
+  20787, 20942, 21096, 21250, 21403, 21554, 21705, 21856,
+  22005, 22154, 22301, 22448, 22594, 22739, 22884, 23027,
+  23170, 23311, 23452, 23592, 23731, 23870, 24007, 24143,
+  24279, 24413, 24547, 24680, 24811, 24942, 25072, 25201,
+  25329, 25456, 25582, 25708, 25832, 25955, 26077, 26198,
+  26319, 26438, 26556, 26674, 26790, 26905, 27019, 27133,
+  27245, 27356, 27466, 27575, 27683, 27790, 27896, 28001,
+  28105, 28208, 28310, 28411, 28510, 28609, 28706, 28803,
+  28898, 28992, 29085, 29177, 29268, 29358, 29447, 29534,
+  29621, 29706, 29791, 29874, 29956, 30037, 30117, 30195,
+  30273, 30349, 30424, 30498, 30571, 30643, 30714, 30783,
+  30852, 30919, 30985, 31050, 31113, 31176, 31237, 31297,
+  31356, 31414, 31470, 31526, 31580, 31633, 31685, 31736,
+  31785, 31833, 31880, 31926, 31971, 32014, 32057, 32098,
+  32137, 32176, 32213, 32250, 32285, 32318, 32351, 32382,
+  32412, 32441, 32469, 32495, 32521, 32545, 32567, 32589,
+  32609, 32628, 32646, 32663, 32678, 32692, 32705, 32717,
+  32728, 32737, 32745, 32752, 32757, 32761, 32765, 32766,
+  32767,
+};
+
+// Apply saturation and value to one channel, same rounding as ColorHSV()
+static inline uint8_t scaleChannel(uint8_t c, uint16_t s1, uint8_t s2, uint16_t v1) {
+  return (uint8_t)(((((c * s1) >> 8) + s2) * v1) >> 8);
+}
+
+uint32_t colorHSV(uint16_t hue, uint8_t sat, uint8_t val) {
+  const HueColor &c = hueWheel.colors[hueIndex(hue)];
+  uint16_t v1 = 1 + val;  // 1 to 256; allows >>8 instead of /255
+  uint16_t s1 = 1 + sat;  // 1 to 256; same reason
+  uint8_t s2 = 255 - sat; // 255 to 0
+  return ((uint32_t)scaleChannel(c.r, s1, s2, v1) << 16) |
+         ((uint32_t)scaleChannel(c.g, s1, s2, v1) << 8) |
+         scaleChannel(c.b, s1, s2, v1);
+}
+
+uint32_t colorHSVGamma(uint16_t hue, uint8_t sat, uint8_t val) {
+  const HueColor &c = hueWheel.colors[hueIndex(hue)];
+  uint16_t v1 = 1 + val;
+  uint16_t s1 = 1 + sat;
+  uint8_t s2 = 255 - sat;
+  return ((uint32_t)gammaTable[scaleChannel(c.r, s1, s2, v1)] << 16) |
+         ((uint32_t)gammaTable[scaleChannel(c.g, s1, s2, v1)] << 8) |
+         gammaTable[scaleChannel(c.b, s1, s2, v1)];
+}
+
+// Same as scaleChannel() without the final >> 8, widened to 0-65535
+static inline uint16_t scaleChannel16(uint8_t c, uint16_t s1, uint8_t s2, uint16_t v1) {
+  uint32_t linear = (((c * s1) >> 8) + s2) * v1;
+  return (uint16_t)(linear + (linear >> 8));
+}
+
+uint16_t gamma16(uint16_t linear) {
+  uint8_t index = linear >> 8;
+  uint8_t fraction = linear & 0xFF;
+  uint32_t value = gammaTable16[index];
+  return (uint16_t)(value + (((gammaTable16[index + 1] - value) * fraction) >> 8));
+}
+
+Color16 colorHSVGamma16(uint16_t hue, uint8_t sat, uint8_t val) {
+  const HueColor &c = hueWheel.colors[hueIndex(hue)];
+  uint16_t v1 = 1 + val;
+  uint16_t s1 = 1 + sat;
+  uint8_t s2 = 255 - sat;
+  return { gamma16(scaleChannel16(c.r, s1, s2, v1)), gamma16(scaleChannel16(c.g, s1, s2, v1)),
+           gamma16(scaleChannel16(c.b, s1, s2, v1)) };
+}
+
+int16_t isin16(uint16_t angle) {
+  // Top two bits pick the quadrant, the next 8 index the table and the
+  // low 6 bits interpolate between neighbouring entries
+  uint8_t quadrant = angle >> 14;
+  uint16_t offset = angle & 0x3FFF;
+  if (quadrant & 1) {
+    offset = 0x4000 - offset;   // Second and fourth quadrants run backwards
+  }
+
+  uint16_t index = offset >> 6;
+  uint8_t fraction = offset & 0x3F;
+  int32_t value = sineTable[index];
+  if (fraction) {
+    value += ((sineTable[index + 1] - value) * fraction) >> 6;
+  }
+
+  return (quadrant & 2) ? (int16_t)-value : (int16_t)value;
+}
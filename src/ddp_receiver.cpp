@@ -0,0 +1,263 @@
+/**
+ * DDP pixel stream receiver with a jitter buffer
+ */
+
+#include "ddp_receiver.h"
+#include <string.h>
+#ifdef ARDUINO_ARCH_ESP32
+#include <lwip/sockets.h>
+#else
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+
+DdpReceiver ddpReceiver;
+
+bool parseDdpHeader(const uint8_t* data, size_t length, DdpHeader& header) {
+  if (length < DDP_HEADER_SIZE || (data[0] & DDP_FLAG_VERSION_MASK) != DDP_FLAG_VERSION_1) {
+    return false;
+  }
+  header.flags = data[0];
+  header.sequence = data[1] & 0x0F;
+  header.offset = ((uint32_t)data[4] << 24) | ((uint32_t)data[5] << 16) | ((uint32_t)data[6] << 8) | data[7];
+  header.length = ((uint16_t)data[8] << 8) | data[9];
+  return true;
+}
+
+size_t writeDdpHeader(const DdpHeader& header, uint8_t* buffer) {
+  buffer[0] = header.flags;
+  buffer[1] = header.sequence & 0x0F;
+  buffer[2] = 0x0B;   // Data type: 8-bit RGB
+  buffer[3] = 1;      // Destination: default output device
+  buffer[4] = header.offset >> 24;
+  buffer[5] = header.offset >> 16;
+  buffer[6] = header.offset >> 8;
+  buffer[7] = header.offset;
+  buffer[8] = header.length >> 8;
+  buffer[9] = header.length;
+  return DDP_HEADER_SIZE;
+}
+
+bool DdpReceiver::begin(uint16_t port) {
+  end();
+  int fd = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+  if (fd < 0) {
+    return false;
+  }
+  struct sockaddr_in address = {};
+  address.sin_family = AF_INET;
+  address.sin_port = htons(port);
+  address.sin_addr.s_addr = htonl(INADDR_ANY);
+  if (bind(fd, (struct sockaddr*)&address, sizeof(address)) < 0 ||
+      fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK) < 0) {
+    close(fd);
+    return false;
+  }
+  socketFd = fd;
+  flush();
+  return true;
+}
+
+void DdpReceiver::end() {
+  if (socketFd >= 0) {
+    close(socketFd);
+    socketFd = -1;
+  }
+}
+
+uint16_t DdpReceiver::localPort() const {
+  struct sockaddr_in address = {};
+  socklen_t length = sizeof(address);
+  if (socketFd < 0 || getsockname(socketFd, (struct sockaddr*)&address, &length) < 0) {
+    return 0;
+  }
+  return ntohs(address.sin_port);
+}
+
+// Position of a sequence number after the last frame shown: 1 = next,
+// <= 0 = already shown or older. Numbers run 1-15 and skip 0.
+int8_t DdpReceiver::order(uint8_t sequence) const {
+  if (!played || sequence == 0 || lastSequence == 0) {
+    return 1;
+  }
+  int8_t delta = (int8_t)((sequence - lastSequence + 15) % 15);
+  return delta > 7 ? delta - 15 : delta;
+}
+
+// A frame still being received that can no longer be shown: its PUSH
+// was lost and a later frame has been played
+bool DdpReceiver::stale(const Slot& slot) const {
+  return slot.state == SLOT_FILLING && order(slot.sequence) <= 0;
+}
+
+void DdpReceiver::dropStale() {
+  for (Slot& slot : slots) {
+    if (stale(slot)) {
+      slot.state = SLOT_FREE;
+      stats.incomplete++;
+    }
+  }
+}
+
+// Make room by dropping the oldest frame still being received (its PUSH
+// is probably lost), else the oldest complete one
+DdpReceiver::Slot* DdpReceiver::evict() {
+  Slot* oldest = nullptr;
+  for (Slot& slot : slots) {
+    if (oldest == nullptr || (slot.state == SLOT_FILLING && oldest->state != SLOT_FILLING) ||
+        (slot.state == oldest->state && order(slot.sequence) < order(oldest->sequence))) {
+      oldest = &slot;
+    }
+  }
+  stats.overflows++;
+  return oldest;
+}
+
+DdpReceiver::Slot* DdpReceiver::reserve(const DdpHeader& header) {
+  if (header.offset + header.length > DDP_FRAME_BYTES) {
+    stats.invalid++;
+    return nullptr;
+  }
+  int8_t position = order(header.sequence);
+  if (position <= 0) {
+    if (position == 0) {
+      stats.duplicates++;
+    } else {
+      stats.late++;
+    }
+    return nullptr;
+  }
+
+  // More of a frame being received, or a repeat of a buffered one
+  Slot* free = nullptr;
+  for (Slot& slot : slots) {
+    if (stale(slot)) {
+      slot.state = SLOT_FREE;
+      stats.incomplete++;
+    }
+    if (slot.state == SLOT_FREE) {
+      free = free ? free : &slot;
+    } else if (slot.sequence == header.sequence) {
+      if (slot.state == SLOT_FILLING) {
+        return &slot;
+      }
+      if (header.sequence != 0) {
+        stats.duplicates++;
+        return nullptr;
+      }
+    }
+  }
+
+  Slot* slot = free ? free : evict();
+  slot->state = SLOT_FILLING;
+  slot->sequence = header.sequence;
+  slot->start = DDP_FRAME_BYTES;
+  slot->end = 0;
+  return slot;
+}
+
+void DdpReceiver::received(Slot& slot, const DdpHeader& header, size_t bytes, uint32_t nowMillis) {
+  if (bytes != header.length) {
+    stats.invalid++;
+    bytes = bytes < header.length ? bytes : header.length;
+  }
+  if (bytes > 0) {
+    slot.start = header.offset < slot.start ? header.offset : slot.start;
+    slot.end = header.offset + bytes > slot.end ? header.offset + bytes : slot.end;
+  }
+  if (header.flags & DDP_FLAG_PUSH) {
+    slot.state = SLOT_READY;
+    slot.readyMillis = nowMillis;
+    stats.frames++;
+  }
+}
+
+void DdpReceiver::poll(uint32_t nowMillis) {
+  if (socketFd < 0) {
+    return;
+  }
+  uint8_t raw[DDP_HEADER_SIZE];
+  for (;;) {
+    ssize_t peeked = recv(socketFd, raw, sizeof(raw), MSG_PEEK | MSG_DONTWAIT);
+    if (peeked < 0) {
+      return;   // Nothing waiting
+    }
+    stats.packets++;
+
+    DdpHeader header;
+    Slot* slot = nullptr;
+    if (!parseDdpHeader(raw, peeked, header)) {
+      stats.invalid++;
+    } else {
+      slot = reserve(header);
+    }
+    if (slot == nullptr) {
+      // Reading the header discards the rest of the datagram
+      recv(socketFd, raw, sizeof(raw), MSG_DONTWAIT);
+      continue;
+    }
+
+    // Header to the stack, payload straight into the slot
+    struct iovec parts[2];
+    parts[0].iov_base = raw;
+    parts[0].iov_len = sizeof(raw);
+    parts[1].iov_base = slot->data + header.offset;
+    parts[1].iov_len = header.length;
+    struct msghdr message = {};
+    message.msg_iov = parts;
+    message.msg_iovlen = 2;
+    ssize_t length = recvmsg(socketFd, &message, MSG_DONTWAIT);
+    received(*slot, header, length > DDP_HEADER_SIZE ? length - DDP_HEADER_SIZE : 0, nowMillis);
+  }
+}
+
+bool DdpReceiver::play(uint32_t nowMillis, Frame& frame) {
+  Slot* next = nullptr;
+  uint8_t ready = 0;
+  for (Slot& slot : slots) {
+    if (slot.state != SLOT_READY) {
+      continue;
+    }
+    ready++;
+    if (next == nullptr || order(slot.sequence) < order(next->sequence) ||
+        (order(slot.sequence) == order(next->sequence) &&
+         (int32_t)(slot.readyMillis - next->readyMillis) < 0)) {
+      next = &slot;
+    }
+  }
+  // Hold frames for the jitter delay unless the buffer is filling up
+  if (next == nullptr ||
+      (nowMillis - next->readyMillis < DDP_JITTER_DELAY_MS && ready < DDP_JITTER_SLOTS - 1)) {
+    return false;
+  }
+
+  if (next->sequence != 0) {
+    stats.lost += order(next->sequence) - 1;
+    lastSequence = next->sequence;
+  }
+  played = true;
+  stats.played++;
+
+  for (uint16_t i = next->start / 3; i < next->end / 3; i++) {
+    const uint8_t* rgb = next->data + i * 3;
+    frame.pixel[i] = { (uint16_t)(rgb[0] * 257), (uint16_t)(rgb[1] * 257), (uint16_t)(rgb[2] * 257) };
+  }
+  next->state = SLOT_FREE;
+  dropStale();
+  return true;
+}
+
+void DdpReceiver::flush() {
+  if (socketFd >= 0) {
+    uint8_t raw[DDP_HEADER_SIZE];
+    while (recv(socketFd, raw, sizeof(raw), MSG_DONTWAIT) >= 0) {
+    }
+  }
+  for (Slot& slot : slots) {
+    slot.state = SLOT_FREE;
+  }
+  played = false;
+}
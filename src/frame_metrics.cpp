@@ -0,0 +1,59 @@
+/**
+ * Frame timing metrics
+ */
+
+#include "frame_metrics.h"
+#include <Arduino.h>
+#include <stdio.h>
+#ifndef ARDUINO_ARCH_ESP32
+#include <chrono>
+#endif
+
+FrameMetrics frameMetrics;
+
+#ifndef ARDUINO_ARCH_ESP32
+uint32_t metricsCycles() {
+  return (uint32_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+#endif
+
+size_t formatHistogram(char* buffer, size_t size, const char* name, const char* labels,
+                       const TimingHistogram& histogram) {
+  // Copy first so the buckets and the sum agree with each other
+  TimingHistogram snapshot = histogram;
+  uint32_t total = 0;
+  for (uint8_t i = 0; i < METRICS_BUCKETS; i++) {
+    total += snapshot.buckets[i];
+  }
+  const char* comma = labels[0] ? "," : "";
+  size_t length = 0;
+  int written;
+
+  uint32_t cumulative = 0;
+  for (uint8_t i = 0; i < METRICS_BUCKETS; i++) {
+    cumulative += snapshot.buckets[i];
+    if (i < METRICS_BUCKETS - 1) {
+      double bound = (double)(1UL << (snapshot.firstBucket + i)) * 1e-9;
+      written = snprintf(buffer + length, size - length, "%s_bucket{%s%sle=\"%.3g\"} %u\n",
+                         name, labels, comma, bound, (unsigned)cumulative);
+    } else {
+      written = snprintf(buffer + length, size - length, "%s_bucket{%s%sle=\"+Inf\"} %u\n",
+                         name, labels, comma, (unsigned)cumulative);
+    }
+    if (written < 0 || (size_t)written >= size - length) {
+      return 0;
+    }
+    length += written;
+  }
+
+  const char* open = labels[0] ? "{" : "";
+  const char* close = labels[0] ? "}" : "";
+  written = snprintf(buffer + length, size - length, "%s_sum%s%s%s %.6f\n%s_count%s%s%s %u\n",
+                     name, open, labels, close, snapshot.sumNanos * 1e-9,
+                     name, open, labels, close, (unsigned)total);
+  if (written < 0 || (size_t)written >= size - length) {
+    return 0;
+  }
+  return length + written;
+}
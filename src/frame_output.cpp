@@ -0,0 +1,60 @@
+/**
+ * Change-detecting, dithering output to the NeoPixel strip
+ */
+
+#include "frame_output.h"
+#include "frame_metrics.h"
+
+// The strip itself is defined by the firmware or by the native benchmark
+extern Adafruit_NeoPixel pixels;
+
+FrameOutput frameOutput(pixels);
+
+FrameOutput::FrameOutput(Adafruit_NeoPixel& strip) : strip(strip) {
+  // Start the carried errors spread out, so pixels showing the same color
+  // do not step up on the same frame
+  for (uint16_t i = 0; i < NUM_PIXELS; i++) {
+    for (uint8_t c = 0; c < 3; c++) {
+      residual[i][c] = (i * 97 + c * 85) & 0xFF;
+    }
+  }
+}
+
+// Brightness-scaled channel plus the carried error, down to 8 bits
+static inline uint8_t ditherChannel(uint16_t value, uint16_t scale, uint8_t& residual) {
+  uint32_t scaled = ((uint32_t)value * scale) >> 8;
+  // 8.8 fixed point; v * 257 maps to exactly v, so 8-bit colors at full
+  // brightness never dither
+  uint32_t level = scaled - (scaled >> 8) + residual;
+  residual = level & 0xFF;
+  return level >> 8;
+}
+
+bool FrameOutput::present(const Frame& frame) {
+  framesRendered++;
+  if (!dirty && memcmp(frame.pixel, shown.pixel, sizeof(shown.pixel)) == 0) {
+    return false;
+  }
+
+  shown = frame;
+  dirty = false;
+  uint16_t scale = brightness + 1;
+  for (uint16_t i = 0; i < NUM_PIXELS; i++) {
+    const Color16& color = frame.pixel[i];
+    strip.setPixelColor(i, ditherChannel(color.r, scale, residual[i][0]),
+                        ditherChannel(color.g, scale, residual[i][1]),
+                        ditherChannel(color.b, scale, residual[i][2]));
+  }
+  uint32_t start = metricsCycles();
+  strip.show();
+  frameMetrics.show.record(metricsNanos(metricsCycles() - start));
+  framesPushed++;
+  return true;
+}
+
+void FrameOutput::setBrightness(uint8_t value) {
+  if (value != brightness) {
+    brightness = value;
+    dirty = true;
+  }
+}
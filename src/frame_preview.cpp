@@ -0,0 +1,90 @@
+/**
+ * Live frame preview for WebSocket clients
+ */
+
+#include "frame_preview.h"
+#include "pixel_layout.h"
+#include "ws_protocol.h"
+
+#define NO_SEQUENCE 0xFFFFFFFFu   // Nothing sent yet
+
+void PreviewStream::subscribe(uint8_t client, uint8_t fps, uint32_t nowMillis) {
+  if (client >= PREVIEW_MAX_CLIENTS) {
+    return;
+  }
+  PreviewClient& c = clients[client];
+  c = {};
+  if (fps == 0) {
+    return;
+  }
+  c.fps = fps > PREVIEW_MAX_FPS ? PREVIEW_MAX_FPS : fps;
+  c.interval = 1000 / c.fps;
+  c.nextMillis = nowMillis;
+  c.lastSequence = NO_SEQUENCE;
+}
+
+bool PreviewStream::due(uint8_t client, uint32_t sequence, uint32_t nowMillis) const {
+  if (client >= PREVIEW_MAX_CLIENTS) {
+    return false;
+  }
+  const PreviewClient& c = clients[client];
+  return c.fps != 0 && sequence != c.lastSequence && (int32_t)(nowMillis - c.nextMillis) >= 0;
+}
+
+void PreviewStream::sent(uint8_t client, uint32_t sequence, uint32_t nowMillis, bool ok,
+                         uint32_t sendMicros) {
+  if (client >= PREVIEW_MAX_CLIENTS || clients[client].fps == 0) {
+    return;
+  }
+  PreviewClient& c = clients[client];
+  if (!ok) {
+    sendFailures++;
+    if (++c.failures >= PREVIEW_MAX_FAILURES) {
+      unsubscribe(client);
+      return;
+    }
+    c.backoff = PREVIEW_MAX_BACKOFF;
+  } else {
+    c.failures = 0;
+    if (c.lastSequence != NO_SEQUENCE) {
+      c.framesSkipped += sequence - c.lastSequence - 1;
+    }
+    c.lastSequence = sequence;
+    c.framesSent++;
+
+    // Back off while sends block, recover one step per quick send
+    if (sendMicros >= PREVIEW_SLOW_SEND_US) {
+      if (c.backoff < PREVIEW_MAX_BACKOFF) c.backoff++;
+    } else if (c.backoff > 0) {
+      c.backoff--;
+    }
+  }
+  c.nextMillis = nowMillis + ((uint32_t)c.interval << c.backoff);
+}
+
+uint8_t PreviewStream::subscribers() const {
+  uint8_t count = 0;
+  for (const PreviewClient& c : clients) {
+    count += c.fps != 0;
+  }
+  return count;
+}
+
+size_t encodePreviewFrame(const Frame& frame, uint16_t sequence, uint8_t* buffer) {
+  buffer[0] = WS_PROTOCOL_VERSION;
+  buffer[1] = WS_OP_PREVIEW;
+  buffer[2] = sequence & 0xFF;
+  buffer[3] = sequence >> 8;
+
+  uint8_t* out = buffer + 4;
+  const uint16_t* pixelIndex = pixelLayout().cellPixel;
+  for (uint8_t row = 0; row < GRID_HEIGHT; row++) {
+    for (uint8_t col = 0; col < GRID_WIDTH; col++) {
+      uint32_t color = color8(frame.pixel[*pixelIndex++]);
+      *out++ = color >> 16;
+      *out++ = color >> 8;
+      *out++ = color;
+    }
+  }
+  return PREVIEW_FRAME_SIZE;
+}
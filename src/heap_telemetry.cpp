@@ -0,0 +1,142 @@
+/**
+ * Heap telemetry: allocations per code path and free-heap history
+ */
+
+#include "heap_telemetry.h"
+#include <atomic>
+#include <string.h>
+#ifdef ARDUINO_ARCH_ESP32
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#endif
+
+// The scope open on one task. Slots are claimed on a task's first scope
+// and kept; the allocator hooks find theirs by comparing task handles.
+struct TaskScope {
+  std::atomic<const void*> task{nullptr};
+  AllocSite* site = nullptr;
+};
+
+static TaskScope taskScopes[ALLOC_MAX_TASKS];
+static AllocSite* allocSites = nullptr;
+
+AllocSite unattributedAllocs("unattributed");
+HeapHistory heapHistory;
+
+static inline const void* currentTask() {
+#ifdef ARDUINO_ARCH_ESP32
+  return xTaskGetCurrentTaskHandle();
+#else
+  static thread_local char marker;
+  return &marker;
+#endif
+}
+
+static inline AllocSite& currentSite() {
+  const void* self = currentTask();
+  for (TaskScope& slot : taskScopes) {
+    if (slot.task.load(std::memory_order_relaxed) == self) {
+      return slot.site != nullptr ? *slot.site : unattributedAllocs;
+    }
+  }
+  return unattributedAllocs;
+}
+
+AllocSite::AllocSite(const char* siteName) {
+  strncpy(name, siteName, sizeof(name) - 1);
+  name[sizeof(name) - 1] = '\0';
+  nextSite = allocSites;
+  allocSites = this;
+}
+
+AllocSite* firstAllocSite() {
+  return allocSites;
+}
+
+AllocScope::AllocScope(AllocSite& site) : task(nullptr), previous(nullptr) {
+  const void* self = currentTask();
+  for (TaskScope& slot : taskScopes) {
+    const void* owner = slot.task.load(std::memory_order_acquire);
+    if (owner == nullptr) {
+      // Claim a free slot (another task may get there first)
+      if (slot.task.compare_exchange_strong(owner, self) || owner == self) {
+        task = &slot;
+        break;
+      }
+    } else if (owner == self) {
+      task = &slot;
+      break;
+    }
+  }
+  if (task != nullptr) {
+    previous = task->site;
+    task->site = &site;
+  }
+  site.entries++;
+}
+
+AllocScope::~AllocScope() {
+  if (task != nullptr) {
+    task->site = previous;
+  }
+}
+
+void allocTrackerAlloc(size_t bytes) {
+  AllocSite& site = currentSite();
+  site.allocations++;
+  site.bytes += bytes;
+}
+
+void allocTrackerFree() {
+  currentSite().frees++;
+}
+
+void HeapHistory::add(const HeapSample& sample) {
+  samples[next] = sample;
+  next = (next + 1) % HEAP_HISTORY_SAMPLES;
+  if (count < HEAP_HISTORY_SAMPLES) {
+    count++;
+  }
+  if (sample.freeBytes < minFreeBytes) {
+    minFreeBytes = sample.freeBytes;
+  }
+  if (sample.largestBlock < minLargestBlock) {
+    minLargestBlock = sample.largestBlock;
+  }
+  if (sample.fragmentation() > maxFragmentation) {
+    maxFragmentation = sample.fragmentation();
+  }
+}
+
+#ifdef ARDUINO_ARCH_ESP32
+// Allocator hooks, linked in with -Wl,--wrap=malloc etc.
+extern "C" {
+void* __real_malloc(size_t size);
+void* __real_calloc(size_t count, size_t size);
+void* __real_realloc(void* ptr, size_t size);
+void __real_free(void* ptr);
+
+void* __wrap_malloc(size_t size) {
+  allocTrackerAlloc(size);
+  return __real_malloc(size);
+}
+
+void* __wrap_calloc(size_t count, size_t size) {
+  allocTrackerAlloc(count * size);
+  return __real_calloc(count, size);
+}
+
+void* __wrap_realloc(void* ptr, size_t size) {
+  // Growing a String is still heap churn, count it as an allocation
+  allocTrackerAlloc(size);
+  return __real_realloc(ptr, size);
+}
+
+void __wrap_free(void* ptr) {
+  if (ptr != nullptr) {
+    allocTrackerFree();
+  }
+  __real_free(ptr);
+}
+}
+#endif
@@ -0,0 +1,82 @@
+/**
+ * Leveled logging into a RAM ring buffer
+ */
+
+#include "log_buffer.h"
+#include <Arduino.h>
+#include <stdio.h>
+#include <string.h>
+
+LogBuffer logBuffer;
+
+void LogBuffer::write(uint8_t level, uint32_t nowMillis, const char* format, va_list args) {
+  uint32_t sequence = head.fetch_add(1, std::memory_order_relaxed);
+  Slot& slot = slots[sequence % LOG_SLOTS];
+
+  // Readers that copy the slot from here on see it change and skip it
+  slot.published.store(0, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  slot.millis = nowMillis;
+  slot.level = level;
+  vsnprintf(slot.text, sizeof(slot.text), format, args);
+  slot.published.store(sequence + 1, std::memory_order_release);
+}
+
+bool LogBuffer::read(LogCursor& cursor, LogEntry& entry) {
+  uint32_t end = head.load(std::memory_order_acquire);
+  if (end - cursor.next > LOG_SLOTS) {
+    cursor.dropped += end - LOG_SLOTS - cursor.next;
+    cursor.next = end - LOG_SLOTS;
+  }
+
+  while (cursor.next != end) {
+    const Slot& slot = slots[cursor.next % LOG_SLOTS];
+    uint32_t published = slot.published.load(std::memory_order_acquire);
+    if (published == 0 || (int32_t)(published - (cursor.next + 1)) < 0) {
+      return false;   // Claimed but not written yet
+    }
+    if (published == cursor.next + 1) {
+      entry.millis = slot.millis;
+      entry.level = slot.level;
+      memcpy(entry.text, slot.text, sizeof(entry.text));
+      entry.text[sizeof(entry.text) - 1] = '\0';
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (slot.published.load(std::memory_order_relaxed) == published) {
+        entry.sequence = cursor.next++;
+        return true;
+      }
+    }
+    // Overwritten by a newer line before (or while) it was copied
+    cursor.dropped++;
+    cursor.next++;
+  }
+  return false;
+}
+
+LogCursor LogBuffer::oldest() const {
+  LogCursor cursor;
+  uint32_t end = head.load(std::memory_order_acquire);
+  cursor.next = end > LOG_SLOTS ? end - LOG_SLOTS : 0;
+  return cursor;
+}
+
+void logWrite(uint8_t level, const char* format, ...) {
+  va_list args;
+  va_start(args, format);
+  logBuffer.write(level, millis(), format, args);
+  va_end(args);
+}
+
+char logLevelLetter(uint8_t level) {
+  static const char letters[] = "-EWID";
+  return level < sizeof(letters) - 1 ? letters[level] : '?';
+}
+
+size_t formatLogLine(const LogEntry& entry, char* buffer, size_t size) {
+  int length = snprintf(buffer, size, "[%6u.%03u] %c %s\n", (unsigned)(entry.millis / 1000),
+                        (unsigned)(entry.millis % 1000), logLevelLetter(entry.level), entry.text);
+  if (length < 0) {
+    return 0;
+  }
+  return (size_t)length < size ? (size_t)length : size - 1;
+}
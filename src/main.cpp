@@ -7,16 +7,36 @@
 
 #include <Arduino.h>
 #include <WiFi.h>
-#include <WebServer.h>
+#include <ESPAsyncWebServer.h>
 #include <WebSocketsServer.h>
 #include <LittleFS.h>
 #include <Adafruit_NeoPixel.h>
 #include <Preferences.h>
+#include "patterns.h"
+#include "color_engine.h"
+#include "pixel_layout.h"
+#include "render_task.h"
+#include "ws_protocol.h"
+#include "status_report.h"
+#include "preference_cache.h"
+#include "static_assets.h"
+#include "frame_preview.h"
+#include "ddp_receiver.h"
+#include "animation.h"
+#include "log_buffer.h"
+#include "frame_metrics.h"
+#include "heap_telemetry.h"
+#include "loop_scheduler.h"
+#include <esp_system.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#if CONFIG_PM_ENABLE
+#include <esp_pm.h>
+#endif
 
 // Forward declarations
-String getPatternName(uint8_t pattern);
 void loadPreferences();
-void savePreferences();
+bool preparePixelLayout(uint8_t type);
 
 // XIAO ESP32C3 Pin Definitions
 // Note: The XIAO ESP32C3 does NOT have a built-in LED
@@ -54,9 +74,6 @@ void savePreferences();
 // NeoPixel configuration
 // Note: Connect your external NeoPixels to D10 (pin 10)
 #define NEOPIXEL_PIN    10   // D10 pin for NeoPixels
-#define NUM_PIXELS      60    // Number of NeoPixels
-#define GRID_WIDTH      6     // Grid width (columns)
-#define GRID_HEIGHT     10    // Grid height (rows)
 #define BRIGHTNESS       64   // Brightness (0-255) - 25% of max
 
 // WiFi configuration - Access Point mode
@@ -67,8 +84,8 @@ const char* hostname = "lithophane";   // Hostname for the device
 // Create NeoPixel objects
 Adafruit_NeoPixel pixels(NUM_PIXELS, NEOPIXEL_PIN, NEO_GRB + NEO_KHZ800);
 
-// Create web server object
-WebServer server(80);
+// Create web server object (event-driven, runs in the async TCP task)
+AsyncWebServer server(80);
 
 // Create WebSocket server object
 WebSocketsServer webSocket = WebSocketsServer(81);
@@ -76,18 +93,15 @@ WebSocketsServer webSocket = WebSocketsServer(81);
 // Create Preferences object for persistent storage
 Preferences preferences;
 
+// Settings are changed in RAM and written to flash once they stop changing
+PreferenceCache<Preferences> preferenceCache(preferences, PREFERENCES_QUIET_PERIOD);
+
 // Global variables for patterns
-uint8_t currentPattern = 2;           // Current pattern (0=Rainbow, 1=Static, 2=Wave, 3=Fire, 4=Matrix, 5=Spiral, 6=Pulse) - Start on Wave
-uint32_t previousPatternMillis = 0;   // Last pattern update time
-uint32_t patternInterval = 50;        // Pattern update interval (ms)
-uint8_t patternStep = 0;              // Pattern step counter
-uint16_t waveOffset = 0;              // Wave pattern offset
-uint8_t fireIntensity = 0;            // Fire intensity
-uint16_t rainbowHue = 0;              // Rainbow hue
-uint32_t staticColor = 0xFF0000;     // Static color (default red)
 uint8_t currentBrightness = 64;       // Current brightness (25% of max)
 
 // Auto-cycle variables
+#define AUTO_CYCLE_MIN_MILLIS   3000    // Interval range, as the web UI slider offers it
+#define AUTO_CYCLE_MAX_MILLIS   60000
 bool autoCycleEnabled = false;        // Whether auto-cycling is enabled
 uint32_t autoCycleInterval = 6000;    // Auto-cycle interval (6 seconds default)
 uint32_t lastAutoCycleMillis = 0;     // Last auto-cycle time
@@ -97,865 +111,970 @@ unsigned long lastBrightnessUpdate = 0;
 unsigned long lastColorUpdate = 0;
 const long commandThrottleMs = 50;
 
-// Function to broadcast current status to all WebSocket clients
-void broadcastStatus() {
-  String mode = getPatternName(currentPattern);
-  
-  // Always send the saved static color for the color picker display
-  uint8_t r = (staticColor >> 16) & 0xFF;
-  uint8_t g = (staticColor >> 8) & 0xFF;
-  uint8_t b = staticColor & 0xFF;
-  String colorHex = "#";
-  if (r < 16) colorHex += "0";
-  colorHex += String(r, HEX);
-  if (g < 16) colorHex += "0";
-  colorHex += String(g, HEX);
-  if (b < 16) colorHex += "0";
-  colorHex += String(b, HEX);
-  colorHex.toUpperCase();
-  
-  String json = "{\"type\":\"status\",\"mode\":\"" + mode + "\",\"pattern\":" + String(currentPattern) + ",\"color\":\"" + colorHex + "\",\"brightness\":" + String(currentBrightness) + ",\"autoCycle\":" + String(autoCycleEnabled ? "true" : "false") + ",\"autoCycleInterval\":" + String(autoCycleInterval) + "}";
-  
-  // Debug output to serial
-  Serial.printf("Broadcasting status - Mode: %s, Pattern: %d, Color: %s, Brightness: %d\n", 
-                mode.c_str(), currentPattern, colorHex.c_str(), currentBrightness);
-  Serial.printf("JSON: %s\n", json.c_str());
-  
-  webSocket.broadcastTXT(json);
+// Commands from HTTP handlers, which run in the async TCP task. The loop
+// task applies them, so settings and the render queue keep one owner.
+#define HTTP_COMMAND_QUEUE_SIZE 16
+#define HTTP_CLIENT 0xFF                // handleCommand() client id for HTTP requests
+SpscQueue<WsCommand, HTTP_COMMAND_QUEUE_SIZE> httpCommands;
+uint32_t httpCommandsDropped = 0;       // Refused with 503, reported in /metrics
+
+// Status messages to the WebSocket clients, changed fields only
+#define STATUS_BROADCAST_INTERVAL 100   // Minimum time between broadcasts (ms)
+StatusBroadcaster statusBroadcaster(STATUS_BROADCAST_INTERVAL);
+
+// Live frame preview for the WebSocket clients that asked for it
+PreviewStream previewStream;
+
+// Heap allocations per code path (routes get theirs in onGet())
+AllocSite commandAllocs[WS_OP_COUNT] = {
+  AllocSite("cmd invalid"), AllocSite("cmd pattern"), AllocSite("cmd next"),
+  AllocSite("cmd color"), AllocSite("cmd brightness"), AllocSite("cmd status"),
+  AllocSite("cmd autoCycle"), AllocSite("cmd autoCycleInterval"), AllocSite("cmd layout"),
+  AllocSite("cmd preview"), AllocSite("cmd transition"),
+};
+AllocSite webSocketAllocs("ws event");
+AllocSite broadcastAllocs("status broadcast");
+AllocSite previewAllocs("preview stream");
+AllocSite logDrainAllocs("log drain");
+
+// The loop sleeps until its next deadline; HTTP commands and the button
+// wake it early (see loop_scheduler.h)
+LoopScheduler loopScheduler;
+TaskHandle_t loopTaskHandle = NULL;
+
+// Power save: the CPU may clock down to 80 MHz while the lock is released
+// (only with an IDF built with CONFIG_PM_ENABLE)
+#if CONFIG_PM_ENABLE
+esp_pm_lock_handle_t activeLock = NULL;
+#endif
+bool powerSave = false;
+
+// Function to collect the state reported in status messages
+StatusState currentStatus() {
+  StatusState state;
+  state.pattern = patternEngine.currentIndex();
+  state.staticColor = staticColor;
+  state.brightness = currentBrightness;
+  state.autoCycle = autoCycleEnabled;
+  state.autoCycleInterval = autoCycleInterval;
+  state.framesRendered = frameOutput.framesRendered;
+  state.framesPushed = frameOutput.framesPushed;
+  return state;
+}
+
+// Function to send changed status fields to all WebSocket clients
+void broadcastStatusChanges(unsigned long now) {
+  AllocScope scope(broadcastAllocs);
+  static char json[STATUS_JSON_SIZE];
+  size_t length = statusBroadcaster.poll(currentStatus(), now, json, sizeof(json));
+  if (length > 0) {
+    LOG_D("Status v%u broadcast (%u bytes)", statusBroadcaster.version, (unsigned)length);
+    webSocket.broadcastTXT(json, length);
+  }
+}
+
+// Function to send the full status to one WebSocket client
+void sendStatus(uint8_t num) {
+  AllocScope scope(broadcastAllocs);
+  char json[STATUS_JSON_SIZE];
+  size_t length = statusBroadcaster.snapshot(currentStatus(), json, sizeof(json));
+  if (length > 0) {
+    webSocket.sendTXT(num, json, length);
+  }
+}
+
+// Function to send the current frame to the preview subscribers due one
+void streamPreview(unsigned long now) {
+  if (previewStream.subscribers() == 0) {
+    return;
+  }
+  AllocScope scope(previewAllocs);
+  // Room in front for the WebSocket header, so sendBIN() does not copy
+  static uint8_t buffer[WEBSOCKETS_MAX_HEADER_SIZE + PREVIEW_FRAME_SIZE];
+  uint32_t sequence = frameOutput.framesPushed;   // Changes only with the frame
+  bool encoded = false;
+  
+  for (uint8_t num = 0; num < PREVIEW_MAX_CLIENTS; num++) {
+    if (!previewStream.due(num, sequence, now)) {
+      continue;
+    }
+    if (!encoded) {
+      Frame frame;
+      patternEngine.copyFrame(frame);
+      encodePreviewFrame(frame, sequence, buffer + WEBSOCKETS_MAX_HEADER_SIZE);
+      encoded = true;
+    }
+    uint32_t start = micros();
+    bool ok = webSocket.sendBIN(num, buffer, PREVIEW_FRAME_SIZE, true);
+    previewStream.sent(num, sequence, now, ok, micros() - start);
+  }
+}
+
+// Function to print buffered log lines while the loop is idle, only as
+// much as the serial port takes without blocking. Returns true if a line
+// is still waiting for room.
+bool drainLogs() {
+  AllocScope scope(logDrainAllocs);
+  static LogCursor cursor;
+  static char line[LOG_LINE_SIZE];
+  static size_t pending = 0;   // Formatted line waiting for room
+  static uint32_t droppedReported = 0;
+  
+  for (;;) {
+    if (pending == 0) {
+      LogEntry entry;
+      if (!logBuffer.read(cursor, entry)) {
+        return false;
+      }
+      if (cursor.dropped != droppedReported) {
+        LOG_W("%u log lines dropped", (unsigned)(cursor.dropped - droppedReported));
+        droppedReported = cursor.dropped;
+      }
+      pending = formatLogLine(entry, line, sizeof(line));
+    }
+    if ((size_t)Serial.availableForWrite() < pending) {
+      return true;
+    }
+    Serial.write((const uint8_t*)line, pending);
+    pending = 0;
+  }
+}
+
+// Function to keep an auto-cycle interval within the range the web UI offers
+uint32_t clampAutoCycleInterval(uint32_t millis) {
+  if (millis < AUTO_CYCLE_MIN_MILLIS) {
+    return AUTO_CYCLE_MIN_MILLIS;
+  }
+  return millis > AUTO_CYCLE_MAX_MILLIS ? AUTO_CYCLE_MAX_MILLIS : millis;
+}
+
+// Function to run a decoded command (WebSocket binary/JSON or HTTP)
+void handleCommand(uint8_t num, const WsCommand& command) {
+  AllocScope scope(commandAllocs[command.opcode < WS_OP_COUNT ? command.opcode : WS_OP_INVALID]);
+  unsigned long now = millis();
+  bool throttled = num != HTTP_CLIENT;   // Only slider drags need throttling
+  
+  switch (command.opcode) {
+    case WS_OP_SELECT_PATTERN:
+      if (command.value < PATTERN_COUNT) {
+        postRenderCommand(RENDER_SELECT_PATTERN, command.value);
+      }
+      break;
+      
+    case WS_OP_NEXT:
+      postRenderCommand(RENDER_NEXT_PATTERN); // Cycle to next pattern
+      break;
+      
+    case WS_OP_COLOR:
+      if (!throttled || now - lastColorUpdate >= commandThrottleMs) {
+        lastColorUpdate = now;
+        
+        // Shown on Static (or Spiral) at the next frame
+        postRenderCommand(RENDER_SET_COLOR, command.value);
+        preferenceCache.set(PREF_STATIC_COLOR, command.value, now);
+      }
+      break;
+      
+    case WS_OP_BRIGHTNESS:
+      if (!throttled || now - lastBrightnessUpdate >= commandThrottleMs) {
+        lastBrightnessUpdate = now;
+        if (command.value >= 1 && command.value <= 255) {
+          currentBrightness = command.value;
+          
+          // Redrawn at the new brightness on the next frame
+          postRenderCommand(RENDER_SET_BRIGHTNESS, currentBrightness);
+          preferenceCache.set(PREF_BRIGHTNESS, currentBrightness, now);
+        }
+      }
+      break;
+      
+    case WS_OP_STATUS:
+      // Client requesting status update
+      if (num != HTTP_CLIENT) {
+        sendStatus(num);
+      }
+      break;
+      
+    case WS_OP_AUTO_CYCLE:
+      autoCycleEnabled = !autoCycleEnabled;
+      preferenceCache.set(PREF_AUTO_CYCLE, autoCycleEnabled, now);
+      LOG_I("Auto-cycling enabled: %s", autoCycleEnabled ? "true" : "false");
+      break;
+      
+    case WS_OP_AUTO_CYCLE_INTERVAL:
+      // Clamped, so a stray 0 cannot switch patterns on every pass
+      autoCycleInterval = clampAutoCycleInterval(command.value);
+      preferenceCache.set(PREF_AUTO_CYCLE_INTERVAL, autoCycleInterval, now);
+      LOG_I("Auto-cycle interval set to: %d ms", autoCycleInterval);
+      break;
+      
+    case WS_OP_PREVIEW:
+      // Stream frames to this client at the requested FPS (0 stops)
+      if (num != HTTP_CLIENT) {
+        previewStream.subscribe(num, command.value > 255 ? 255 : command.value, now);
+      }
+      break;
+      
+    case WS_OP_TRANSITION:
+      // Crossfade time for the next pattern changes (0 cuts)
+      if (command.value <= TRANSITION_MAX_MILLIS) {
+        postRenderCommand(RENDER_SET_TRANSITION, command.value);
+        preferenceCache.set(PREF_TRANSITION, command.value, now);
+      }
+      break;
+      
+    case WS_OP_LAYOUT:
+      if (preparePixelLayout(command.value)) {
+        postRenderCommand(RENDER_SET_LAYOUT, command.value);
+        preferenceCache.set(PREF_LAYOUT, command.value, now);
+      } else {
+        LOG_W("Layout %s not applied", getLayoutName(command.value));
+      }
+      break;
+  }
+}
+
+// Function to queue a command from an HTTP handler for the loop task
+bool forwardHttpCommand(uint8_t opcode, uint32_t value = 0) {
+  WsCommand command = { opcode, value };
+  if (!httpCommands.push(command)) {
+    httpCommandsDropped++;
+    return false;
+  }
+  if (loopTaskHandle != NULL) {
+    xTaskNotifyGive(loopTaskHandle);
+  }
+  return true;
+}
+
+// Function to apply the commands queued by HTTP handlers
+void processHttpCommands() {
+  WsCommand command;
+  while (httpCommands.pop(command)) {
+    handleCommand(HTTP_CLIENT, command);
+  }
+}
+
+// Function to wake the loop task on a button edge (interrupt handler)
+void IRAM_ATTR buttonChanged() {
+  if (loopTaskHandle != NULL) {
+    vTaskNotifyGiveFromISR(loopTaskHandle, NULL);
+  }
+}
+
+// Function to let the CPU clock down between deadlines while power save
+// is on (IDF builds with CONFIG_PM_ENABLE only; compiled out otherwise)
+void setupPowerSave() {
+#if CONFIG_PM_ENABLE
+  esp_pm_config_esp32c3_t config = {};
+  config.max_freq_mhz = ESP.getCpuFreqMHz();
+  config.min_freq_mhz = 80;   // Keeps the APB clock, and so the LED timing, at 80 MHz
+#if CONFIG_FREERTOS_USE_TICKLESS_IDLE
+  // Allowed, but never reached in practice: the SoftAP keeps the chip awake
+  config.light_sleep_enable = true;
+#endif
+  if (esp_pm_configure(&config) == ESP_OK &&
+      esp_pm_lock_create(ESP_PM_CPU_FREQ_MAX, 0, "led active", &activeLock) == ESP_OK) {
+    esp_pm_lock_acquire(activeLock);
+    // No GPIO wake source: gpio_wakeup_enable() would turn the button's
+    // edge interrupt into a level one that fires for as long as it is held
+  } else {
+    activeLock = NULL;
+    LOG_W("Power management not available");
+  }
+#endif
+  // Modem sleep between beacons (station mode only; a SoftAP keeps its
+  // radio on, and the WiFi driver keeps the chip awake while it runs)
+  WiFi.setSleep(true);
+}
+
+// Function to switch power save on or off
+void updatePowerSave(bool allowed) {
+  if (allowed == powerSave) {
+    return;
+  }
+  powerSave = allowed;
+#if CONFIG_PM_ENABLE
+  if (activeLock != NULL) {
+    if (allowed) {
+      esp_pm_lock_release(activeLock);
+    } else {
+      esp_pm_lock_acquire(activeLock);
+    }
+  }
+#endif
+  LOG_D("Power save %s", allowed ? "on" : "off");
+}
+
+// Function to block the loop task until its next deadline, or until a
+// command or the button wakes it
+void waitForNextDeadline() {
+  // Block at least one tick, so the idle task always gets to run
+  TickType_t ticks = pdMS_TO_TICKS(loopScheduler.sleepMillis());
+  bool notified = ulTaskNotifyTake(pdTRUE, ticks > 0 ? ticks : 1) > 0;
+  loopScheduler.woke(notified);
 }
 
 // WebSocket event handler
 void webSocketEvent(uint8_t num, WStype_t type, uint8_t * payload, size_t length) {
+  AllocScope scope(webSocketAllocs);
+  WsCommand command;
+  
   switch(type) {
     case WStype_DISCONNECTED:
-      Serial.printf("[%u] Disconnected!\n", num);
+      LOG_I("[%u] Disconnected", num);
+      previewStream.unsubscribe(num);
       break;
       
     case WStype_CONNECTED: {
       IPAddress ip = webSocket.remoteIP(num);
-      Serial.printf("[%u] Connected from %d.%d.%d.%d url: %s\n", num, ip[0], ip[1], ip[2], ip[3], payload);
+      LOG_I("[%u] Connected from %d.%d.%d.%d url: %s", num, ip[0], ip[1], ip[2], ip[3], payload);
       
       // Send current status to newly connected client
-      broadcastStatus();
+      sendStatus(num);
       break;
     }
     
-    case WStype_TEXT: {
-      Serial.printf("[%u] get Text: %s\n", num, payload);
-      
-      String message = String((char*)payload);
-      
-      // Parse JSON commands
-      if (message.indexOf("\"command\":\"rainbow\"") > -1) {
-        currentPattern = 0; // Rainbow
-        savePreferences();
-        broadcastStatus();
-      }
-      else if (message.indexOf("\"command\":\"static\"") > -1) {
-        currentPattern = 1; // Static
-        savePreferences();
-        broadcastStatus();
-      }
-      else if (message.indexOf("\"command\":\"wave\"") > -1) {
-        currentPattern = 2; // Wave
-        savePreferences();
-        broadcastStatus();
-      }
-      else if (message.indexOf("\"command\":\"fire\"") > -1) {
-        currentPattern = 3; // Fire
-        savePreferences();
-        broadcastStatus();
-      }
-      else if (message.indexOf("\"command\":\"matrix\"") > -1) {
-        currentPattern = 4; // Matrix
-        savePreferences();
-        broadcastStatus();
-      }
-      else if (message.indexOf("\"command\":\"spiral\"") > -1) {
-        currentPattern = 5; // Spiral
-        savePreferences();
-        broadcastStatus();
-      }
-      else if (message.indexOf("\"command\":\"pulse\"") > -1) {
-        currentPattern = 6; // Pulse
-        savePreferences();
-        broadcastStatus();
-      }
-      else if (message.indexOf("\"command\":\"next\"") > -1) {
-        currentPattern = (currentPattern + 1) % 7; // Cycle to next pattern
-        savePreferences();
-        broadcastStatus();
-      }
-      else if (message.indexOf("\"command\":\"color\"") > -1) {
-        unsigned long now = millis();
-        if (now - lastColorUpdate >= commandThrottleMs) {
-          lastColorUpdate = now;
-          
-          // Extract color value from JSON
-          int colorStart = message.indexOf("\"value\":\"") + 9;
-          int colorEnd = message.indexOf("\"", colorStart);
-          if (colorStart > 8 && colorEnd > colorStart) {
-            String colorStr = message.substring(colorStart, colorEnd);
-            long hexColor = strtol(colorStr.c_str(), NULL, 16);
-            uint8_t r = (hexColor >> 16) & 0xFF;
-            uint8_t g = (hexColor >> 8) & 0xFF;
-            uint8_t b = hexColor & 0xFF;
-            
-            staticColor = pixels.Color(r, g, b);
-            if (currentPattern != 5) { // Spiral
-              currentPattern = 1; // Static
-            }
-            
-            // Update pixels immediately
-            for (int i = 0; i < NUM_PIXELS; i++) {
-              pixels.setPixelColor(i, staticColor);
-            }
-            pixels.show();
-            
-            savePreferences(); // Save the color to flash
-            broadcastStatus();
-          }
-        }
-      }
-      else if (message.indexOf("\"command\":\"brightness\"") > -1) {
-        unsigned long now = millis();
-        if (now - lastBrightnessUpdate >= commandThrottleMs) {
-          lastBrightnessUpdate = now;
-          
-          // Extract brightness value from JSON
-          int brightStart = message.indexOf("\"value\":") + 8;
-          int brightEnd = message.indexOf("}", brightStart);
-          if (brightStart > 7 && brightEnd > brightStart) {
-            String brightStr = message.substring(brightStart, brightEnd);
-            int brightness = brightStr.toInt();
-            if (brightness >= 1 && brightness <= 255) {
-              currentBrightness = brightness;
-              pixels.setBrightness(currentBrightness);
-              
-              // Update current display immediately
-              if (currentPattern == 0) { // Rainbow
-                uint32_t color = pixels.gamma32(pixels.ColorHSV(rainbowHue));
-                for (int i = 0; i < NUM_PIXELS; i++) {
-                  pixels.setPixelColor(i, color);
-                }
-              } else if (currentPattern == 1) { // Static
-                for (int i = 0; i < NUM_PIXELS; i++) {
-                  pixels.setPixelColor(i, staticColor);
-                }
-              }
-              pixels.show();
-              
-              broadcastStatus();
-            }
-          }
-        }
-      }
-      else if (message.indexOf("\"command\":\"status\"") > -1) {
-        // Client requesting status update
-        broadcastStatus();
-      }
-      else if (message.indexOf("\"command\":\"autoCycle\"") > -1) {
-        autoCycleEnabled = !autoCycleEnabled;
-        savePreferences(); // Save the auto-cycle state
-        broadcastStatus();
-        Serial.printf("Auto-cycling enabled: %s\n", autoCycleEnabled ? "true" : "false");
+    case WStype_BIN:
+      // Compact opcode frames sent by the web UI
+      if (decodeBinaryCommand(payload, length, command)) {
+        handleCommand(num, command);
+      } else {
+        LOG_W("[%u] Invalid binary command (%u bytes)", num, (unsigned)length);
       }
-      else if (message.indexOf("\"command\":\"autoCycleInterval\"") > -1) {
-        int interval = message.indexOf("\"value\":") + 8;
-        int end = message.indexOf("}", interval);
-        if (interval > 7 && end > interval) {
-          String intervalStr = message.substring(interval, end);
-          autoCycleInterval = intervalStr.toInt();
-          savePreferences(); // Save the interval setting
-          Serial.printf("Auto-cycle interval set to: %d ms\n", autoCycleInterval);
-        }
-        broadcastStatus();
+      break;
+    
+    case WStype_TEXT:
+      // JSON fallback for older clients and scripts
+      LOG_D("[%u] get Text: %s", num, payload);
+      if (parseJsonCommand((const char*)payload, length, command)) {
+        handleCommand(num, command);
       }
       break;
-    }
     
     default:
       break;
   }
 }
 
+// Function to find the static assets on LittleFS, derive their ETags and
+// keep the hot ones in RAM
+void loadStaticAssets() {
+  size_t hotBytes = 0;
+  for (uint8_t i = 0; i < staticAssetCount; i++) {
+    StaticAsset& asset = staticAssets[i];
+    asset.gzip = LittleFS.exists(asset.path);
+    File file = LittleFS.open(asset.gzip ? asset.path : asset.fallbackPath, "r");
+    if (!file) {
+      LOG_W("Asset %s not found", asset.path);
+      continue;
+    }
+    asset.size = file.size();
+    asset.available = true;
+    
+    // Read it once: hash it, and keep it if it fits the hot budget
+    uint8_t* copy = nullptr;
+    if (asset.hot && hotBytes + asset.size <= ASSET_HOT_BUDGET) {
+      copy = (uint8_t*)malloc(asset.size);
+    }
+    if (copy != nullptr && file.read(copy, asset.size) == asset.size) {
+      makeAssetETag(copy, asset.size, asset.etag);
+      asset.data = copy;
+      hotBytes += asset.size;
+    } else {
+      free(copy);
+      file.seek(0);
+      uint8_t chunk[256];
+      uint32_t hash = ASSET_HASH_INIT;
+      size_t count;
+      while ((count = file.read(chunk, sizeof(chunk))) > 0) {
+        hash = assetHashUpdate(hash, chunk, count);
+      }
+      formatAssetETag(hash, asset.size, asset.etag);
+    }
+    file.close();
+    
+    LOG_I("Asset %s: %u bytes%s%s, ETag %s", asset.uri, (unsigned)asset.size,
+          asset.gzip ? " gzipped" : "", asset.data ? " in RAM" : "", asset.etag);
+  }
+}
+
+// Function to answer a static asset request
+void serveStaticAsset(AsyncWebServerRequest* request, StaticAsset& asset) {
+  asset.requests++;
+  if (!asset.available) {
+    request->send(404, "text/plain", "File not found");
+    return;
+  }
+  
+  // Browsers revalidate every time; unchanged assets cost a 304 only
+  AsyncWebServerResponse* response;
+  if (request->hasHeader("If-None-Match") &&
+      etagMatches(request->getHeader("If-None-Match")->value().c_str(), asset.etag)) {
+    asset.notModified++;
+    response = request->beginResponse(304);
+  } else {
+    if (asset.data != nullptr) {
+      response = request->beginResponse_P(200, asset.contentType, asset.data, asset.size);
+    } else {
+      // Sent from flash in chunks as the client acknowledges them
+      response = request->beginResponse(LittleFS, asset.gzip ? asset.path : asset.fallbackPath,
+                                        asset.contentType);
+      asset.flashReads++;
+    }
+    if (asset.gzip) {
+      response->addHeader("Content-Encoding", "gzip");
+    }
+    asset.bytesSent += asset.size;
+  }
+  response->addHeader("ETag", asset.etag);
+  response->addHeader("Cache-Control", "no-cache");
+  request->send(response);
+}
+
+// Function to register a GET route whose allocations are counted under
+// its path
+void onGet(const char* uri, ArRequestHandlerFunction handler) {
+  AllocSite* site = new AllocSite(uri);   // Lives as long as the route
+  server.on(uri, HTTP_GET, [site, handler](AsyncWebServerRequest* request) {
+    AllocScope scope(*site);
+    handler(request);
+  });
+}
+
 // Function to setup web server routes
+// Handlers run in the async TCP task: they only read state, and hand
+// setting changes to the loop task through forwardHttpCommand().
 void setupWebServer() {
   // Test endpoint
-  server.on("/test", []() {
-    Serial.println("Test endpoint hit!");
-    server.send(200, "text/plain", "Web server is working!");
+  onGet("/test", [](AsyncWebServerRequest* request) {
+    LOG_D("Test endpoint hit");
+    request->send(200, "text/plain", "Web server is working!");
   });
   
-  // Main page - serve from filesystem
-  server.on("/", []() {
-    File file = LittleFS.open("/index.html", "r");
-    if (file) {
-      server.streamFile(file, "text/html");
-      file.close();
-    } else {
-      server.send(404, "text/plain", "File not found");
+  // Main page and other static assets (gzipped, cached, ETag/304)
+  for (uint8_t i = 0; i < staticAssetCount; i++) {
+    StaticAsset* asset = &staticAssets[i];
+    onGet(asset->uri, [asset](AsyncWebServerRequest* request) {
+      serveStaticAsset(request, *asset);
+    });
+  }
+  
+  // Static asset counters
+  onGet("/assets", [](AsyncWebServerRequest* request) {
+    String json = "[";
+    for (uint8_t i = 0; i < staticAssetCount; i++) {
+      const StaticAsset& asset = staticAssets[i];
+      char entry[256];
+      snprintf(entry, sizeof(entry),
+               "%s{\"uri\":\"%s\",\"gzip\":%s,\"size\":%u,\"ram\":%s,\"requests\":%u,\"notModified\":%u,\"flashReads\":%u,\"bytesSent\":%u}",
+               i ? "," : "", asset.uri, asset.gzip ? "true" : "false", (unsigned)asset.size,
+               asset.data ? "true" : "false", asset.requests, asset.notModified,
+               asset.flashReads, asset.bytesSent);
+      json += entry;
     }
+    json += "]";
+    request->send(200, "application/json", json);
   });
   
-  // Set rainbow mode
-  server.on("/rainbow", []() {
-    currentPattern = 0; // Rainbow
-    server.send(200, "text/plain", "Rainbow mode activated");
+  // Pattern routes (/rainbow, /static, /wave, ...)
+  for (uint8_t i = 0; i < patternEngine.patternCount(); i++) {
+    Pattern& pattern = patternEngine.pattern(i);
+    onGet((String("/") + pattern.key).c_str(), [i](AsyncWebServerRequest* request) {
+      if (!forwardHttpCommand(WS_OP_SELECT_PATTERN, i)) {
+        request->send(503, "text/plain", "Busy, try again");
+        return;
+      }
+      request->send(200, "text/plain", String(getPatternName(i)) + " mode activated");
+    });
+  }
+  
+  // Next pattern
+  onGet("/next", [](AsyncWebServerRequest* request) {
+    if (!forwardHttpCommand(WS_OP_NEXT)) {
+      request->send(503, "text/plain", "Busy, try again");
+      return;
+    }
+    request->send(200, "text/plain", "Next pattern activated");
   });
   
-  // Set static mode
-  server.on("/static", []() {
-    currentPattern = 1; // Static
-    server.send(200, "text/plain", "Static mode activated");
+  // Set static color
+  onGet("/color", [](AsyncWebServerRequest* request) {
+    if (request->hasParam("value")) {
+      String colorStr = request->getParam("value")->value();
+      // Convert hex string to RGB values
+      long hexColor = strtol(colorStr.c_str(), NULL, 16);
+  
+      // Set all pixels to the static color on the next frame; both
+      // commands are queued or neither
+      if (httpCommands.space() < 2) {
+        httpCommandsDropped += 2;
+        request->send(503, "text/plain", "Busy, try again");
+        return;
+      }
+      forwardHttpCommand(WS_OP_COLOR, hexColor & 0xFFFFFF);
+      forwardHttpCommand(WS_OP_SELECT_PATTERN, PATTERN_STATIC);
+  
+      request->send(200, "text/plain", "Color set to #" + colorStr);
+    } else {
+      request->send(400, "text/plain", "Missing color value");
+    }
   });
   
-  // Set wave mode
-  server.on("/wave", []() {
-    currentPattern = 2; // Wave
-    server.send(200, "text/plain", "Wave mode activated");
+  // Set brightness
+  onGet("/brightness", [](AsyncWebServerRequest* request) {
+    if (request->hasParam("value")) {
+      int brightness = request->getParam("value")->value().toInt();
+      if (brightness >= 1 && brightness <= 255) {
+        // Redrawn at the new brightness on the next frame
+        if (!forwardHttpCommand(WS_OP_BRIGHTNESS, brightness)) {
+          request->send(503, "text/plain", "Busy, try again");
+          return;
+        }
+  
+        request->send(200, "text/plain", "Brightness set to " + String(brightness));
+      } else {
+        request->send(400, "text/plain", "Invalid brightness value. Use 1-255.");
+      }
+    } else {
+      request->send(400, "text/plain", "Missing brightness value");
+    }
   });
   
-  // Set fire mode
-  server.on("/fire", []() {
-    currentPattern = 3; // Fire
-    server.send(200, "text/plain", "Fire mode activated");
+  // Crossfade time between patterns
+  onGet("/transition", [](AsyncWebServerRequest* request) {
+    if (request->hasParam("ms")) {
+      long millis = request->getParam("ms")->value().toInt();
+      if (millis < 0 || millis > TRANSITION_MAX_MILLIS) {
+        request->send(400, "text/plain", "Invalid transition time. Use 0-" + String(TRANSITION_MAX_MILLIS) + " ms.");
+        return;
+      }
+      if (!forwardHttpCommand(WS_OP_TRANSITION, millis)) {
+        request->send(503, "text/plain", "Busy, try again");
+        return;
+      }
+      request->send(200, "text/plain", "Transition set to " + String(millis) + " ms");
+      return;
+    }
+    request->send(200, "text/plain", String(patternEngine.transition()) + " ms");
   });
   
-  // Set matrix mode
-  server.on("/matrix", []() {
-    currentPattern = 4; // Matrix
-    server.send(200, "text/plain", "Matrix mode activated");
+  // Status endpoint, including frame counters
+  onGet("/status", [](AsyncWebServerRequest* request) {
+    char json[STATUS_JSON_SIZE];
+    writeStatusJson(json, sizeof(json), currentStatus(), STATUS_SETTINGS | STATUS_FRAMES,
+                    statusBroadcaster.version);
+    request->send(200, "application/json", json);
   });
   
-  // Set spiral mode
-  server.on("/spiral", []() {
-    currentPattern = 5; // Spiral
-    server.send(200, "text/plain", "Spiral mode activated");
+  // Pattern list with frame interval and measured render cost
+  onGet("/patterns", [](AsyncWebServerRequest* request) {
+    String json = "[";
+    for (uint8_t i = 0; i < patternEngine.patternCount(); i++) {
+      Pattern& pattern = patternEngine.pattern(i);
+      char entry[160];
+      snprintf(entry, sizeof(entry),
+               "%s{\"pattern\":%u,\"name\":\"%s\",\"intervalMs\":%u,\"frames\":%u,\"avgRenderUs\":%u,\"maxRenderUs\":%u}",
+               i ? "," : "", i, pattern.name, pattern.frameInterval, pattern.frameCount,
+               pattern.averageRenderMicros, pattern.maxRenderMicros);
+      json += entry;
+    }
+    json += "]";
+    request->send(200, "application/json", json);
   });
   
-  // Set pulse mode
-  server.on("/pulse", []() {
-    currentPattern = 6; // Pulse
-    server.send(200, "text/plain", "Pulse mode activated");
+  // Frame timing histograms and counters (Prometheus text format)
+  onGet("/metrics", [](AsyncWebServerRequest* request) {
+    static char buffer[METRICS_HISTOGRAM_TEXT];   // Only used by the async TCP task
+    String text;
+    text.reserve((PATTERN_COUNT + 3) * METRICS_HISTOGRAM_TEXT / 2);
+    
+    text += "# HELP led_render_seconds Time to render one frame\n# TYPE led_render_seconds histogram\n";
+    for (uint8_t i = 0; i < patternEngine.patternCount(); i++) {
+      Pattern& pattern = patternEngine.pattern(i);
+      char labels[48];
+      snprintf(labels, sizeof(labels), "pattern=\"%s\"", pattern.key);
+      if (formatHistogram(buffer, sizeof(buffer), "led_render_seconds", labels, pattern.renderTime)) {
+        text += buffer;
+      }
+    }
+    text += "# HELP led_show_seconds Time to send a frame to the LEDs\n# TYPE led_show_seconds histogram\n";
+    if (formatHistogram(buffer, sizeof(buffer), "led_show_seconds", "", frameMetrics.show)) {
+      text += buffer;
+    }
+    text += "# HELP led_frame_lateness_seconds Frame start after its due time\n# TYPE led_frame_lateness_seconds histogram\n";
+    if (formatHistogram(buffer, sizeof(buffer), "led_frame_lateness_seconds", "", frameMetrics.lateness)) {
+      text += buffer;
+    }
+    text += "# HELP led_loop_period_seconds Time between main loop iterations\n# TYPE led_loop_period_seconds histogram\n";
+    if (formatHistogram(buffer, sizeof(buffer), "led_loop_period_seconds", "", frameMetrics.loopPeriod)) {
+      text += buffer;
+    }
+    
+    snprintf(buffer, sizeof(buffer),
+             "# HELP led_frame_deadlines_missed_total Frames started a whole frame interval late\n"
+             "# TYPE led_frame_deadlines_missed_total counter\nled_frame_deadlines_missed_total %u\n"
+             "# HELP led_frames_per_second Frames rendered per second over the last second\n"
+             "# TYPE led_frames_per_second gauge\nled_frames_per_second %u.%03u\n"
+             "# TYPE led_frames_rendered_total counter\nled_frames_rendered_total %u\n"
+             "# TYPE led_frames_pushed_total counter\nled_frames_pushed_total %u\n"
+             "# TYPE led_free_heap_bytes gauge\nled_free_heap_bytes %u\n"
+             "# HELP led_loop_wakeups_total Main loop wakeups\n"
+             "# TYPE led_loop_wakeups_total counter\nled_loop_wakeups_total %u\n"
+             "# HELP led_loop_wakeups_notified_total Wakeups before the deadline, by a command or the button\n"
+             "# TYPE led_loop_wakeups_notified_total counter\nled_loop_wakeups_notified_total %u\n"
+             "# TYPE led_power_save gauge\nled_power_save %u\n",
+             frameMetrics.deadlinesMissed, frameMetrics.framesPerSecondMilli / 1000,
+             frameMetrics.framesPerSecondMilli % 1000, frameOutput.framesRendered,
+             frameOutput.framesPushed, ESP.getFreeHeap(), loopScheduler.wakeups,
+             loopScheduler.notifiedWakeups, powerSave ? 1 : 0);
+    text += buffer;
+    snprintf(buffer, sizeof(buffer),
+             "# HELP led_render_commands_posted_total Commands queued for the render task\n"
+             "# TYPE led_render_commands_posted_total counter\nled_render_commands_posted_total %u\n"
+             "# HELP led_render_commands_applied_total Commands the render task has applied\n"
+             "# TYPE led_render_commands_applied_total counter\nled_render_commands_applied_total %u\n"
+             "# HELP led_render_commands_dropped_total Commands dropped because the render queue was full\n"
+             "# TYPE led_render_commands_dropped_total counter\nled_render_commands_dropped_total %u\n"
+             "# HELP led_http_commands_dropped_total HTTP commands refused with 503 because the loop queue was full\n"
+             "# TYPE led_http_commands_dropped_total counter\nled_http_commands_dropped_total %u\n",
+             renderCommandsPosted, renderCommandsApplied.load(std::memory_order_relaxed),
+             renderCommandsDropped, httpCommandsDropped);
+    text += buffer;
+    request->send(200, "text/plain; version=0.0.4", text);
   });
   
-  // Next pattern
-  server.on("/next", []() {
-    currentPattern = (currentPattern + 1) % 7; // Cycle to next pattern
-    server.send(200, "text/plain", "Next pattern activated");
+  // Write-behind preference counters
+  onGet("/preferences", [](AsyncWebServerRequest* request) {
+    char json[160];
+    snprintf(json, sizeof(json),
+             "{\"dirty\":%s,\"requests\":%u,\"commits\":%u,\"commitsAvoided\":%u,\"fieldsWritten\":%u,\"bytesWritten\":%u}",
+             preferenceCache.dirty() ? "true" : "false", preferenceCache.requests, preferenceCache.commits,
+             preferenceCache.commitsAvoided(), preferenceCache.fieldsWritten, preferenceCache.bytesWritten);
+    request->send(200, "application/json", json);
   });
   
-  // Set static color
-  server.on("/color", []() {
-    if (server.hasArg("value")) {
-      String colorStr = server.arg("value");
-      // Convert hex string to RGB values
-      long hexColor = strtol(colorStr.c_str(), NULL, 16);
-      uint8_t r = (hexColor >> 16) & 0xFF;
-      uint8_t g = (hexColor >> 8) & 0xFF;
-      uint8_t b = hexColor & 0xFF;
-      
-      staticColor = pixels.Color(r, g, b);
-      currentPattern = 1; // Static
-      
-      // Set all pixels to the static color immediately
-      for (int i = 0; i < NUM_PIXELS; i++) {
-        pixels.setPixelColor(i, staticColor);
+  // Preview subscribers: requested FPS, backoff and frames sent/skipped
+  onGet("/preview", [](AsyncWebServerRequest* request) {
+    String json = "[";
+    for (uint8_t i = 0; i < PREVIEW_MAX_CLIENTS; i++) {
+      const PreviewClient& client = previewStream.client(i);
+      if (client.fps == 0) {
+        continue;
       }
-      pixels.show();
-      
-      server.send(200, "text/plain", "Color set to #" + colorStr);
-    } else {
-      server.send(400, "text/plain", "Missing color value");
+      char entry[128];
+      snprintf(entry, sizeof(entry),
+               "%s{\"client\":%u,\"fps\":%u,\"backoff\":%u,\"sent\":%u,\"skipped\":%u}",
+               json.length() > 1 ? "," : "", i, client.fps, client.backoff,
+               client.framesSent, client.framesSkipped);
+      json += entry;
     }
+    json += "]";
+    request->send(200, "application/json", json);
   });
   
-  // Set brightness
-  server.on("/brightness", []() {
-    if (server.hasArg("value")) {
-      int brightness = server.arg("value").toInt();
-      if (brightness >= 1 && brightness <= 255) {
-        currentBrightness = brightness;
-        pixels.setBrightness(currentBrightness);
-        
-        // Update current display immediately
-        if (currentPattern == 0) { // Rainbow
-          // Apply current rainbow color with new brightness
-          uint32_t color = pixels.gamma32(pixels.ColorHSV(rainbowHue));
-          for (int i = 0; i < NUM_PIXELS; i++) {
-            pixels.setPixelColor(i, color);
-          }
-        } else if (currentPattern == 1) { // Static
-          // Apply static color with new brightness
-          for (int i = 0; i < NUM_PIXELS; i++) {
-            pixels.setPixelColor(i, staticColor);
-          }
-        }
-        pixels.show();
-        
-        server.send(200, "text/plain", "Brightness set to " + String(brightness));
-      } else {
-        server.send(400, "text/plain", "Invalid brightness value. Use 1-255.");
+  // External pattern: DDP frames received, shown and dropped
+  onGet("/ddp", [](AsyncWebServerRequest* request) {
+    const DdpStats& stats = ddpReceiver.stats;
+    char json[256];
+    snprintf(json, sizeof(json),
+             "{\"port\":%u,\"open\":%s,\"packets\":%u,\"frames\":%u,\"played\":%u,\"late\":%u,\"duplicates\":%u,\"overflows\":%u,\"lost\":%u,\"incomplete\":%u,\"invalid\":%u}",
+             DDP_PORT, ddpReceiver.isOpen() ? "true" : "false", stats.packets, stats.frames,
+             stats.played, stats.late, stats.duplicates, stats.overflows, stats.lost, stats.incomplete,
+             stats.invalid);
+    request->send(200, "application/json", json);
+  });
+  
+  // Heap: free, largest block and fragmentation over time, and the
+  // allocations made by each command, route and broadcast
+  onGet("/heap", [](AsyncWebServerRequest* request) {
+    char entry[160];
+    snprintf(entry, sizeof(entry),
+             "{\"free\":%u,\"largestBlock\":%u,\"minFree\":%u,\"minLargestBlock\":%u,\"maxFragmentation\":%u,\"samples\":[",
+             ESP.getFreeHeap(), ESP.getMaxAllocHeap(), heapHistory.minFreeBytes,
+             heapHistory.minLargestBlock, heapHistory.maxFragmentation);
+    String json = entry;
+    for (uint8_t i = 0; i < heapHistory.size(); i++) {
+      const HeapSample& sample = heapHistory.at(i);
+      snprintf(entry, sizeof(entry), "%s{\"ms\":%u,\"free\":%u,\"largestBlock\":%u,\"fragmentation\":%u}",
+               i ? "," : "", sample.millis, sample.freeBytes, sample.largestBlock, sample.fragmentation());
+      json += entry;
+    }
+    json += "],\"sites\":[";
+    for (AllocSite* site = firstAllocSite(); site != nullptr; site = site->nextSite) {
+      snprintf(entry, sizeof(entry),
+               "{\"name\":\"%s\",\"entries\":%u,\"allocations\":%u,\"bytes\":%u,\"frees\":%u}%s",
+               site->name, site->entries, site->allocations, site->bytes, site->frees,
+               site->nextSite ? "," : "");
+      json += entry;
+    }
+    json += "]}";
+    request->send(200, "application/json", json);
+  });
+  
+  // Recent log lines (text) - /logs?since=N returns lines from N on;
+  // X-Log-Next is the N to ask for next time
+  onGet("/logs", [](AsyncWebServerRequest* request) {
+    LogCursor cursor = logBuffer.oldest();
+    if (request->hasParam("since")) {
+      uint32_t since = strtoul(request->getParam("since")->value().c_str(), NULL, 10);
+      if ((int32_t)(since - cursor.next) > 0) {
+        cursor.next = since;
       }
-    } else {
-      server.send(400, "text/plain", "Missing brightness value");
     }
+    String text;
+    text.reserve(LOG_SLOTS * LOG_LINE_SIZE / 2);
+    LogEntry entry;
+    char line[LOG_LINE_SIZE];
+    while (logBuffer.read(cursor, entry)) {
+      formatLogLine(entry, line, sizeof(line));
+      text += line;
+    }
+    AsyncWebServerResponse* response = request->beginResponse(200, "text/plain", text);
+    response->addHeader("X-Log-Next", String(cursor.next));
+    response->addHeader("Cache-Control", "no-cache");
+    request->send(response);
   });
   
-  // Status endpoint
-  server.on("/status", []() {
-    String mode = getPatternName(currentPattern);
-    String colorHex = "";
-    if (currentPattern == 1) { // Static mode
-      uint8_t r = (staticColor >> 16) & 0xFF;
-      uint8_t g = (staticColor >> 8) & 0xFF;
-      uint8_t b = staticColor & 0xFF;
-      colorHex = "#" + String(r, HEX) + String(g, HEX) + String(b, HEX);
-      colorHex.toUpperCase();
+  // Pixel layout (wiring order) - /layout?type=row_serpentine
+  onGet("/layout", [](AsyncWebServerRequest* request) {
+    if (request->hasParam("type")) {
+      PixelLayoutType type;
+      if (!getLayoutType(request->getParam("type")->value().c_str(), &type)) {
+        request->send(400, "text/plain", "Unknown layout. Use column_serpentine, row_serpentine, row_major or custom.");
+        return;
+      }
+      // The loop task parses the custom map; only check it is there
+      if (type == LAYOUT_CUSTOM && !LittleFS.exists(LAYOUT_FILE)) {
+        request->send(500, "text/plain", "Could not load " LAYOUT_FILE);
+        return;
+      }
+      if (!forwardHttpCommand(WS_OP_LAYOUT, type)) {
+        request->send(503, "text/plain", "Busy, try again");
+        return;
+      }
+      request->send(200, "text/plain", getLayoutName(type));
+      return;
     }
-    String json = "{\"mode\":\"" + mode + "\",\"pattern\":" + String(currentPattern) + ",\"color\":\"" + colorHex + "\",\"brightness\":" + String(currentBrightness) + "}";
-    server.send(200, "application/json", json);
+    request->send(200, "text/plain", getLayoutName(pixelLayout().type));
   });
 }
 
+// Animation file on LittleFS, read by the render task as it plays
+class FileAnimationSource : public AnimationSource {
+public:
+  bool seek(uint32_t position) override {
+    if (!file) {
+      file = LittleFS.open(ANIMATION_FILE, "r");
+    }
+    return file && file.seek(position);
+  }
+  
+  size_t read(uint8_t* buffer, size_t size) override {
+    return file ? file.read(buffer, size) : 0;
+  }
+  
+private:
+  File file;
+};
+
+FileAnimationSource animationFile;
+
+// Function to read a custom pixel map from LittleFS
+bool loadCustomPixelLayout() {
+  static char layoutText[2048];
+  File file = LittleFS.open(LAYOUT_FILE, "r");
+  if (!file) {
+    LOG_W("Custom layout file " LAYOUT_FILE " not found");
+    return false;
+  }
+  size_t length = file.size();
+  bool loaded = length <= sizeof(layoutText) &&
+                file.readBytes(layoutText, length) == length &&
+                parsePixelLayout(layoutText, length);
+  file.close();
+  
+  if (!loaded) {
+    LOG_W("Custom layout file " LAYOUT_FILE " is invalid");
+  }
+  return loaded;
+}
+
+// Function to check a pixel layout (wiring order) can be selected,
+// reading the custom map from LittleFS if needed
+bool preparePixelLayout(uint8_t type) {
+  if (type == LAYOUT_CUSTOM) {
+    return loadCustomPixelLayout();
+  }
+  return type < LAYOUT_CUSTOM;
+}
+
 // Function to load saved preferences
 void loadPreferences() {
   preferences.begin("lithophane", false); // false = read/write mode
+  preferenceCache.load();
   
   // Always start on Wave pattern - don't save/load it
-  currentPattern = 2; // Wave
+  patternEngine.select(PATTERN_WAVE);
   
-  currentBrightness = preferences.getUChar("brightness", 64);
-  autoCycleEnabled = preferences.getBool("autoCycle", false);
-  autoCycleInterval = preferences.getULong("autoCycleInt", 6000); // Default to 6 seconds
+  currentBrightness = preferenceCache.get(PREF_BRIGHTNESS);
+  // (the render task is not running yet, so the output is set directly)
+  frameOutput.setBrightness(currentBrightness);
+  autoCycleEnabled = preferenceCache.get(PREF_AUTO_CYCLE);
+  autoCycleInterval = clampAutoCycleInterval(preferenceCache.get(PREF_AUTO_CYCLE_INTERVAL));
   
   // Load static color
-  uint32_t savedColor = preferences.getULong("staticColor", 0xFF0000);
+  uint32_t savedColor = preferenceCache.get(PREF_STATIC_COLOR);
   if (savedColor != 0) {
     staticColor = savedColor;
   }
   
-  Serial.println("Preferences loaded from flash:");
-  Serial.printf("  Pattern: %d (%s) - Always Wave on startup\n", currentPattern, getPatternName(currentPattern).c_str());
-  Serial.printf("  Brightness: %d\n", currentBrightness);
-  Serial.printf("  Auto-cycle: %s\n", autoCycleEnabled ? "enabled" : "disabled");
-  Serial.printf("  Auto-cycle interval: %d ms\n", autoCycleInterval);
-  Serial.printf("  Static color: 0x%06X\n", staticColor);
+  // Load the crossfade time (the render task is not running yet)
+  patternEngine.setTransition(preferenceCache.get(PREF_TRANSITION));
+  
+  // Load pixel layout, falling back to the default wiring
+  uint8_t layout = preferenceCache.get(PREF_LAYOUT);
+  // (the render task is not running yet, so the layout is set directly)
+  if (!preparePixelLayout(layout) || !selectPixelLayout((PixelLayoutType)layout)) {
+    selectPixelLayout(LAYOUT_COLUMN_SERPENTINE);
+  }
+  
+  LOG_I("Preferences: pattern %s, brightness %d, auto-cycle %s every %d ms",
+        getPatternName(patternEngine.currentIndex()), currentBrightness,
+        autoCycleEnabled ? "on" : "off", autoCycleInterval);
+  LOG_I("Preferences: static color 0x%06X, layout %s, transition %u ms", staticColor,
+        getLayoutName(pixelLayout().type), patternEngine.transition());
 }
 
-// Function to save preferences
-void savePreferences() {
-  // Don't save pattern - always start on Wave
-  preferences.putUChar("brightness", currentBrightness);
-  preferences.putBool("autoCycle", autoCycleEnabled);
-  preferences.putULong("autoCycleInt", autoCycleInterval);
-  preferences.putULong("staticColor", staticColor);
-  
-  Serial.println("Preferences saved to flash:");
-  Serial.printf("  Pattern: %d (%s) - Not saved (always Wave on startup)\n", currentPattern, getPatternName(currentPattern).c_str());
-  Serial.printf("  Brightness: %d\n", currentBrightness);
-  Serial.printf("  Auto-cycle: %s\n", autoCycleEnabled ? "enabled" : "disabled");
-  Serial.printf("  Auto-cycle interval: %d ms\n", autoCycleInterval);
-  Serial.printf("  Static color: 0x%06X\n", staticColor);
+// Function to write pending preferences before a restart
+void flushPreferences() {
+  preferenceCache.flush();
 }
 
 void setup() {
   // Initialize serial communication
   Serial.begin(115200);
   
-  Serial.println("Seeed XIAO ESP32C3 Starting...");
+  LOG_I("Seeed XIAO ESP32C3 Starting...");
   
-  // Initialize random seed for matrix effect
-  randomSeed(analogRead(A0_PIN));
+  // Seed the patterns' random streams from the hardware RNG; the seed
+  // is logged so a sequence can be replayed on the native build
+  uint32_t patternSeed = esp_random();
+  seedPatterns(patternSeed);
+  LOG_I("Pattern seed: %u", (unsigned)patternSeed);
   
   // Initialize NeoPixels
   pixels.begin();
-  pixels.setBrightness(currentBrightness);
+  frameOutput.setBrightness(currentBrightness);
   pixels.clear();
   pixels.show();
-  Serial.println("NeoPixels initialized!");
+  LOG_I("NeoPixels initialized");
   
   // Initialize filesystem
   if (!LittleFS.begin()) {
-    Serial.println("LittleFS mount failed!");
+    LOG_E("LittleFS mount failed");
   } else {
-    Serial.println("LittleFS mounted successfully!");
+    LOG_I("LittleFS mounted");
+    loadStaticAssets();
+    
+    // Offer the Animation pattern if an animation was uploaded
+    if (LittleFS.exists(ANIMATION_FILE)) {
+      animationSource = &animationFile;
+      LOG_I("Animation " ANIMATION_FILE " found");
+    }
   }
   
-  // Load preferences
+  // Load preferences, and save pending changes if the chip restarts
   loadPreferences();
+  esp_register_shutdown_handler(flushPreferences);
+  
+  // Render patterns in their own task from here on
+  startRenderTask();
+  LOG_I("Render task started");
+  
+  // Button edges wake the loop, which sleeps between deadlines
+  loopTaskHandle = xTaskGetCurrentTaskHandle();
+  pinMode(BUTTON_PIN, INPUT_PULLUP);
+  attachInterrupt(BUTTON_PIN, buttonChanged, CHANGE);
   
   // Initialize WiFi
-  Serial.println("Setting up Access Point...");
+  LOG_I("Setting up Access Point...");
   WiFi.mode(WIFI_AP);
   WiFi.hostname(hostname);
   WiFi.softAP(ap_ssid, ap_password);
-  Serial.printf("Access Point \"%s\" created with IP: %s\n", ap_ssid, WiFi.softAPIP().toString().c_str());
-  Serial.printf("You can also access it at: %s.local\n", hostname);
+  LOG_I("Access Point \"%s\" created with IP: %s", ap_ssid, WiFi.softAPIP().toString().c_str());
+  LOG_I("You can also access it at: %s.local", hostname);
+  setupPowerSave();
   
   // Setup web server routes
   setupWebServer();
   server.begin();
-  Serial.println("Web server started!");
+  LOG_I("Web server started");
   
   // Setup and start WebSocket server
   webSocket.begin();
   webSocket.onEvent(webSocketEvent);
-  Serial.println("WebSocket server started on port 81!");
+  LOG_I("WebSocket server started on port 81");
   
-  Serial.printf("Access your device at: %s\n", WiFi.softAPIP().toString().c_str());
+  LOG_I("Access your device at: %s", WiFi.softAPIP().toString().c_str());
   
   // Print chip information
-  Serial.printf("Chip Model: %s\n", ESP.getChipModel());
-  Serial.printf("Chip Revision: %d\n", ESP.getChipRevision());
-  Serial.printf("Flash Size: %d bytes\n", ESP.getFlashChipSize());
-  Serial.printf("Free Heap: %d bytes\n", ESP.getFreeHeap());
-  Serial.printf("CPU Frequency: %d MHz\n", ESP.getCpuFreqMHz());
+  LOG_I("Chip %s rev %d, %d MHz, flash %d bytes, free heap %d bytes", ESP.getChipModel(),
+        ESP.getChipRevision(), ESP.getCpuFreqMHz(), ESP.getFlashChipSize(), ESP.getFreeHeap());
   
-  Serial.println("Setup complete!");
-}
-
-// Function to create rainbow effect - all pixels same color
-void rainbowCycle() {
-  if (currentPattern == 0) { // Rainbow
-    // Convert current hue to RGB color
-    uint32_t color = pixels.gamma32(pixels.ColorHSV(rainbowHue));
-    
-    // Set all pixels to the same color
-    for (int i = 0; i < NUM_PIXELS; i++) {
-      pixels.setPixelColor(i, color);
-    }
-    pixels.show();
-    
-    // Increment hue for next cycle
-    rainbowHue += 256;
-    if (rainbowHue >= 65536) {
-      rainbowHue = 0;
-    }
-  }
-}
-
-// Function to set static color
-void setStaticColor() {
-  if (currentPattern == 1) { // Static
-    for (int i = 0; i < NUM_PIXELS; i++) {
-      pixels.setPixelColor(i, staticColor);
-    }
-    pixels.show();
-  }
-}
-
-// Function to get pixel index from grid coordinates (serpentine pattern)
-uint16_t getPixelIndex(uint8_t col, uint8_t row) {
-  if (col >= GRID_WIDTH || row >= GRID_HEIGHT) return 0;
-  
-  // Serpentine pattern: down then up, left to right
-  if (col % 2 == 0) {
-    // Even columns: top to bottom
-    return col * GRID_HEIGHT + row;
-  } else {
-    // Odd columns: bottom to top
-    return col * GRID_HEIGHT + (GRID_HEIGHT - 1 - row);
-  }
-}
-
-// Function to create wave effect
-void waveEffect() {
-  if (currentPattern == 2) { // Wave
-    // Debug output every 50 frames
-    if (patternStep % 50 == 0) {
-      Serial.printf("Wave Debug - waveOffset: %d, patternStep: %d\n", waveOffset, patternStep);
-    }
-    
-    for (int col = 0; col < GRID_WIDTH; col++) {
-      for (int row = 0; row < GRID_HEIGHT; row++) {
-        uint16_t pixelIndex = getPixelIndex(col, row);
-        
-        // Create rainbow effect that travels right to left
-        // Calculate hue based on column position and time
-        uint16_t hue = ((waveOffset * 300) - (col * 10922)) % 65536; // Faster movement, reverse direction
-        
-        // Debug first few pixels every 50 frames
-        if (patternStep % 50 == 0 && col < 3 && row == 0) {
-          Serial.printf("Col %d: hue=%d, waveOffset=%d\n", col, hue, waveOffset);
-        }
-        
-        // Add some wave variation based on row for more dynamic effect
-        float wave = sin((row * 0.5 + waveOffset * 0.1) * PI / 180.0);
-        uint8_t saturation = 255; // Full saturation for vibrant colors
-        uint8_t value = 200 + (wave * 55); // Vary brightness slightly with wave
-        
-        uint32_t color = pixels.gamma32(pixels.ColorHSV(hue, saturation, value));
-        pixels.setPixelColor(pixelIndex, color);
-      }
-    }
-    pixels.show();
-    
-    waveOffset++;
-    patternStep++;
-  }
-}
-
-// Function to create fire effect
-void fireEffect() {
-  if (currentPattern == 3) { // Fire
-    // Create fire effect with orange/yellow base and red tips
-    for (int i = 0; i < NUM_PIXELS; i++) {
-      // Get grid coordinates from pixel index using correct serpentine layout
-      uint8_t col = i / GRID_HEIGHT;
-      uint8_t row;
-      
-      if (col % 2 == 0) {
-        // Even columns: top to bottom
-        row = i % GRID_HEIGHT;
-      } else {
-        // Odd columns: bottom to top
-        row = GRID_HEIGHT - 1 - (i % GRID_HEIGHT);
-      }
-      
-      // Calculate distance from bottom (fire source)
-      // Top row is row 0, bottom row is row 9
-      uint8_t distanceFromBottom = GRID_HEIGHT - 1 - row;
-      
-      // Base fire intensity decreases with height (stronger at bottom)
-      uint8_t baseIntensity = max(0, 255 - (distanceFromBottom * 40));
-      
-      // Add some variation based on column position
-      uint8_t columnVariation = (col * 17 + patternStep * 3) % 50;
-      baseIntensity = max(0, min(255, baseIntensity + columnVariation - 25));
-      
-      // Create fire colors: red at bottom, orange in middle, yellow at top
-      uint16_t hue;
-      if (distanceFromBottom < 3) {
-        // Bottom: red-orange
-        hue = 0; // Red
-      } else if (distanceFromBottom < 6) {
-        // Middle: orange
-        hue = 3000; // Orange
-      } else {
-        // Top: yellow
-        hue = 6000; // Yellow
-      }
-      
-      // Add sparkle effect with orange/yellow
-      uint8_t sparkleChance = (i * 13 + patternStep * 7) % 100;
-      if (sparkleChance < 15) { // 15% chance for sparkles
-        // Random sparkle color: orange, yellow, or bright orange
-        uint16_t sparkleHues[] = {3000, 6000, 2500}; // Orange, Yellow, Bright Orange
-        hue = sparkleHues[(i + patternStep) % 3];
-        baseIntensity = min(255, baseIntensity + 50); // Make sparkles brighter
-      }
-      
-      // Add random white flashes near the top
-      if (distanceFromBottom <= 2 && (i * 19 + patternStep * 11) % 200 < 3) { // 1.5% chance for white flashes
-        hue = 0; // White (hue 0 with high saturation)
-        baseIntensity = 255; // Full brightness for flashes
-      }
-      
-      // Calculate saturation and value
-      uint8_t saturation = max(200, 255 - (distanceFromBottom * 10)); // Higher saturation at bottom
-      uint8_t value = baseIntensity;
-      
-      // Create the color
-      uint32_t color = pixels.gamma32(pixels.ColorHSV(hue, saturation, value));
-      pixels.setPixelColor(i, color);
-    }
-    
-    pixels.show();
-    patternStep++;
-  }
-}
-
-// Function to create matrix effect
-void matrixEffect() {
-  if (currentPattern == 4) { // Matrix
-    // Create falling green "code" effect
-    for (int col = 0; col < GRID_WIDTH; col++) {
-      // Random chance to start a new "drop" at the top
-      if (random(100) < 15) {
-        uint16_t pixelIndex = getPixelIndex(col, 0); // Top of column
-        pixels.setPixelColor(pixelIndex, pixels.Color(0, 255, 0)); // Bright green
-      }
-      
-      // Move existing drops down each column
-      for (int row = GRID_HEIGHT - 1; row > 0; row--) {
-        uint16_t currentPixel = getPixelIndex(col, row);
-        uint16_t abovePixel = getPixelIndex(col, row - 1);
-        
-        uint32_t aboveColor = pixels.getPixelColor(abovePixel);
-        if (aboveColor != 0) {
-          // Move the color down one row
-          pixels.setPixelColor(currentPixel, aboveColor);
-          pixels.setPixelColor(abovePixel, 0); // Clear the above pixel
-        }
-      }
-      
-      // Fade out pixels at the bottom
-      uint16_t bottomPixel = getPixelIndex(col, GRID_HEIGHT - 1);
-      uint32_t bottomColor = pixels.getPixelColor(bottomPixel);
-      if (bottomColor != 0) {
-        // Extract green component and fade it
-        uint8_t g = (bottomColor >> 8) & 0xFF;
-        if (g > 20) {
-          g -= 20; // Fade out
-          pixels.setPixelColor(bottomPixel, pixels.Color(0, g, 0));
-        } else {
-          pixels.setPixelColor(bottomPixel, 0); // Turn off when too dim
-        }
-      }
-    }
-    pixels.show();
-  }
-}
-
-// Function to create spiral effect
-void spiralEffect() {
-  if (currentPattern == 5) { // Spiral
-    // Create a proper spiral using polar coordinates with serpentine grid indexing
-    uint8_t centerCol = GRID_WIDTH / 2;
-    uint8_t centerRow = GRID_HEIGHT / 2;
-    
-    // Calculate total pixels in the spiral and current pixel to light
-    uint8_t totalPixels = NUM_PIXELS; // Use actual number of pixels in grid
-    
-    // Create expanding/contracting effect
-    uint8_t currentPixel = patternStep % (totalPixels * 2); // *2 for expand + contract cycle
-    
-    // Determine if we're expanding or contracting
-    bool isExpanding = currentPixel < totalPixels;
-    
-    // For expanding: light pixels 0, 1, 2, 3, ...
-    // For contracting: light pixels totalPixels-1, totalPixels-2, totalPixels-3, ..., 0
-    uint8_t pixelsToLight;
-    if (isExpanding) {
-      pixelsToLight = currentPixel;
-    } else {
-      // Contracting phase - reverse the order
-      pixelsToLight = totalPixels - 1 - (currentPixel - totalPixels);
-    }
-    
-    // Debug output every 50 frames
-    if (patternStep % 50 == 0) {
-      Serial.printf("Spiral: step=%d, currentPixel=%d, isExpanding=%s, pixelsToLight=%d, totalPixels=%d\n", 
-                    patternStep, currentPixel, isExpanding ? "true" : "false", pixelsToLight, totalPixels);
-    }
-    
-    // Create a stable spiral sequence (only calculate once)
-    static uint16_t spiralSequence[NUM_PIXELS];
-    static bool sequenceInitialized = false;
-    
-    if (!sequenceInitialized) {
-      // Generate the spiral sequence once, properly ordered from center outward
-      uint8_t sequenceIndex = 0;
-      
-      // Start from center and spiral outward
-      for (int layer = 0; layer <= max(GRID_WIDTH, GRID_HEIGHT) && sequenceIndex < NUM_PIXELS; layer++) {
-        // Top row of current layer
-        for (int col = centerCol - layer; col <= centerCol + layer && sequenceIndex < NUM_PIXELS; col++) {
-          if (col >= 0 && col < GRID_WIDTH) {
-            uint8_t row = centerRow - layer;
-            if (row >= 0 && row < GRID_HEIGHT) {
-              uint16_t pixelIndex = getPixelIndex(col, row);
-              if (pixelIndex < NUM_PIXELS) {
-                spiralSequence[sequenceIndex++] = pixelIndex;
-              }
-            }
-          }
-        }
-        
-        // Right column of current layer
-        for (int row = centerRow - layer + 1; row <= centerRow + layer && sequenceIndex < NUM_PIXELS; row++) {
-          if (row >= 0 && row < GRID_HEIGHT) {
-            uint8_t col = centerCol + layer;
-            if (col >= 0 && col < GRID_WIDTH) {
-              uint16_t pixelIndex = getPixelIndex(col, row);
-              if (pixelIndex < NUM_PIXELS) {
-                spiralSequence[sequenceIndex++] = pixelIndex;
-              }
-            }
-          }
-        }
-        
-        // Bottom row of current layer
-        for (int col = centerCol + layer - 1; col >= centerCol - layer && sequenceIndex < NUM_PIXELS; col--) {
-          if (col >= 0 && col < GRID_WIDTH) {
-            uint8_t row = centerRow + layer;
-            if (row >= 0 && row < GRID_HEIGHT) {
-              uint16_t pixelIndex = getPixelIndex(col, row);
-              if (pixelIndex < NUM_PIXELS) {
-                spiralSequence[sequenceIndex++] = pixelIndex;
-              }
-            }
-          }
-        }
-        
-        // Left column of current layer
-        for (int row = centerRow + layer - 1; row >= centerRow - layer + 1 && sequenceIndex < NUM_PIXELS; row--) {
-          if (row >= 0 && row < GRID_HEIGHT) {
-            uint8_t col = centerCol - layer;
-            if (col >= 0 && col < GRID_WIDTH) {
-              uint16_t pixelIndex = getPixelIndex(col, row);
-              if (pixelIndex < NUM_PIXELS) {
-                spiralSequence[sequenceIndex++] = pixelIndex;
-              }
-            }
-          }
-        }
-      }
-      sequenceInitialized = true;
-    }
-    
-    // Clear all pixels first
-    for (int i = 0; i < NUM_PIXELS; i++) {
-      pixels.setPixelColor(i, 0);
-    }
-    
-    // Light pixels according to the stable spiral sequence
-    for (int i = 0; i < pixelsToLight && i < NUM_PIXELS; i++) {
-      uint16_t pixelIndex = spiralSequence[i];
-      if (pixelIndex < NUM_PIXELS) {
-        // Use the current static color for the spiral
-        pixels.setPixelColor(pixelIndex, staticColor);
-      }
-    }
-    
-    pixels.show();
-    patternStep++;
-  }
-}
-
-// Function to create pulse effect
-void pulseEffect() {
-    static uint16_t baseHue = 0;
-    static bool initialized = false;
-    
-    if (!initialized) {
-        initialized = true;
-    }
-    
-    // Clear all pixels first
-    pixels.clear();
-    
-    // Draw 8 static rings at different distances from center
-    for (int col = 0; col < GRID_WIDTH; col++) {
-        for (int row = 0; row < GRID_HEIGHT; row++) {
-            // Calculate distance from center
-            float dx = col - (GRID_WIDTH - 1) / 2.0;
-            float dy = row - (GRID_HEIGHT - 1) / 2.0;
-            float distance = sqrt(dx * dx + dy * dy);
-            
-            // Check if this pixel should be lit by any of the 20 rings
-            for (int ring = 0; ring < 20; ring++) {
-                float ringRadius = ring * 1.5; // Fixed ring positions, 1.5 pixels apart
-                
-                if (abs(distance - ringRadius) < 0.2) {
-                    // Each ring has a hue offset by 1/20 of the full range
-                    // Reverse the order so rainbow goes from center outward
-                    uint16_t ringHue = (baseHue + ((19 - ring) * 3277)) % 65536; // 65536 / 20 = 3277
-                    uint32_t color = pixels.ColorHSV(ringHue, 255, 255);
-                    
-                    // Get the pixel index using the proper grid mapping
-                    uint16_t pixelIndex = getPixelIndex(col, row);
-                    pixels.setPixelColor(pixelIndex, color);
-                    break; // Only light by one ring
-                }
-            }
-        }
-    }
-    
-    // Increment base hue for all rings (creates the cycling effect)
-    baseHue = (baseHue + 300) % 65536; // Adjust speed by changing this value
-    
-    pixels.show();
-}
-
-// Helper function to get pattern name
-String getPatternName(uint8_t pattern) {
-  switch(pattern) {
-    case 0: return "Rainbow";
-    case 1: return "Static";
-    case 2: return "Wave";
-    case 3: return "Fire";
-    case 4: return "Matrix";
-    case 5: return "Spiral";
-    case 6: return "Pulse";
-    default: return "Unknown";
-  }
+  LOG_I("Setup complete");
 }
 
 void loop() {
+  frameMetrics.loopStarted(micros());
   unsigned long currentMillis = millis();
+  loopScheduler.begin(currentMillis);
   
-  // Handle web server and WebSocket requests (AP mode)
-  server.handleClient();
+  // Handle WebSocket requests (AP mode); HTTP is served by the async
+  // TCP task, which leaves its setting changes here and wakes the loop
   webSocket.loop();
+  processHttpCommands();
+  uint8_t webSocketClients = webSocket.connectedClients();
+  uint8_t stations = WiFi.softAPgetStationNum();
+  loopScheduler.pollNetwork(webSocketClients, stations);
   
-  // Status update every second
+#if LOG_LEVEL >= LOG_LEVEL_DEBUG
+  // Heap report every second
   static unsigned long lastStatusUpdate = 0;
   if (currentMillis - lastStatusUpdate >= 1000) {
     lastStatusUpdate = currentMillis;
     
-    Serial.printf("Mode: %s, Free Heap: %d bytes\n", 
-                  getPatternName(currentPattern),
-                  ESP.getFreeHeap());
+    LOG_D("Mode: %s, Free Heap: %d bytes",
+          getPatternName(patternEngine.currentIndex()),
+          ESP.getFreeHeap());
   }
+  loopScheduler.wakeAt(lastStatusUpdate + 1000);
+#endif
   
-  // Non-blocking pattern effects
-  if (currentMillis - previousPatternMillis >= (currentPattern == 6 ? 20 : patternInterval)) { // Even faster updates for pulse
-    previousPatternMillis = currentMillis;
-    
-    switch(currentPattern) {
-      case 0: // Rainbow
-        rainbowCycle();
-        break;
-      case 1: // Static
-        setStaticColor();
-        break;
-      case 2: // Wave
-        waveEffect();
-        break;
-      case 3: // Fire
-        fireEffect();
-        break;
-      case 4: // Matrix
-        matrixEffect();
-        break;
-      case 5: // Spiral
-        spiralEffect();
-        break;
-      case 6: // Pulse
-        pulseEffect();
-        break;
-    }
+  // Sample free heap and the largest free block (fragmentation) for /heap
+  if (heapHistory.due(currentMillis)) {
+    heapHistory.add({ (uint32_t)currentMillis, ESP.getFreeHeap(), ESP.getMaxAllocHeap() });
   }
+  loopScheduler.wakeAt(heapHistory.nextSampleMillis());
+  
+  // Send what changed to the WebSocket clients (rate limited), and the
+  // current frame to preview subscribers (dropped, never queued). Both
+  // only have clients while the network poll keeps the loop busy.
+  broadcastStatusChanges(currentMillis);
+  streamPreview(currentMillis);
   
   // Auto-cycle patterns if enabled
   if (autoCycleEnabled && currentMillis - lastAutoCycleMillis >= autoCycleInterval) {
     lastAutoCycleMillis = currentMillis;
-    currentPattern = (currentPattern + 1) % 7; // Cycle to next pattern
-    
-    Serial.print("Auto-cycled to pattern: ");
-    Serial.println(getPatternName(currentPattern));
-    
-    // Reset pattern step for new pattern
-    patternStep = 0;
-    waveOffset = 0;
-    
-    // Broadcast status update
-    broadcastStatus();
+    postRenderCommand(RENDER_NEXT_PATTERN); // Cycle to next pattern, restarting its animation
+    LOG_D("Auto-cycling to the next pattern");
+  }
+  if (autoCycleEnabled) {
+    loopScheduler.wakeAt(lastAutoCycleMillis + autoCycleInterval);
   }
   
-  // Periodic status broadcast to keep all clients synchronized
-  // This variable was removed, so it will cause a compilation error.
-  // Assuming it should be re-added or handled differently.
-  // For now, commenting out to avoid compilation errors.
-  // if (WiFi.status() == WL_CONNECTED && currentMillis - previousBroadcastMillis >= broadcastInterval) {
-  //   previousBroadcastMillis = currentMillis;
-  //   broadcastStatus();
-  // }
-  
-  // Check button state (toggle between rainbow and static mode)
+  // Check button state (toggle between rainbow and static mode); edges
+  // wake the loop, and it is read every few ms while held
   static bool buttonPressed = false;
   static unsigned long buttonPressTime = 0;
   
@@ -967,23 +1086,37 @@ void loop() {
   if (digitalRead(BUTTON_PIN) == HIGH && buttonPressed) {
     if (millis() - buttonPressTime < 50) { // Debounce
       // Short press - cycle through patterns
-      currentPattern = (currentPattern + 1) % 7; // 7 patterns total
-      
-      // Print the actual mode name
-      Serial.print("Pattern changed to: ");
-      Serial.println(getPatternName(currentPattern));
-      
-      // Reset pattern step for new pattern
-      patternStep = 0;
-      waveOffset = 0;
+      postRenderCommand(RENDER_NEXT_PATTERN); // Restarts the new pattern's animation
+      LOG_I("Button: next pattern");
     } else {
       // Long press - toggle brightness
       currentBrightness = (currentBrightness == 64) ? 128 : 64; // Toggle between 25% and 50%
-      pixels.setBrightness(currentBrightness);
-      Serial.printf("Brightness changed to: %d%%\n", (currentBrightness * 100) / 255);
+      postRenderCommand(RENDER_SET_BRIGHTNESS, currentBrightness);
+      preferenceCache.set(PREF_BRIGHTNESS, currentBrightness, millis());
+      LOG_I("Brightness changed to: %d%%", (currentBrightness * 100) / 255);
     }
     buttonPressed = false;
   }
+  if (buttonPressed) {
+    loopScheduler.wakeIn(LOOP_BUTTON_POLL);
+  }
+  
+  // Write changed settings to flash once they have stopped changing
+  // (after the button, which changes one)
+  if (preferenceCache.update(currentMillis)) {
+    LOG_I("Preferences saved to flash (%u commits, %u avoided)",
+          preferenceCache.commits, preferenceCache.commitsAvoided());
+  }
+  loopScheduler.wakeIn(preferenceCache.millisUntilCommit(currentMillis));
+  
+  // Power save once the LEDs have stopped changing and nobody is connected
+  loopScheduler.framesPushed(frameOutput.framesPushed, currentMillis);
+  updatePowerSave(loopScheduler.powerSaveAllowed(currentMillis, stations));
+  
+  // Print buffered log lines last, when nothing else is waiting
+  if (drainLogs()) {
+    loopScheduler.wakeIn(LOOP_LOG_RETRY);
+  }
   
-  delay(10); // Small delay to prevent watchdog issues
+  waitForNextDeadline();
 }
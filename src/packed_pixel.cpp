@@ -0,0 +1,90 @@
+/**
+ * Packed-pixel math on whole buffers
+ *
+ * Buffers are walked as runs of bytes, a word at a time, and words are
+ * loaded and stored with memcpy, so they need no particular alignment.
+ * Whole words come first, with a fixed-size copy the compiler turns into
+ * a plain load; a last, partly filled word has its unused lanes at 0.
+ */
+
+#include "packed_pixel.h"
+#include <string.h>
+
+static_assert(sizeof(Color16) == 3 * sizeof(uint16_t), "Color16 must be three packed channels");
+
+#define WORD_SIZE sizeof(uint64_t)
+
+static inline uint64_t loadWord(const void* bytes) {
+  uint64_t word;
+  memcpy(&word, bytes, WORD_SIZE);
+  return word;
+}
+
+static inline void storeWord(void* bytes, uint64_t word) {
+  memcpy(bytes, &word, WORD_SIZE);
+}
+
+static inline uint64_t loadPart(const void* bytes, uint16_t size) {
+  uint64_t word = 0;
+  memcpy(&word, bytes, size);
+  return word;
+}
+
+void scalePixels(Color16* pixels, uint16_t count, uint16_t scale) {
+  uint8_t* bytes = (uint8_t*)pixels;
+  uint16_t total = count * sizeof(Color16);
+  uint16_t i = 0;
+  for (; i + WORD_SIZE <= total; i += WORD_SIZE) {
+    storeWord(bytes + i, packedScale(loadWord(bytes + i), scale));
+  }
+  if (i < total) {
+    uint64_t word = packedScale(loadPart(bytes + i, total - i), scale);
+    memcpy(bytes + i, &word, total - i);
+  }
+}
+
+void fadePixels(Color16* pixels, uint16_t count, uint8_t amount) {
+  scalePixels(pixels, count, PIXEL_SCALE_ONE - amount);
+}
+
+void addPixels(Color16* pixels, const Color16* add, uint16_t count) {
+  uint8_t* bytes = (uint8_t*)pixels;
+  const uint8_t* added = (const uint8_t*)add;
+  uint16_t total = count * sizeof(Color16);
+  uint16_t i = 0;
+  for (; i + WORD_SIZE <= total; i += WORD_SIZE) {
+    storeWord(bytes + i, packedAdd(loadWord(bytes + i), loadWord(added + i)));
+  }
+  if (i < total) {
+    uint64_t word = packedAdd(loadPart(bytes + i, total - i), loadPart(added + i, total - i));
+    memcpy(bytes + i, &word, total - i);
+  }
+}
+
+void lerpPixels(const Color16* a, const Color16* b, Color16* out, uint16_t count, uint16_t alpha) {
+  const uint8_t* from = (const uint8_t*)a;
+  const uint8_t* to = (const uint8_t*)b;
+  uint8_t* bytes = (uint8_t*)out;
+  uint16_t total = count * sizeof(Color16);
+  uint16_t i = 0;
+  for (; i + WORD_SIZE <= total; i += WORD_SIZE) {
+    storeWord(bytes + i, packedLerp(loadWord(from + i), loadWord(to + i), alpha));
+  }
+  if (i < total) {
+    uint64_t word = packedLerp(loadPart(from + i, total - i), loadPart(to + i, total - i), alpha);
+    memcpy(bytes + i, &word, total - i);
+  }
+}
+
+void fadeBytes(uint8_t* values, const uint8_t* amounts, uint16_t count, uint16_t scale) {
+  uint16_t i = 0;
+  for (; i + WORD_SIZE <= count; i += WORD_SIZE) {
+    storeWord(values + i,
+              packedSubtractBytes(loadWord(values + i), packedScaleBytes(loadWord(amounts + i), scale)));
+  }
+  if (i < count) {
+    uint64_t word = packedSubtractBytes(loadPart(values + i, count - i),
+                                        packedScaleBytes(loadPart(amounts + i, count - i), scale));
+    memcpy(values + i, &word, count - i);
+  }
+}
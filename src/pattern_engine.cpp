@@ -0,0 +1,167 @@
+/**
+ * Pattern engine: pattern objects and the frame scheduler
+ */
+
+#include "pattern_engine.h"
+#include "patterns.h"
+#include "packed_pixel.h"
+
+AllocSite renderAllocs("render");
+
+void PatternEngine::select(uint8_t index) {
+  if (index >= count) {
+    return;
+  }
+  if (index != current) {
+    if (transitionMillis > 0 && scheduled) {
+      // The outgoing pattern carries on from what is shown (a blend, if
+      // this interrupts another transition)
+      outgoing = current;
+      outgoingFrame = frames[front()];
+      incomingFrame.clear();
+      transitionStarted = false;
+    } else {
+      outgoing = NO_TRANSITION;
+      backFrame().clear();
+      publish();
+    }
+    current = index;
+    patterns[current]->reset();
+  }
+  framePending = true;
+}
+
+void PatternEngine::next() {
+  uint8_t index = current;
+  do {
+    index = (index + 1) % count;
+  } while (!patterns[index]->inCycle() && index != current);
+  select(index);
+}
+
+void PatternEngine::restart() {
+  outgoing = NO_TRANSITION;
+  backFrame().clear();
+  publish();
+  patterns[current]->reset();
+  framePending = true;
+}
+
+uint16_t PatternEngine::frameInterval() const {
+  if (outgoing == NO_TRANSITION || !transitionStarted) {
+    return patterns[current]->frameInterval;
+  }
+  uint32_t outgoingDue = outgoingMillis + patterns[outgoing]->frameInterval;
+  uint32_t incomingDue = incomingMillis + patterns[current]->frameInterval;
+  uint32_t due = (int32_t)(outgoingDue - incomingDue) < 0 ? outgoingDue : incomingDue;
+  return due - lastFrameMillis;
+}
+
+void PatternEngine::renderPattern(Pattern& pattern, Frame& frame) {
+  uint32_t start = micros();
+  uint32_t renderStart = metricsCycles();
+  pattern.render(frame);
+  pattern.renderTime.record(metricsNanos(metricsCycles() - renderStart));
+  uint32_t elapsed = micros() - start;
+
+  pattern.frameCount++;
+  pattern.lastRenderMicros = elapsed;
+  if (elapsed > pattern.maxRenderMicros) {
+    pattern.maxRenderMicros = elapsed;
+  }
+  // Exponential moving average with a weight of 1/8
+  pattern.averageRenderMicros = pattern.frameCount == 1
+    ? elapsed
+    : pattern.averageRenderMicros - (pattern.averageRenderMicros >> 3) + (elapsed >> 3);
+}
+
+void PatternEngine::renderTransition(uint32_t nowMillis, Frame& out) {
+  Pattern& from = *patterns[outgoing];
+  Pattern& to = *patterns[current];
+  bool first = !transitionStarted;
+  if (first) {
+    transitionStarted = true;
+    transitionStart = nowMillis;
+  }
+
+  // Each layer advances at its own frame rate
+  if (first || nowMillis - outgoingMillis >= from.frameInterval) {
+    outgoingMillis = nowMillis;
+    renderPattern(from, outgoingFrame);
+  }
+  if (first || nowMillis - incomingMillis >= to.frameInterval) {
+    incomingMillis = nowMillis;
+    renderPattern(to, incomingFrame);
+  }
+
+  uint32_t elapsed = nowMillis - transitionStart;
+  if (elapsed >= transitionMillis) {
+    // Done: the incoming pattern carries on from its own frame
+    out = incomingFrame;
+    outgoing = NO_TRANSITION;
+    return;
+  }
+  uint16_t alpha = elapsed * COLOR16_ALPHA_ONE / transitionMillis;
+  lerpPixels(outgoingFrame.pixel, incomingFrame.pixel, out.pixel, NUM_PIXELS, alpha);
+}
+
+bool PatternEngine::update(uint32_t nowMillis) {
+  uint16_t interval = frameInterval();
+  if (!framePending && nowMillis - lastFrameMillis < interval) {
+    return false;
+  }
+  AllocScope scope(renderAllocs);
+
+  // Frames forced by a command are not late; neither is the first one
+  uint32_t startMicros = micros();
+  if (!framePending && scheduled) {
+    frameMetrics.frameScheduled(startMicros - lastFrameMicros, interval);
+  }
+  frameMetrics.frameStarted(nowMillis);
+  lastFrameMillis = nowMillis;
+  lastFrameMicros = startMicros;
+  framePending = false;
+  scheduled = true;
+
+  // Patterns draw on top of the previous frame
+  Frame& back = backFrame();
+  if (outgoing != NO_TRANSITION) {
+    renderTransition(nowMillis, back);
+  } else {
+    back = frames[front()];
+    renderPattern(*patterns[current], back);
+  }
+
+  publish();
+  frameOutput.present(frames[front()]);
+  return true;
+}
+
+Frame& PatternEngine::backFrame() {
+  // The back buffer was shown until the last swap: a reader still copying
+  // it must see the counter move before any of the new pixels
+  std::atomic_thread_fence(std::memory_order_release);
+  return frames[front() ^ 1];
+}
+
+void PatternEngine::publish() {
+  framesPublished.store(framesPublished.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+void PatternEngine::copyFrame(Frame& out) const {
+  uint32_t published;
+  do {
+    published = framesPublished.load(std::memory_order_acquire);
+    out = frames[published & 1];
+    std::atomic_thread_fence(std::memory_order_acquire);
+  } while (framesPublished.load(std::memory_order_relaxed) != published);
+}
+
+uint32_t PatternEngine::millisUntilNextFrame(uint32_t nowMillis) const {
+  uint32_t elapsed = nowMillis - lastFrameMillis;
+  uint16_t interval = frameInterval();
+  if (framePending || elapsed >= interval) {
+    return 0;
+  }
+  return interval - elapsed;
+}
@@ -0,0 +1,538 @@
+/**
+ * LED patterns for the lithophane grid
+ *
+ * Each pattern keeps its own animation state and renders one frame into
+ * the engine's Frame per render() call.
+ */
+
+#include "patterns.h"
+#include "color_engine.h"
+#include "pixel_layout.h"
+#include "ddp_receiver.h"
+#include "animation.h"
+#include "log_buffer.h"
+#include "packed_pixel.h"
+
+uint32_t staticColor = 0xFF0000;     // Static color (default red)
+
+// Rainbow: all pixels same color, cycling through the hue wheel
+class RainbowPattern : public Pattern {
+public:
+  RainbowPattern() : Pattern("Rainbow", "rainbow", 50) {}
+
+  void reset() override {
+    hue = 0;
+  }
+
+  void render(Frame& frame) override {
+    // Convert current hue to RGB color
+    Color16 color = colorHSVGamma16(hue);
+    
+    // Set all pixels to the same color
+    for (int i = 0; i < NUM_PIXELS; i++) {
+      frame.pixel[i] = color;
+    }
+    
+    // Increment hue for next cycle (wraps at 65536)
+    hue += 256;
+  }
+
+private:
+  uint16_t hue = 0;
+};
+
+// Static: every pixel shows staticColor. Nothing animates, so a slow
+// refresh is enough; color changes request an immediate frame.
+class StaticPattern : public Pattern {
+public:
+  StaticPattern() : Pattern("Static", "static", 1000) {}
+
+  void render(Frame& frame) override {
+    frame.fill(color16(staticColor));
+  }
+};
+
+// Wave: rainbow traveling right to left with a slow brightness wave
+class WavePattern : public Pattern {
+public:
+  WavePattern() : Pattern("Wave", "wave", 50) {}
+
+  void reset() override {
+    offset = 0;
+    step = 0;
+  }
+
+  void render(Frame& frame) override {
+    // Debug output every 50 frames
+    if (step % 50 == 0) {
+      LOG_D("Wave: offset %d, step %d", offset, step);
+    }
+    
+    // Add some wave variation based on row for more dynamic effect:
+    // sin(row * 0.5deg + offset * 0.1deg) only depends on the row,
+    // so look it up once per row in tenths of a degree
+    uint8_t rowValue[GRID_HEIGHT];
+    for (int row = 0; row < GRID_HEIGHT; row++) {
+      int32_t wave = isin16(decidegreesToAngle(row * 5 + offset));
+      rowValue[row] = (200 * SIN_ONE + wave * 55) / SIN_ONE; // Vary brightness slightly with wave
+    }
+    
+    const PixelLayout& layout = pixelLayout();
+    for (int col = 0; col < GRID_WIDTH; col++) {
+      for (int row = 0; row < GRID_HEIGHT; row++) {
+        uint16_t pixelIndex = layout.pixelAt[col][row];
+        
+        // Create rainbow effect that travels right to left
+        // Calculate hue based on column position and time
+        uint16_t hue = ((offset * 300) - (col * 10922)) % 65536; // Faster movement, reverse direction
+        
+        // Debug first few pixels every 50 frames
+        if (step % 50 == 0 && col < 3 && row == 0) {
+          LOG_D("Wave col %d: hue=%d, offset=%d", col, hue, offset);
+        }
+        
+        uint8_t saturation = 255; // Full saturation for vibrant colors
+        uint8_t value = rowValue[row];
+        
+        Color16 color = colorHSVGamma16(hue, saturation, value);
+        frame.pixel[pixelIndex] = color;
+      }
+    }
+    
+    offset++;
+    step++;
+  }
+
+private:
+  uint16_t offset = 0;  // Animation time in frames
+  uint8_t step = 0;     // Frame counter for debug output
+};
+
+#define FIRE_COOLING        57    // Max heat lost per cell per frame (of 255)
+#define FIRE_SPARKING       120   // Chance (of 256) per column per frame of a new spark
+#define FIRE_SPARK_ROWS     2     // Sparks start in the bottom rows
+#define FIRE_SPARK_MIN_HEAT 160
+
+// Fire: a cellular heat simulation. Every frame each cell cools by a
+// random amount, heat drifts upward as a weighted average of the cells
+// below, and random sparks heat the bottom rows. The heat (0-255) picks
+// a color from a palette built once: black, red, yellow, then white.
+class FirePattern : public Pattern {
+public:
+  FirePattern() : Pattern("Fire", "fire", 50) {
+    buildPalette();
+  }
+
+  void reset() override {
+    memset(heat, 0, sizeof(heat));
+  }
+
+  void render(Frame& frame) override {
+    // Every random byte of the frame in one call: one per cell for
+    // cooling (in heat's order), then three per column for the spark
+    uint8_t noise[NUM_PIXELS + 3 * GRID_WIDTH];
+    rng.fill(noise, sizeof(noise));
+    const uint8_t* next = noise + NUM_PIXELS;
+
+    // Cool every cell a little, eight cells per packed operation
+    fadeBytes(&heat[0][0], noise, NUM_PIXELS, FIRE_COOLING + 1);
+
+    for (uint8_t col = 0; col < GRID_WIDTH; col++) {
+      uint8_t* column = heat[col];
+
+      // Heat drifts up: (below + 2 * two below) / 3, top down so each
+      // cell still sees last frame's values below it
+      for (uint8_t h = GRID_HEIGHT - 1; h >= 2; h--) {
+        column[h] = ((column[h - 1] + 2 * column[h - 2]) * 85) >> 8;
+      }
+
+      // Sometimes a new spark near the bottom
+      const uint8_t* spark = next;
+      next += 3;
+      if (spark[0] < FIRE_SPARKING) {
+        uint8_t h = spark[1] % FIRE_SPARK_ROWS;
+        uint16_t sum = column[h] + FIRE_SPARK_MIN_HEAT +
+                       ((spark[2] * (256 - FIRE_SPARK_MIN_HEAT)) >> 8);
+        column[h] = sum > 255 ? 255 : sum;
+      }
+
+      // h counts up from the bottom row
+      const uint16_t* pixelAt = pixelLayout().pixelAt[col];
+      for (uint8_t h = 0; h < GRID_HEIGHT; h++) {
+        frame.pixel[pixelAt[GRID_HEIGHT - 1 - h]] = palette[column[h]];
+      }
+    }
+  }
+
+private:
+  uint8_t heat[GRID_WIDTH][GRID_HEIGHT] = {};   // Column-major, bottom row first
+  Color16 palette[256] = {};
+
+  // Heat -> color in thirds: red rises, then green (to yellow), then
+  // blue (to white), each through the 16-bit gamma
+  void buildPalette() {
+    for (uint16_t h = 0; h < 256; h++) {
+      uint16_t t = h * 3;   // 0-765, one 0-255 ramp per third
+      uint16_t r = t < 256 ? t : 255;
+      uint16_t g = t < 256 ? 0 : t < 512 ? t - 256 : 255;
+      uint16_t b = t < 512 ? 0 : t - 512;
+      palette[h] = { gamma16(r * 257), gamma16(g * 257), gamma16(b * 257) };
+    }
+  }
+};
+
+#define MATRIX_SPAWN_CHANCE 15    // % chance per frame that an idle column starts a drop
+#define MATRIX_MIN_SPEED    96    // Rows per frame, 8.8 fixed point (0.375)
+#define MATRIX_MAX_SPEED    256   // 1 row per frame
+#define MATRIX_MIN_TRAIL    3     // Lit rows behind and including the head
+#define MATRIX_MAX_TRAIL    7
+
+// Matrix: falling green "code" drops, one per column. Each column keeps
+// its drop as state (head row in 8.8 fixed point, speed, trail length),
+// so a frame is one write-only pass over the grid: nothing is read back
+// from the frame, and the fading trail does not depend on what was shown.
+class MatrixPattern : public Pattern {
+public:
+  MatrixPattern() : Pattern("Matrix", "matrix", 50) {}
+
+  void reset() override {
+    for (MatrixDrop& drop : drops) {
+      drop.active = false;
+    }
+  }
+
+  void render(Frame& frame) override {
+    for (uint8_t col = 0; col < GRID_WIDTH; col++) {
+      MatrixDrop& drop = drops[col];
+      if (drop.active) {
+        drop.head += drop.speed;
+        // Gone once the end of its trail has left the bottom row
+        drop.active = drop.head < (int32_t)(GRID_HEIGHT + drop.trail) << 8;
+      } else if (rng.below(100) < MATRIX_SPAWN_CHANCE) {
+        drop.active = true;
+        drop.head = 0;
+        drop.speed = rng.between(MATRIX_MIN_SPEED, MATRIX_MAX_SPEED + 1);
+        drop.trail = rng.between(MATRIX_MIN_TRAIL, MATRIX_MAX_TRAIL + 1);
+      }
+      renderColumn(frame, col, drop);
+    }
+  }
+
+private:
+  struct MatrixDrop {
+    int32_t head;     // Row of the head, 8.8 fixed point
+    uint16_t speed;   // Rows per frame, 8.8 fixed point
+    uint8_t trail;    // Rows lit from the head up
+    bool active;
+  };
+
+  MatrixDrop drops[GRID_WIDTH] = {};
+
+  // Every cell of the column: full at the head, fading linearly up the
+  // trail, dark elsewhere. The fractional head position lights the
+  // leading cell partially, so slow drops move smoothly.
+  static void renderColumn(Frame& frame, uint8_t col, const MatrixDrop& drop) {
+    uint32_t fadePerRow = drop.active ? COLOR16_ONE / drop.trail : 0;
+    int32_t trailEnd = (int32_t)drop.trail << 8;
+    const uint16_t* pixelAt = pixelLayout().pixelAt[col];
+    for (uint8_t row = 0; row < GRID_HEIGHT; row++) {
+      Color16& cell = frame.pixel[pixelAt[row]];
+      int32_t distance = drop.head - ((int32_t)row << 8);   // 8.8 rows above the head
+      if (!drop.active || distance <= -256 || distance >= trailEnd) {
+        cell = {};
+        continue;
+      }
+      uint32_t level = distance < 0 ? (uint32_t)(256 + distance) * COLOR16_ONE >> 8
+                                    : COLOR16_ONE - ((uint32_t)distance * fadePerRow >> 8);
+      uint16_t green = gamma16(level);
+      // The head is a paler green than its trail
+      uint16_t tint = distance < 256 ? green >> 2 : 0;
+      cell = { tint, green, tint };
+    }
+  }
+};
+
+// Spiral: staticColor expanding from the center, then contracting
+class SpiralPattern : public Pattern {
+public:
+  SpiralPattern() : Pattern("Spiral", "spiral", 50) {
+    buildSequence();
+  }
+
+  void reset() override {
+    step = 0;
+  }
+
+  void render(Frame& frame) override {
+    // Calculate total pixels in the spiral and current pixel to light
+    uint8_t totalPixels = NUM_PIXELS; // Use actual number of pixels in grid
+    
+    // Create expanding/contracting effect
+    uint8_t currentPixel = step % (totalPixels * 2); // *2 for expand + contract cycle
+    
+    // Determine if we're expanding or contracting
+    bool isExpanding = currentPixel < totalPixels;
+    
+    // For expanding: light pixels 0, 1, 2, 3, ...
+    // For contracting: light pixels totalPixels-1, totalPixels-2, totalPixels-3, ..., 0
+    uint8_t pixelsToLight;
+    if (isExpanding) {
+      pixelsToLight = currentPixel;
+    } else {
+      // Contracting phase - reverse the order
+      pixelsToLight = totalPixels - 1 - (currentPixel - totalPixels);
+    }
+    
+    // Debug output every 50 frames
+    if (step % 50 == 0) {
+      LOG_D("Spiral: step=%d, currentPixel=%d, isExpanding=%s, pixelsToLight=%d, totalPixels=%d",
+            step, currentPixel, isExpanding ? "true" : "false", pixelsToLight, totalPixels);
+    }
+    
+    // Clear all pixels first
+    frame.clear();
+    
+    // Light pixels according to the stable spiral sequence
+    Color16 color = color16(staticColor);
+    const PixelLayout& layout = pixelLayout();
+    for (int i = 0; i < pixelsToLight && i < NUM_PIXELS; i++) {
+      const SpiralCell &cell = spiralSequence[i];
+      // Use the current static color for the spiral
+      frame.pixel[layout.pixelAt[cell.col][cell.row]] = color;
+    }
+    
+    step++;
+  }
+
+private:
+  // Spiral order of grid cells, mapped to strip indices through the
+  // active layout when rendering
+  struct SpiralCell {
+    uint8_t col;
+    uint8_t row;
+  };
+
+  SpiralCell spiralSequence[NUM_PIXELS] = {};
+  uint8_t step = 0;
+
+  void buildSequence() {
+    uint8_t centerCol = GRID_WIDTH / 2;
+    uint8_t centerRow = GRID_HEIGHT / 2;
+    
+    // Generate the spiral sequence once, properly ordered from center outward
+    uint8_t sequenceIndex = 0;
+    
+    // Start from center and spiral outward
+    for (int layer = 0; layer <= max(GRID_WIDTH, GRID_HEIGHT) && sequenceIndex < NUM_PIXELS; layer++) {
+      // Top row of current layer
+      for (int col = centerCol - layer; col <= centerCol + layer && sequenceIndex < NUM_PIXELS; col++) {
+        if (col >= 0 && col < GRID_WIDTH) {
+          uint8_t row = centerRow - layer;
+          if (row >= 0 && row < GRID_HEIGHT) {
+            spiralSequence[sequenceIndex++] = {(uint8_t)col, (uint8_t)row};
+          }
+        }
+      }
+      
+      // Right column of current layer
+      for (int row = centerRow - layer + 1; row <= centerRow + layer && sequenceIndex < NUM_PIXELS; row++) {
+        if (row >= 0 && row < GRID_HEIGHT) {
+          uint8_t col = centerCol + layer;
+          if (col >= 0 && col < GRID_WIDTH) {
+            spiralSequence[sequenceIndex++] = {(uint8_t)col, (uint8_t)row};
+          }
+        }
+      }
+      
+      // Bottom row of current layer
+      for (int col = centerCol + layer - 1; col >= centerCol - layer && sequenceIndex < NUM_PIXELS; col--) {
+        if (col >= 0 && col < GRID_WIDTH) {
+          uint8_t row = centerRow + layer;
+          if (row >= 0 && row < GRID_HEIGHT) {
+            spiralSequence[sequenceIndex++] = {(uint8_t)col, (uint8_t)row};
+          }
+        }
+      }
+      
+      // Left column of current layer
+      for (int row = centerRow + layer - 1; row >= centerRow - layer + 1 && sequenceIndex < NUM_PIXELS; row--) {
+        if (row >= 0 && row < GRID_HEIGHT) {
+          uint8_t col = centerCol - layer;
+          if (col >= 0 && col < GRID_WIDTH) {
+            spiralSequence[sequenceIndex++] = {(uint8_t)col, (uint8_t)row};
+          }
+        }
+      }
+    }
+  }
+};
+
+// Pulse rings: 20 fixed rings 1.5 pixels apart, a cell is lit when its
+// distance from the grid center is within 0.2 of a ring radius.
+#define PULSE_RINGS         20
+#define PULSE_RING_HUE_STEP 3277  // 65536 / 20
+#define PULSE_NO_RING       0xFF
+
+struct PulseCell {
+  uint8_t col;
+  uint8_t row;
+  uint16_t hueOffset;   // Ring hue relative to the cycling base hue
+};
+
+struct PulseRingMap {
+  uint8_t ring[GRID_WIDTH][GRID_HEIGHT];  // Ring index or PULSE_NO_RING
+  PulseCell lit[NUM_PIXELS];              // Only the cells on a ring
+  uint8_t litCount;
+};
+
+// |distance - ring * 1.5| < 0.2, scaled by 10 and squared so it stays in
+// integers: (15 * ring - 2)^2 < 25 * d4 < (15 * ring + 2)^2, where d4 is
+// four times the squared distance (the grid center sits on half pixels).
+static constexpr PulseRingMap buildPulseRingMap() {
+  PulseRingMap map = {};
+  for (int col = 0; col < GRID_WIDTH; col++) {
+    for (int row = 0; row < GRID_HEIGHT; row++) {
+      int dx2 = 2 * col - (GRID_WIDTH - 1);
+      int dy2 = 2 * row - (GRID_HEIGHT - 1);
+      int scaled = 25 * (dx2 * dx2 + dy2 * dy2);
+
+      map.ring[col][row] = PULSE_NO_RING;
+      for (int ring = 0; ring < PULSE_RINGS; ring++) {
+        int inner = 15 * ring - 2;
+        int outer = 15 * ring + 2;
+        if (scaled < outer * outer && (inner < 0 || scaled > inner * inner)) {
+          map.ring[col][row] = ring;
+          // Reverse the order so rainbow goes from center outward
+          map.lit[map.litCount++] = {(uint8_t)col, (uint8_t)row,
+                                     (uint16_t)((PULSE_RINGS - 1 - ring) * PULSE_RING_HUE_STEP)};
+          break; // Only light by one ring
+        }
+      }
+    }
+  }
+  return map;
+}
+
+static constexpr PulseRingMap pulseRingMap = buildPulseRingMap();
+
+// Pulse: rainbow rings around the grid center, cycling outward
+class PulsePattern : public Pattern {
+public:
+  PulsePattern() : Pattern("Pulse", "pulse", 20) {}
+
+  void reset() override {
+    baseHue = 0;
+  }
+
+  void render(Frame& frame) override {
+    // Clear all pixels first
+    frame.clear();
+    
+    // Draw the precomputed ring cells, each ring offset by 1/20 of the hue wheel
+    const PixelLayout& layout = pixelLayout();
+    for (uint8_t i = 0; i < pulseRingMap.litCount; i++) {
+      const PulseCell &cell = pulseRingMap.lit[i];
+      uint16_t ringHue = baseHue + cell.hueOffset; // Wraps at 65536
+      frame.pixel[layout.pixelAt[cell.col][cell.row]] = color16(colorHSV(ringHue, 255, 255));
+    }
+    
+    // Increment base hue for all rings (creates the cycling effect)
+    baseHue += 300; // Adjust speed by changing this value
+  }
+
+private:
+  uint16_t baseHue = 0;
+};
+
+// External: frames streamed from a host over UDP (DDP), see ddp_receiver.h
+class ExternalPattern : public Pattern {
+public:
+  ExternalPattern() : Pattern("External", "external", DDP_POLL_INTERVAL) {}
+
+  // Only shown when selected, there may be no sender
+  bool inCycle() const override { return false; }
+
+  void reset() override {
+    // The socket is opened the first time the pattern is selected,
+    // when the network is up; stale frames are dropped
+    if (!ddpReceiver.isOpen()) {
+      ddpReceiver.begin(DDP_PORT);
+    }
+    ddpReceiver.flush();
+  }
+
+  void render(Frame& frame) override {
+    uint32_t now = millis();
+    ddpReceiver.poll(now);
+    ddpReceiver.play(now, frame);
+  }
+};
+
+// Animation: frames decoded from the animation file (see animation.h)
+class AnimationPattern : public Pattern {
+public:
+  AnimationPattern() : Pattern("Animation", "animation", ANIMATION_TICK) {}
+
+  // Only cycled to when there is a file to play
+  bool inCycle() const override { return animationSource != nullptr; }
+
+  void reset() override {
+    player.open(animationSource);
+    started = false;
+  }
+
+  void render(Frame& frame) override {
+    // The file sets the frame rate; the engine polls at ANIMATION_TICK
+    uint32_t now = millis();
+    if (!player.isOpen() || (started && now - lastFrameMillis < player.header().frameInterval)) {
+      return;
+    }
+    started = true;
+    lastFrameMillis = now;
+    player.nextFrame(frame);
+  }
+
+private:
+  AnimationPlayer player;
+  bool started = false;
+  uint32_t lastFrameMillis = 0;
+};
+
+// Pattern registry, in PatternId order
+static RainbowPattern rainbowPattern;
+static StaticPattern staticPattern;
+static WavePattern wavePattern;
+static FirePattern firePattern;
+static MatrixPattern matrixPattern;
+static SpiralPattern spiralPattern;
+static PulsePattern pulsePattern;
+static ExternalPattern externalPattern;
+static AnimationPattern animationPattern;
+
+static Pattern* const patternRegistry[PATTERN_COUNT] = {
+  &rainbowPattern,
+  &staticPattern,
+  &wavePattern,
+  &firePattern,
+  &matrixPattern,
+  &spiralPattern,
+  &pulsePattern,
+  &externalPattern,
+  &animationPattern,
+};
+
+PatternEngine patternEngine(patternRegistry, PATTERN_COUNT, PATTERN_WAVE);
+
+Pattern& getPattern(uint8_t index) {
+  return *patternRegistry[index];
+}
+
+void seedPatterns(uint32_t seed) {
+  for (uint8_t i = 0; i < PATTERN_COUNT; i++) {
+    patternRegistry[i]->rng.seed(seed + i * RANDOM_GOLDEN_GAMMA);
+  }
+}
+
+const char* getPatternName(uint8_t index) {
+  return index < PATTERN_COUNT ? patternRegistry[index]->name : "Unknown";
+}
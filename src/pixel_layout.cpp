@@ -0,0 +1,97 @@
+/**
+ * Pixel layout mapping between grid cells and strip positions
+ */
+
+#include "pixel_layout.h"
+#include <string.h>
+
+static constexpr PixelLayout builtinLayouts[] = {
+  makeGridLayout<GRID_WIDTH, GRID_HEIGHT>(LAYOUT_COLUMN_SERPENTINE),
+  makeGridLayout<GRID_WIDTH, GRID_HEIGHT>(LAYOUT_ROW_SERPENTINE),
+  makeGridLayout<GRID_WIDTH, GRID_HEIGHT>(LAYOUT_ROW_MAJOR),
+};
+
+static const char* const layoutNames[LAYOUT_COUNT] = {
+  "column_serpentine",
+  "row_serpentine",
+  "row_major",
+  "custom",
+};
+
+// Default wiring: serpentine columns, down then up, left to right
+std::atomic<const PixelLayout*> activePixelLayout(&builtinLayouts[LAYOUT_COLUMN_SERPENTINE]);
+
+// Custom maps alternate between two tables, so loading one never
+// rewrites the table that is active
+static PixelLayout customLayouts[2];
+static std::atomic<const PixelLayout*> loadedCustomLayout(nullptr);
+
+bool selectPixelLayout(PixelLayoutType type) {
+  const PixelLayout* layout = type == LAYOUT_CUSTOM ? loadedCustomLayout.load(std::memory_order_acquire)
+                            : type < LAYOUT_CUSTOM  ? &builtinLayouts[type]
+                            : nullptr;
+  if (layout == nullptr) {
+    return false;
+  }
+  activePixelLayout.store(layout, std::memory_order_release);
+  return true;
+}
+
+bool parsePixelLayout(const char* text, size_t length) {
+  PixelLayout layout = {};
+  bool used[NUM_PIXELS] = {};
+  uint16_t cell = 0;
+  size_t i = 0;
+
+  layout.type = LAYOUT_CUSTOM;
+  while (i < length) {
+    char c = text[i];
+    if (c == '#') {
+      // Comment runs to the end of the line
+      while (i < length && text[i] != '\n') i++;
+    } else if (c >= '0' && c <= '9') {
+      uint32_t pixel = 0;
+      while (i < length && text[i] >= '0' && text[i] <= '9') {
+        pixel = pixel * 10 + (text[i] - '0');
+        if (pixel >= NUM_PIXELS) return false;
+        i++;
+      }
+      if (cell >= NUM_PIXELS || used[pixel]) return false;
+      used[pixel] = true;
+
+      // Cells are listed row by row
+      uint8_t col = cell % GRID_WIDTH;
+      uint8_t row = cell / GRID_WIDTH;
+      layout.pixelAt[col][row] = pixel;
+      layout.cellPixel[cell] = pixel;
+      cell++;
+    } else if (c == ' ' || c == ',' || c == '\t' || c == '\r' || c == '\n') {
+      i++;
+    } else {
+      return false;
+    }
+  }
+
+  if (cell != NUM_PIXELS) {
+    return false;
+  }
+  PixelLayout* target = &customLayouts[0] == activePixelLayout.load(std::memory_order_acquire)
+                      ? &customLayouts[1] : &customLayouts[0];
+  *target = layout;
+  loadedCustomLayout.store(target, std::memory_order_release);
+  return true;
+}
+
+const char* getLayoutName(uint8_t type) {
+  return type < LAYOUT_COUNT ? layoutNames[type] : "unknown";
+}
+
+bool getLayoutType(const char* name, PixelLayoutType* type) {
+  for (uint8_t i = 0; i < LAYOUT_COUNT; i++) {
+    if (strcmp(name, layoutNames[i]) == 0) {
+      *type = (PixelLayoutType)i;
+      return true;
+    }
+  }
+  return false;
+}
@@ -0,0 +1,16 @@
+/**
+ * Write-behind cache over the Preferences (NVS) store
+ */
+
+#include "preference_cache.h"
+#include "pixel_layout.h"
+
+// Keys match what earlier firmware versions saved
+const PreferenceSpec preferenceSpecs[PREF_COUNT] = {
+  { "brightness",   PREF_TYPE_U8,   64 },
+  { "autoCycle",    PREF_TYPE_BOOL, false },
+  { "autoCycleInt", PREF_TYPE_U32,  6000 },   // 6 seconds
+  { "staticColor",  PREF_TYPE_U32,  0xFF0000 },
+  { "layout",       PREF_TYPE_U8,   LAYOUT_COLUMN_SERPENTINE },
+  { "transitionMs", PREF_TYPE_U32,  800 },    // Crossfade between patterns
+};
@@ -0,0 +1,60 @@
+/**
+ * Commands from the web handlers to the renderer
+ */
+
+#include "render_commands.h"
+#include "patterns.h"
+#include "pixel_layout.h"
+
+RenderCommandQueue renderCommands;
+std::atomic<uint32_t> renderCommandsApplied(0);
+
+void applyRenderCommand(const RenderCommand& command) {
+  switch (command.type) {
+    case RENDER_SELECT_PATTERN:
+      patternEngine.select(command.value);
+      break;
+
+    case RENDER_NEXT_PATTERN:
+      patternEngine.next();
+      break;
+
+    case RENDER_SET_COLOR:
+      staticColor = command.value & 0xFFFFFF;
+      if (patternEngine.currentIndex() != PATTERN_SPIRAL) {
+        patternEngine.select(PATTERN_STATIC);
+      }
+      patternEngine.requestFrame();
+      break;
+
+    case RENDER_SET_BRIGHTNESS:
+      frameOutput.setBrightness(command.value);
+      patternEngine.requestFrame();
+      break;
+
+    case RENDER_SET_LAYOUT:
+      if (selectPixelLayout((PixelLayoutType)command.value)) {
+        // Patterns that keep state in the frame buffer must start over
+        patternEngine.restart();
+      }
+      break;
+
+    case RENDER_SET_TRANSITION:
+      patternEngine.setTransition(command.value);
+      break;
+
+    default:
+      break;
+  }
+  renderCommandsApplied.fetch_add(1, std::memory_order_release);
+}
+
+uint8_t processRenderCommands() {
+  RenderCommand command;
+  uint8_t applied = 0;
+  while (renderCommands.pop(command)) {
+    applyRenderCommand(command);
+    applied++;
+  }
+  return applied;
+}
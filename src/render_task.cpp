@@ -0,0 +1,46 @@
+/**
+ * FreeRTOS task that renders and shows the patterns
+ */
+
+#include "render_task.h"
+#include "patterns.h"
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+static TaskHandle_t renderTaskHandle = NULL;
+
+uint32_t renderCommandsPosted = 0;
+uint32_t renderCommandsDropped = 0;
+
+static void renderTask(void* parameter) {
+  for (;;) {
+    processRenderCommands();
+    patternEngine.update(millis());
+
+    // Sleep until the next frame is due; a posted command wakes us early
+    uint32_t waitMillis = patternEngine.millisUntilNextFrame(millis());
+    if (waitMillis > 0) {
+      ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(waitMillis));
+    }
+  }
+}
+
+void startRenderTask() {
+  if (renderTaskHandle != NULL) {
+    return;
+  }
+  xTaskCreate(renderTask, "render", RENDER_TASK_STACK, NULL, RENDER_TASK_PRIORITY, &renderTaskHandle);
+}
+
+bool postRenderCommand(RenderCommandType type, uint32_t value) {
+  RenderCommand command = { type, value };
+  if (!renderCommands.push(command)) {
+    renderCommandsDropped++;
+    return false;
+  }
+  renderCommandsPosted++;
+  if (renderTaskHandle != NULL) {
+    xTaskNotifyGive(renderTaskHandle);
+  }
+  return true;
+}
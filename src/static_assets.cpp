@@ -0,0 +1,63 @@
+/**
+ * Static web assets: gzipped files, ETags and a RAM hot set
+ */
+
+#include "static_assets.h"
+#include <stdio.h>
+#include <string.h>
+
+StaticAsset staticAssets[] = {
+  { "/", "/index.html.gz", "/index.html", "text/html", true },
+};
+
+const uint8_t staticAssetCount = sizeof(staticAssets) / sizeof(staticAssets[0]);
+
+StaticAsset* findStaticAsset(const char* uri) {
+  for (uint8_t i = 0; i < staticAssetCount; i++) {
+    if (strcmp(staticAssets[i].uri, uri) == 0) {
+      return &staticAssets[i];
+    }
+  }
+  return nullptr;
+}
+
+uint32_t assetHashUpdate(uint32_t hash, const uint8_t* data, size_t size) {
+  // FNV-1a
+  for (size_t i = 0; i < size; i++) {
+    hash = (hash ^ data[i]) * 16777619u;
+  }
+  return hash;
+}
+
+void formatAssetETag(uint32_t hash, size_t size, char* etag) {
+  snprintf(etag, ASSET_ETAG_SIZE, "\"%08x-%x\"", (unsigned)hash, (unsigned)size);
+}
+
+void makeAssetETag(const uint8_t* data, size_t size, char* etag) {
+  formatAssetETag(assetHashUpdate(ASSET_HASH_INIT, data, size), size, etag);
+}
+
+bool etagMatches(const char* ifNoneMatch, const char* etag) {
+  size_t etagLength = strlen(etag);
+  const char* p = ifNoneMatch;
+
+  // Comma-separated list of (possibly weak) tags, or "*"
+  while (*p != '\0') {
+    while (*p == ' ' || *p == ',') p++;
+    if (*p == '*') {
+      return true;
+    }
+    if (p[0] == 'W' && p[1] == '/') {
+      p += 2; // Weak comparison is fine for If-None-Match
+    }
+    const char* end = p;
+    while (*end != '\0' && *end != ',') end++;
+    const char* last = end;
+    while (last > p && last[-1] == ' ') last--;
+    if ((size_t)(last - p) == etagLength && strncmp(p, etag, etagLength) == 0) {
+      return true;
+    }
+    p = end;
+  }
+  return false;
+}
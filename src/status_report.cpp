@@ -0,0 +1,135 @@
+/**
+ * Controller status as JSON, written into fixed buffers
+ */
+
+#include "status_report.h"
+#include "patterns.h"
+#include <string.h>
+
+// Appends to a fixed buffer; stops writing (and flags overflow) when full
+struct JsonWriter {
+  char* buffer;
+  size_t size;
+  size_t length;
+  bool overflow;
+
+  void text(const char* s) {
+    size_t n = strlen(s);
+    if (length + n >= size) {
+      overflow = true;
+      return;
+    }
+    memcpy(buffer + length, s, n);
+    length += n;
+  }
+
+  void number(uint32_t value) {
+    char digits[10];
+    uint8_t count = 0;
+    do {
+      digits[count++] = '0' + value % 10;
+      value /= 10;
+    } while (value != 0);
+    if (length + count >= size) {
+      overflow = true;
+      return;
+    }
+    while (count > 0) {
+      buffer[length++] = digits[--count];
+    }
+  }
+
+  // "#RRGGBB"
+  void hexColor(uint32_t color) {
+    static const char hex[] = "0123456789ABCDEF";
+    if (length + 9 >= size) {
+      overflow = true;
+      return;
+    }
+    buffer[length++] = '"';
+    buffer[length++] = '#';
+    for (int shift = 20; shift >= 0; shift -= 4) {
+      buffer[length++] = hex[(color >> shift) & 0xF];
+    }
+    buffer[length++] = '"';
+  }
+};
+
+uint8_t diffStatus(const StatusState& a, const StatusState& b) {
+  uint8_t fields = 0;
+  if (a.pattern != b.pattern) fields |= STATUS_PATTERN;
+  if (a.staticColor != b.staticColor) fields |= STATUS_COLOR;
+  if (a.brightness != b.brightness) fields |= STATUS_BRIGHTNESS;
+  if (a.autoCycle != b.autoCycle) fields |= STATUS_AUTO_CYCLE;
+  if (a.autoCycleInterval != b.autoCycleInterval) fields |= STATUS_AUTO_CYCLE_INTERVAL;
+  return fields;
+}
+
+size_t writeStatusJson(char* buffer, size_t size, const StatusState& state,
+                       uint8_t fields, uint32_t version) {
+  JsonWriter out = { buffer, size, 0, false };
+
+  out.text("{\"type\":\"status\",\"version\":");
+  out.number(version);
+  if (fields & STATUS_PATTERN) {
+    out.text(",\"mode\":\"");
+    out.text(getPatternName(state.pattern));
+    out.text("\",\"pattern\":");
+    out.number(state.pattern);
+  }
+  if (fields & STATUS_COLOR) {
+    out.text(",\"color\":");
+    out.hexColor(state.staticColor);
+  }
+  if (fields & STATUS_BRIGHTNESS) {
+    out.text(",\"brightness\":");
+    out.number(state.brightness);
+  }
+  if (fields & STATUS_AUTO_CYCLE) {
+    out.text(state.autoCycle ? ",\"autoCycle\":true" : ",\"autoCycle\":false");
+  }
+  if (fields & STATUS_AUTO_CYCLE_INTERVAL) {
+    out.text(",\"autoCycleInterval\":");
+    out.number(state.autoCycleInterval);
+  }
+  if (fields & STATUS_FRAMES) {
+    out.text(",\"framesRendered\":");
+    out.number(state.framesRendered);
+    out.text(",\"framesPushed\":");
+    out.number(state.framesPushed);
+  }
+  out.text("}");
+
+  if (out.overflow) {
+    return 0;
+  }
+  buffer[out.length] = '\0';
+  return out.length;
+}
+
+size_t StatusBroadcaster::poll(const StatusState& state, uint32_t nowMillis,
+                               char* buffer, size_t size) {
+  uint8_t fields = hasSent ? diffStatus(state, sent) : STATUS_SETTINGS;
+  if (fields == 0) {
+    return 0;
+  }
+  if (hasSent && nowMillis - lastSentMillis < minInterval) {
+    pollsDeferred++;
+    return 0;
+  }
+
+  size_t length = writeStatusJson(buffer, size, state, fields, version + 1);
+  if (length == 0) {
+    return 0;
+  }
+  version++;
+  messagesSent++;
+  sent = state;
+  hasSent = true;
+  lastSentMillis = nowMillis;
+  return length;
+}
+
+size_t StatusBroadcaster::snapshot(const StatusState& state, char* buffer, size_t size) const {
+  return writeStatusJson(buffer, size, state, STATUS_SETTINGS, version);
+}
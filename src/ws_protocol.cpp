@@ -0,0 +1,244 @@
+/**
+ * WebSocket command protocol
+ */
+
+#include "ws_protocol.h"
+#include "patterns.h"
+#include <string.h>
+
+// Payload bytes after the header, by opcode
+static const uint8_t payloadSize[WS_OP_COUNT] = {
+  0,  // WS_OP_INVALID
+  1,  // WS_OP_SELECT_PATTERN
+  0,  // WS_OP_NEXT
+  3,  // WS_OP_COLOR
+  1,  // WS_OP_BRIGHTNESS
+  0,  // WS_OP_STATUS
+  0,  // WS_OP_AUTO_CYCLE
+  4,  // WS_OP_AUTO_CYCLE_INTERVAL
+  1,  // WS_OP_LAYOUT
+  1,  // WS_OP_PREVIEW
+  2,  // WS_OP_TRANSITION
+};
+
+// JSON command names other than the pattern keys
+static const struct {
+  const char* name;
+  uint8_t opcode;
+} jsonCommands[] = {
+  { "next", WS_OP_NEXT },
+  { "color", WS_OP_COLOR },
+  { "brightness", WS_OP_BRIGHTNESS },
+  { "status", WS_OP_STATUS },
+  { "autoCycle", WS_OP_AUTO_CYCLE },
+  { "autoCycleInterval", WS_OP_AUTO_CYCLE_INTERVAL },
+  { "layout", WS_OP_LAYOUT },
+  { "preview", WS_OP_PREVIEW },
+  { "transition", WS_OP_TRANSITION },
+};
+
+bool decodeBinaryCommand(const uint8_t* data, size_t length, WsCommand& command) {
+  if (length < WS_HEADER_SIZE || data[0] != WS_PROTOCOL_VERSION) {
+    return false;
+  }
+  uint8_t opcode = data[1];
+  if (opcode == WS_OP_INVALID || opcode >= WS_OP_COUNT ||
+      length != (size_t)WS_HEADER_SIZE + payloadSize[opcode]) {
+    return false;
+  }
+
+  const uint8_t* payload = data + WS_HEADER_SIZE;
+  command.opcode = opcode;
+  switch (payloadSize[opcode]) {
+    case 1:
+      command.value = payload[0];
+      break;
+    case 2:
+      command.value = payload[0] | ((uint32_t)payload[1] << 8);
+      break;
+    case 3:
+      command.value = ((uint32_t)payload[0] << 16) | ((uint32_t)payload[1] << 8) | payload[2];
+      break;
+    case 4:
+      command.value = payload[0] | ((uint32_t)payload[1] << 8) |
+                      ((uint32_t)payload[2] << 16) | ((uint32_t)payload[3] << 24);
+      break;
+    default:
+      command.value = 0;
+      break;
+  }
+  return true;
+}
+
+size_t encodeBinaryCommand(const WsCommand& command, uint8_t* buffer, size_t size) {
+  if (command.opcode == WS_OP_INVALID || command.opcode >= WS_OP_COUNT) {
+    return 0;
+  }
+  size_t length = WS_HEADER_SIZE + payloadSize[command.opcode];
+  if (size < length) {
+    return 0;
+  }
+
+  buffer[0] = WS_PROTOCOL_VERSION;
+  buffer[1] = command.opcode;
+  uint8_t* payload = buffer + WS_HEADER_SIZE;
+  switch (payloadSize[command.opcode]) {
+    case 1:
+      payload[0] = command.value;
+      break;
+    case 2:
+      payload[0] = command.value;
+      payload[1] = command.value >> 8;
+      break;
+    case 3:
+      payload[0] = command.value >> 16;
+      payload[1] = command.value >> 8;
+      payload[2] = command.value;
+      break;
+    case 4:
+      payload[0] = command.value;
+      payload[1] = command.value >> 8;
+      payload[2] = command.value >> 16;
+      payload[3] = command.value >> 24;
+      break;
+  }
+  return length;
+}
+
+// Portion of the input text, not null-terminated
+struct TextSpan {
+  const char* start;
+  size_t length;
+};
+
+static bool spanEquals(const TextSpan& span, const char* text) {
+  return strncmp(span.start, text, span.length) == 0 && text[span.length] == '\0';
+}
+
+static bool isJsonSpace(char c) {
+  return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+// Value of a decimal ("128") or hex ("FF8800") span; false on other characters
+static bool spanToNumber(const TextSpan& span, uint8_t base, uint32_t& value) {
+  if (span.length == 0 || span.length > (base == 16 ? 8u : 9u)) {
+    return false;
+  }
+  value = 0;
+  for (size_t i = 0; i < span.length; i++) {
+    char c = span.start[i];
+    uint8_t digit;
+    if (c >= '0' && c <= '9') {
+      digit = c - '0';
+    } else if (base == 16 && (c | 0x20) >= 'a' && (c | 0x20) <= 'f') {
+      digit = (c | 0x20) - 'a' + 10;
+    } else {
+      return false;
+    }
+    value = value * base + digit;
+  }
+  return true;
+}
+
+// Scan a string starting at its opening quote; leaves pos after the closing quote
+static bool scanString(const char* text, size_t length, size_t& pos, TextSpan& span) {
+  pos++; // Opening quote
+  span.start = text + pos;
+  while (pos < length && text[pos] != '"') {
+    pos += (text[pos] == '\\') ? 2 : 1; // Skip escaped characters
+  }
+  if (pos >= length) {
+    return false;
+  }
+  span.length = text + pos - span.start;
+  pos++; // Closing quote
+  return true;
+}
+
+bool parseJsonCommand(const char* text, size_t length, WsCommand& command) {
+  TextSpan name = { nullptr, 0 };
+  TextSpan value = { nullptr, 0 };
+  size_t pos = 0;
+
+  // {"key": value, ...}, one pass over the text
+  while (pos < length && isJsonSpace(text[pos])) pos++;
+  if (pos >= length || text[pos++] != '{') {
+    return false;
+  }
+  for (;;) {
+    while (pos < length && isJsonSpace(text[pos])) pos++;
+    if (pos < length && text[pos] == '}') {
+      break;
+    }
+
+    TextSpan key;
+    if (pos >= length || text[pos] != '"' || !scanString(text, length, pos, key)) {
+      return false;
+    }
+    while (pos < length && isJsonSpace(text[pos])) pos++;
+    if (pos >= length || text[pos++] != ':') {
+      return false;
+    }
+    while (pos < length && isJsonSpace(text[pos])) pos++;
+
+    TextSpan field;
+    if (pos < length && text[pos] == '"') {
+      if (!scanString(text, length, pos, field)) {
+        return false;
+      }
+    } else {
+      // Number or literal, up to the next separator
+      field.start = text + pos;
+      while (pos < length && text[pos] != ',' && text[pos] != '}' && !isJsonSpace(text[pos])) pos++;
+      field.length = text + pos - field.start;
+      if (field.length == 0) {
+        return false;
+      }
+    }
+
+    if (spanEquals(key, "command")) {
+      name = field;
+    } else if (spanEquals(key, "value")) {
+      value = field;
+    }
+
+    while (pos < length && isJsonSpace(text[pos])) pos++;
+    if (pos < length && text[pos] == ',') {
+      pos++;
+    } else if (pos >= length || text[pos] != '}') {
+      return false;
+    }
+  }
+
+  if (name.start == nullptr) {
+    return false;
+  }
+
+  command.value = 0;
+  for (uint8_t i = 0; i < PATTERN_COUNT; i++) {
+    if (spanEquals(name, getPattern(i).key)) {
+      command.opcode = WS_OP_SELECT_PATTERN;
+      command.value = i;
+      return true;
+    }
+  }
+  for (const auto& entry : jsonCommands) {
+    if (!spanEquals(name, entry.name)) {
+      continue;
+    }
+    command.opcode = entry.opcode;
+    switch (entry.opcode) {
+      case WS_OP_COLOR:
+        return spanToNumber(value, 16, command.value) && command.value <= 0xFFFFFF;
+      case WS_OP_BRIGHTNESS:
+      case WS_OP_AUTO_CYCLE_INTERVAL:
+      case WS_OP_LAYOUT:
+      case WS_OP_PREVIEW:
+      case WS_OP_TRANSITION:
+        return spanToNumber(value, 10, command.value);
+      default:
+        return true;
+    }
+  }
+  return false;
+}
@@ -0,0 +1,133 @@
+"""
+Convert frames to a stored animation for the Animation pattern
+
+Reads a GIF, a folder of images (with Pillow installed), or raw RGB
+frames (width * height * 3 bytes each, row by row from the top left),
+and writes data/animation.lani in the format described in
+include/animation.h. Frames are stored as changes from the previous
+frame with run-length encoding; upload with `pio run -t uploadfs`.
+
+    python tools/animation_converter.py clip.gif
+    python tools/animation_converter.py frames/ --interval 40
+    python tools/animation_converter.py clip.rgb --raw --interval 33
+"""
+
+import argparse
+import os
+import struct
+import sys
+
+GRID_WIDTH = 6    # Must match include/grid.h
+GRID_HEIGHT = 10
+CELLS = GRID_WIDTH * GRID_HEIGHT
+
+VERSION = 1
+FLAG_LOOP = 0x01
+RECORD_KEYFRAME = 0x01
+OP_LITERAL = 0x00
+OP_RUN = 0x40
+OP_SKIP = 0x80
+MAX_COUNT = 64
+
+
+def encode_frame(previous, cells, keyframe):
+    """One record; same greedy choice of tokens as encodeAnimationFrame()"""
+    out = bytearray()
+    i = 0
+    while i < CELLS:
+        n = 1
+        if not keyframe and cells[i] == previous[i]:
+            while i + n < CELLS and n < MAX_COUNT and cells[i + n] == previous[i + n]:
+                n += 1
+            out.append(OP_SKIP | (n - 1))
+        else:
+            while i + n < CELLS and n < MAX_COUNT and cells[i + n] == cells[i]:
+                n += 1
+            if n > 1:
+                out.append(OP_RUN | (n - 1))
+                out += bytes(cells[i])
+            else:
+                while (i + n < CELLS and n < MAX_COUNT and
+                       (keyframe or cells[i + n] != previous[i + n]) and
+                       (i + n + 1 >= CELLS or cells[i + n + 1] != cells[i + n])):
+                    n += 1
+                out.append(OP_LITERAL | (n - 1))
+                for k in range(n):
+                    out += bytes(cells[i + k])
+        i += n
+    return struct.pack("<BH", RECORD_KEYFRAME if keyframe else 0, len(out)) + out
+
+
+def fit_image(image):
+    """Grid cells of one image, scaled to the grid"""
+    image = image.convert("RGB").resize((GRID_WIDTH, GRID_HEIGHT))
+    return [tuple(image.getpixel((col, row))) for row in range(GRID_HEIGHT) for col in range(GRID_WIDTH)]
+
+
+def read_images(path):
+    """(frames, frame interval from the GIF or None)"""
+    try:
+        from PIL import Image, ImageSequence
+    except ImportError:
+        sys.exit("Pillow is needed for images (pip install pillow); use --raw otherwise")
+
+    if os.path.isdir(path):
+        names = sorted(n for n in os.listdir(path) if not n.startswith("."))
+        return [fit_image(Image.open(os.path.join(path, n))) for n in names], None
+
+    image = Image.open(path)
+    frames = [fit_image(frame) for frame in ImageSequence.Iterator(image)]
+    return frames, image.info.get("duration")
+
+
+def read_raw(path):
+    with open(path, "rb") as f:
+        data = f.read()
+    size = CELLS * 3
+    if len(data) == 0 or len(data) % size != 0:
+        sys.exit("%s: %d bytes is not a whole number of %d-byte frames" % (path, len(data), size))
+    return [[tuple(data[offset + c * 3:offset + c * 3 + 3]) for c in range(CELLS)]
+            for offset in range(0, len(data), size)]
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.strip().splitlines()[0])
+    parser.add_argument("input", help="GIF, image folder, or raw RGB file (--raw)")
+    parser.add_argument("-o", "--output", default=os.path.join("data", "animation.lani"))
+    parser.add_argument("--raw", action="store_true", help="input is raw RGB frames")
+    parser.add_argument("--interval", type=int, help="ms per frame (default: from the GIF, else 50)")
+    parser.add_argument("--keyframe-interval", type=int, default=0,
+                        help="frames between keyframes (default: first frame only)")
+    parser.add_argument("--no-loop", action="store_true", help="stop on the last frame")
+    args = parser.parse_args()
+
+    if args.raw:
+        frames, duration = read_raw(args.input), None
+    else:
+        frames, duration = read_images(args.input)
+    if not frames:
+        sys.exit("%s: no frames" % args.input)
+    interval = args.interval or duration or 50
+    if not 1 <= interval <= 0xFFFF:
+        sys.exit("frame interval must be 1-65535 ms")
+
+    flags = 0 if args.no_loop else FLAG_LOOP
+    out = bytearray(b"LANI")
+    out += struct.pack("<BBBBHHI", VERSION, GRID_WIDTH, GRID_HEIGHT, flags, interval,
+                       args.keyframe_interval, len(frames))
+    previous = [(0, 0, 0)] * CELLS
+    for index, cells in enumerate(frames):
+        keyframe = index == 0 or (args.keyframe_interval and index % args.keyframe_interval == 0)
+        out += encode_frame(previous, cells, keyframe)
+        previous = cells
+
+    with open(args.output, "wb") as f:
+        f.write(out)
+    raw = len(frames) * CELLS * 3
+    print("Wrote %s: %d frames, %.1f s, %d bytes (%.1f bytes/frame, %.0f%% of raw RGB)" % (
+        args.output, len(frames), len(frames) * interval / 1000.0, len(out),
+        (len(out) - 16) / float(len(frames)), 100.0 * len(out) / raw))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,37 @@
+"""
+Gzip the web UI for the LittleFS image (PlatformIO pre-script)
+
+Every file in web/ is written to data/<name>.gz, which the firmware
+serves with Content-Encoding: gzip. The gzip header carries no file name
+or timestamp, so unchanged sources produce identical bytes and the ETag
+the firmware derives from them stays stable across builds.
+"""
+
+import gzip
+import os
+
+Import("env")  # noqa: F821 (provided by PlatformIO)
+
+PROJECT_DIR = env.subst("$PROJECT_DIR")  # noqa: F821
+SOURCE_DIR = os.path.join(PROJECT_DIR, "web")
+DATA_DIR = env.subst("$PROJECT_DATA_DIR")  # noqa: F821
+
+
+def compress_assets():
+    for name in sorted(os.listdir(SOURCE_DIR)):
+        source = os.path.join(SOURCE_DIR, name)
+        target = os.path.join(DATA_DIR, name + ".gz")
+        if not os.path.isfile(source):
+            continue
+        if os.path.exists(target) and os.path.getmtime(target) >= os.path.getmtime(source):
+            continue
+
+        with open(source, "rb") as f:
+            raw = f.read()
+        with open(target, "wb") as f:
+            with gzip.GzipFile(filename="", mode="wb", fileobj=f, compresslevel=9, mtime=0) as gz:
+                gz.write(raw)
+        print("Compressed %s: %d -> %d bytes" % (name, len(raw), os.path.getsize(target)))
+
+
+compress_assets()